@@ -0,0 +1,61 @@
+uniform sampler2D Texture1;
+uniform sampler2D Texture2;
+uniform int TextureWidth;
+
+/*
+ * Convert from NV12 to RGB.
+ *
+ * This is used by MovieTexture_Generic.  Texture1 holds the luma plane, four
+ * samples to an RGBA texel.  Texture2 holds the chroma plane at half height,
+ * with U and V interleaved, so each texel holds the chroma for the same four
+ * pixels as the luma texel at the same coordinate.  Both textures are
+ * TextureWidth texels wide, and the output is TextureWidth*4 texels wide.
+ */
+void main(void)
+{
+	vec4 tex = gl_TexCoord[0];
+
+	float fRealWidth = float(TextureWidth);
+
+	/* Scale U to the output pixel, [0,fRealWidth*4). */
+	float fPixel = tex.x * fRealWidth * 4.0 - 0.5;
+
+	/* Find the texel containing this pixel, and which of its four samples
+	 * this is. */
+	float fTexel = floor( (fPixel+0.0001) / 4.0 );
+	float fSample = fPixel - fTexel*4.0;
+
+	/* Sample the center of the texel, so neighboring samples are never
+	 * blended horizontally.  Chroma is still filtered vertically. */
+	tex.x = (fTexel + 0.5) / fRealWidth;
+
+	vec4 luma = texture2D( Texture1, tex.xy );
+	vec4 chroma = texture2D( Texture2, tex.xy );
+
+	vec3 yuv;
+	if( fSample < 0.5 )
+		yuv.x = luma.r;
+	else if( fSample < 1.5 )
+		yuv.x = luma.g;
+	else if( fSample < 2.5 )
+		yuv.x = luma.b;
+	else
+		yuv.x = luma.a;
+
+	if( fSample < 1.5 )
+		yuv.yz = chroma.rg;
+	else
+		yuv.yz = chroma.ba;
+	yuv -= vec3(16.0/255.0, 128.0/255.0, 128.0/255.0);
+
+	mat3 conv = mat3(
+		// Y     U (Cb)    V (Cr)
+		1.1643,  0.000,    1.5958,  // R
+		1.1643, -0.39173, -0.81290, // G
+		1.1643,  2.017,    0.000);  // B
+
+	gl_FragColor.r=dot(yuv,conv[0]);
+	gl_FragColor.g=dot(yuv,conv[1]);
+	gl_FragColor.b=dot(yuv,conv[2]);
+	gl_FragColor.a = 1.0;
+}
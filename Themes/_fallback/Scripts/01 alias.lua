@@ -148,6 +148,7 @@ EffectMode = {
 	Overlay			= 'EffectMode_Overlay',
 	Screen			= 'EffectMode_Screen',
 	YUYV422			= 'EffectMode_YUYV422',
+	NV12			= 'EffectMode_NV12',
 }
 
 -- Health Declarations
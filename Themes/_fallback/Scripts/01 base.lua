@@ -1,19 +1,7 @@
--- Override Lua's loadfile to use lua.ReadFile.
+-- Override Lua's loadfile to use lua.LoadFile, which reads through
+-- StepMania's filesystem and the bytecode cache.
 function loadfile(file)
-	local data, err = lua.ReadFile(file)
-	if not data then
-		return nil, ("what " .. file)
-	end
-
-	local chunk, err = load(
-		function()
-			local ret = data
-			data = nil
-			return ret
-		end,
-		"@" .. file
-	);
-
+	local chunk, err = lua.LoadFile(file)
 	if not chunk then return nil, err end
 
 	-- Set the environment, like loadfile does.
@@ -13,13 +13,16 @@
 #include "LightsManager.h" // for NUM_CabinetLight
 #include "ActorUtil.h"
 #include "Preference.h"
+#include "RageUtil_SlabAllocator.h"
 
 #include <cmath>
 #include <cstddef>
+#include <cstring>
 #include <typeinfo>
 #include <vector>
 
 static Preference<bool> g_bShowMasks("ShowMasks", false);
+static Preference<bool> g_bCullOffScreenActors("CullOffScreenActors", true);
 static const float default_effect_period= 1.0f;
 
 /**
@@ -168,6 +171,8 @@ Actor::Actor()
 	m_pParent = nullptr;
 	m_FakeParent= nullptr;
 	m_bFirstUpdate = true;
+	m_bUpdateClean = false;
+	m_bLocalMatrixValid = false;
 	m_tween_uses_effect_delta= false;
 }
 
@@ -215,6 +220,8 @@ Actor::Actor( const Actor &cpy ):
 		m_Tweens.push_back( new TweenStateAndInfo(*cpy.m_Tweens[i]) );
 
 	CPY( m_bFirstUpdate );
+	m_bUpdateClean = false;
+	m_bLocalMatrixValid = false;
 
 	CPY( m_fHorizAlign );
 	CPY( m_fVertAlign );
@@ -257,7 +264,7 @@ Actor::Actor( const Actor &cpy ):
 	CPY( m_fZBias );
 	CPY( m_CullMode );
 
-	CPY( m_mapNameToCommands );
+	CPY( m_vCommands );
 #undef CPY
 }
 
@@ -289,6 +296,8 @@ Actor &Actor::operator=(Actor other)
 	SWAP( m_Tweens );
 
 	SWAP( m_bFirstUpdate );
+	MarkUpdateDirty();
+	m_bLocalMatrixValid = false;
 
 	SWAP( m_fHorizAlign );
 	SWAP( m_fVertAlign );
@@ -329,7 +338,7 @@ Actor &Actor::operator=(Actor other)
 	SWAP( m_fZBias );
 	SWAP( m_CullMode );
 
-	SWAP( m_mapNameToCommands );
+	SWAP( m_vCommands );
 #undef SWAP
 	return *this;
 }
@@ -670,71 +679,63 @@ void Actor::PreDraw() // calculate actor properties
 	}
 }
 
-void Actor::BeginDraw() // set the world matrix
+void Actor::UpdateLocalMatrix( const TweenState &ts )
 {
-	DISPLAY->PushMatrix();
-
-	if( m_pTempState->pos.x != 0 || m_pTempState->pos.y != 0 || m_pTempState->pos.z != 0 )
+	// handle alignment; most actors have default alignment.
+	float fAlignX = 0, fAlignY = 0;
+	if( unlikely(m_fHorizAlign != 0.5f || m_fVertAlign != 0.5f) )
 	{
-		RageMatrix m;
-		RageMatrixTranslate(
-			&m,
-			m_pTempState->pos.x,
-			m_pTempState->pos.y,
-			m_pTempState->pos.z
-			);
-		DISPLAY->PreMultMatrix( m );
+		fAlignX = SCALE( m_fHorizAlign, 0.0f, 1.0f, +m_size.x/2.0f, -m_size.x/2.0f );
+		fAlignY = SCALE( m_fVertAlign, 0.0f, 1.0f, +m_size.y/2.0f, -m_size.y/2.0f );
 	}
 
+	/* The only time rotation and quat should normally be used simultaneously
+	 * is for m_baseRotation. */
+	const float fInputs[NUM_LOCAL_MATRIX_INPUTS] =
 	{
-		/* The only time rotation and quat should normally be used simultaneously
-		 * is for m_baseRotation. Most objects aren't rotated at all, so optimize
-		 * that case. */
-		const float fRotateX = m_pTempState->rotation.x + m_baseRotation.x;
-		const float fRotateY = m_pTempState->rotation.y + m_baseRotation.y;
-		const float fRotateZ = m_pTempState->rotation.z + m_baseRotation.z;
-
-		if( fRotateX != 0 || fRotateY != 0 || fRotateZ != 0 )
-		{
-			RageMatrix m;
-			RageMatrixRotationXYZ( &m, fRotateX, fRotateY, fRotateZ );
-			DISPLAY->PreMultMatrix( m );
-		}
-	}
+		ts.pos.x, ts.pos.y, ts.pos.z,
+		ts.rotation.x + m_baseRotation.x, ts.rotation.y + m_baseRotation.y, ts.rotation.z + m_baseRotation.z,
+		ts.scale.x * m_baseScale.x, ts.scale.y * m_baseScale.y, ts.scale.z * m_baseScale.z,
+		fAlignX, fAlignY,
+		ts.fSkewX, ts.fSkewY
+	};
+	if( m_bLocalMatrixValid && memcmp(fInputs, m_fLocalMatrixInputs, sizeof(fInputs)) == 0 )
+		return;
+	memcpy( m_fLocalMatrixInputs, fInputs, sizeof(fInputs) );
+	m_bLocalMatrixValid = true;
+
+	/* Each step is multiplied on the right, as PreMultMatrix would.  Most
+	 * actors aren't rotated, scaled or skewed at all, so skip the identities. */
+	RageMatrixIdentity( &m_LocalMatrix );
+	m_bLocalMatrixIsIdentity = true;
+	RageMatrix m;
+#define APPLY_LOCAL(make) { make; RageMatrixMultiply( &m_LocalMatrix, &m_LocalMatrix, &m ); m_bLocalMatrixIsIdentity = false; }
+	if( fInputs[0] != 0 || fInputs[1] != 0 || fInputs[2] != 0 )
+		APPLY_LOCAL( RageMatrixTranslate(&m, fInputs[0], fInputs[1], fInputs[2]) );
+	if( fInputs[3] != 0 || fInputs[4] != 0 || fInputs[5] != 0 )
+		APPLY_LOCAL( RageMatrixRotationXYZ(&m, fInputs[3], fInputs[4], fInputs[5]) );
+	if( fInputs[6] != 1 || fInputs[7] != 1 || fInputs[8] != 1 )
+		APPLY_LOCAL( RageMatrixScale(&m, fInputs[6], fInputs[7], fInputs[8]) );
+	if( fAlignX != 0 || fAlignY != 0 )
+		APPLY_LOCAL( RageMatrixTranslate(&m, fAlignX, fAlignY, 0) );
+	if( ts.fSkewX != 0 )
+		APPLY_LOCAL( RageMatrixSkewX(&m, ts.fSkewX) );
+	if( ts.fSkewY != 0 )
+		APPLY_LOCAL( RageMatrixSkewY(&m, ts.fSkewY) );
+#undef APPLY_LOCAL
+}
 
-	// handle scaling
-	{
-		const float fScaleX = m_pTempState->scale.x * m_baseScale.x;
-		const float fScaleY = m_pTempState->scale.y * m_baseScale.y;
-		const float fScaleZ = m_pTempState->scale.z * m_baseScale.z;
+void Actor::BeginDraw() // set the world matrix
+{
+	DISPLAY->PushMatrix();
 
-		if( fScaleX != 1 || fScaleY != 1 || fScaleZ != 1 )
-		{
-			RageMatrix m;
-			RageMatrixScale(
-				&m,
-				fScaleX,
-				fScaleY,
-				fScaleZ );
-			DISPLAY->PreMultMatrix( m );
-		}
-	}
-
-	// handle alignment; most actors have default alignment.
-	if( unlikely(m_fHorizAlign != 0.5f || m_fVertAlign != 0.5f) )
-	{
-		float fX = SCALE( m_fHorizAlign, 0.0f, 1.0f, +m_size.x/2.0f, -m_size.x/2.0f );
-		float fY = SCALE( m_fVertAlign, 0.0f, 1.0f, +m_size.y/2.0f, -m_size.y/2.0f );
-		RageMatrix m;
-		RageMatrixTranslate(
-			&m,
-			fX,
-			fY,
-			0
-			);
-		DISPLAY->PreMultMatrix( m );
-	}
+	UpdateLocalMatrix( *m_pTempState );
+	if( !m_bLocalMatrixIsIdentity )
+		DISPLAY->PreMultMatrix( m_LocalMatrix );
 
+	/* The quaternion is multiplied in world space, so it can't be part of the
+	 * local matrix.  Applying it after the skews gives the same result as
+	 * applying it before them. */
 	if( m_pTempState->quat.x != 0 ||  m_pTempState->quat.y != 0 ||  m_pTempState->quat.z != 0 || m_pTempState->quat.w != 1 )
 	{
 		RageMatrix mat;
@@ -743,23 +744,80 @@ void Actor::BeginDraw() // set the world matrix
 		DISPLAY->MultMatrix(mat);
 	}
 
-	// handle skews
-	if( m_pTempState->fSkewX != 0 )
+	if( m_texTranslate.x != 0 || m_texTranslate.y != 0 )
 	{
-		DISPLAY->SkewX( m_pTempState->fSkewX );
+		DISPLAY->TexturePushMatrix();
+		DISPLAY->TextureTranslate( m_texTranslate.x, m_texTranslate.y );
 	}
 
-	if( m_pTempState->fSkewY != 0 )
+}
+
+/* Whether every corner of r lands outside the same edge of the clip volume. */
+static bool IsRectOutsideClip( const RageMatrix &mat, const RectF &r )
+{
+	const RageVector4 corners[4] =
+	{
+		RageVector4( r.left, r.top, 0, 1 ),
+		RageVector4( r.left, r.bottom, 0, 1 ),
+		RageVector4( r.right, r.bottom, 0, 1 ),
+		RageVector4( r.right, r.top, 0, 1 ),
+	};
+
+	int iLeft = 0, iRight = 0, iBelow = 0, iAbove = 0;
+	for( const RageVector4 &corner : corners )
 	{
-		DISPLAY->SkewY( m_pTempState->fSkewY );
+		RageVector4 v;
+		RageVec4TransformCoord( &v, &corner, &mat );
+		// Behind the camera; don't try to be clever.
+		if( v.w <= 0 )
+			return false;
+		if( v.x < -v.w ) ++iLeft;
+		if( v.x > +v.w ) ++iRight;
+		if( v.y < -v.w ) ++iBelow;
+		if( v.y > +v.w ) ++iAbove;
 	}
+	return iLeft == 4 || iRight == 4 || iBelow == 4 || iAbove == 4;
+}
 
-	if( m_texTranslate.x != 0 || m_texTranslate.y != 0 )
+bool Actor::IsOffScreen( const RageMatrix &matViewProj, const RageMatrix &matParentWorld )
+{
+	if( !g_bCullOffScreenActors )
+		return false;
+
+	/* Effects, wrappers and fake parents all move the actor after this would
+	 * look at it. */
+	if( m_Effect != no_effect || !m_WrapperStates.empty() || m_FakeParent != nullptr || m_bClearZBuffer )
+		return false;
+	const TweenState &ts = m_current;
+	if( ts.quat.x != 0 || ts.quat.y != 0 || ts.quat.z != 0 || ts.quat.w != 1 )
+		return false;
+
+	RectF rect;
+	if( !GetDrawBounds(rect) )
+		return false;
+
+	UpdateLocalMatrix( ts );
+	RageMatrix matWorld = matParentWorld;
+	if( !m_bLocalMatrixIsIdentity )
+		RageMatrixMultiply( &matWorld, &matParentWorld, &m_LocalMatrix );
+
+	RageMatrix mat;
+	RageMatrixMultiply( &mat, &matViewProj, &matWorld );
+	if( !IsRectOutsideClip(mat, rect) )
+		return false;
+
+	// The shadow is offset in world space.
+	if( m_fShadowLengthX != 0 || m_fShadowLengthY != 0 )
 	{
-		DISPLAY->TexturePushMatrix();
-		DISPLAY->TextureTranslate( m_texTranslate.x, m_texTranslate.y );
+		RageMatrix matShadow;
+		RageMatrixTranslate( &matShadow, m_fShadowLengthX, m_fShadowLengthY, 0 );
+		RageMatrixMultiply( &matShadow, &matShadow, &matWorld );
+		RageMatrixMultiply( &mat, &matViewProj, &matShadow );
+		if( !IsRectOutsideClip(mat, rect) )
+			return false;
 	}
 
+	return true;
 }
 
 void Actor::SetGlobalRenderStates()
@@ -830,9 +888,11 @@ void Actor::UpdateTweening( float fDeltaTime )
 		TI.m_fTimeLeftInTween -= fSecsToSubtract;
 		fDeltaTime -= fSecsToSubtract;
 
-		RString sCommand = TI.m_sCommandName;
+		// Only copied when it's about to run; most tweens have no command.
+		RString sCommand;
 		if( bBeginning )			// we are just beginning this tween
 		{
+			sCommand = TI.m_sCommandName;
 			m_start = m_current;	// set the start position
 			SetCurrentTweenStart();
 		}
@@ -894,6 +954,18 @@ void Actor::Update( float fDeltaTime )
 	}
 
 	this->UpdateInternal( fDeltaTime );
+	m_bUpdateClean = IsIdle();
+}
+
+bool Actor::ActorIsIdle() const
+{
+	return !m_bFirstUpdate && m_Tweens.empty() && m_Effect == no_effect &&
+		m_fHibernateSecondsLeft <= 0 && m_WrapperStates.empty();
+}
+
+bool Actor::IsIdle() const
+{
+	return typeid(*this) == typeid(Actor) && ActorIsIdle();
 }
 
 static void generic_global_timer_update(float new_time, float& effect_delta_time, float& time_into_effect)
@@ -992,6 +1064,7 @@ void Actor::AddWrapperState()
 	ActorFrame* wrapper= new ActorFrame;
 	wrapper->InitState();
 	m_WrapperStates.push_back(wrapper);
+	MarkUpdateDirty();
 }
 
 void Actor::RemoveWrapperState(std::size_t i)
@@ -1021,6 +1094,7 @@ void Actor::BeginTweening( float time, ITween *pTween )
 
 	// add a new TweenState to the tail, and initialize it
 	m_Tweens.push_back( new TweenStateAndInfo );
+	MarkUpdateDirty();
 
 	// latest
 	TweenState &TS = m_Tweens.back()->state;
@@ -1201,6 +1275,7 @@ void Actor::ResetEffectTimeIfDifferent(Effect new_effect)
 	{
 		m_Effect= new_effect;
 		m_fSecsIntoEffect = 0;
+		MarkUpdateDirty();
 	}
 }
 
@@ -1286,6 +1361,7 @@ void Actor::SetEffectBounce( float fPeriod, RageVector3 vect )
 	ASSERT( fPeriod > 0 );
 	// todo: account for SSC_FUTURES -aj
 	m_Effect = bounce;
+	MarkUpdateDirty();
 	SetEffectPeriod( fPeriod );
 	m_vEffectMagnitude = vect;
 	m_fSecsIntoEffect = 0;
@@ -1298,6 +1374,7 @@ void Actor::SetEffectBob( float fPeriod, RageVector3 vect )
 	if( m_Effect!=bob || GetEffectPeriod() != fPeriod )
 	{
 		m_Effect = bob;
+		MarkUpdateDirty();
 		SetEffectPeriod( fPeriod );
 		m_fSecsIntoEffect = 0;
 	}
@@ -1308,6 +1385,7 @@ void Actor::SetEffectSpin( RageVector3 vect )
 {
 	// todo: account for SSC_FUTURES -aj
 	m_Effect = spin;
+	MarkUpdateDirty();
 	m_vEffectMagnitude = vect;
 }
 
@@ -1315,6 +1393,7 @@ void Actor::SetEffectVibrate( RageVector3 vect )
 {
 	// todo: account for SSC_FUTURES -aj
 	m_Effect = vibrate;
+	MarkUpdateDirty();
 	m_vEffectMagnitude = vect;
 }
 
@@ -1323,6 +1402,7 @@ void Actor::SetEffectPulse( float fPeriod, float fMinZoom, float fMaxZoom )
 	ASSERT( fPeriod > 0 );
 	// todo: account for SSC_FUTURES -aj
 	m_Effect = pulse;
+	MarkUpdateDirty();
 	SetEffectPeriod( fPeriod );
 	m_vEffectMagnitude[0] = fMinZoom;
 	m_vEffectMagnitude[1] = fMaxZoom;
@@ -1352,6 +1432,9 @@ void Actor::RunCommands( const LuaReference& cmds, const LuaReference *pParamTab
 		return;
 	}
 
+	// A command can do anything to the actor.
+	MarkUpdateDirty();
+
 	Lua *L = LUA->Get();
 
 	// function
@@ -1373,8 +1456,7 @@ void Actor::RunCommands( const LuaReference& cmds, const LuaReference *pParamTab
 		pParamTable->PushSelf( L );
 
 	// call function with 2 arguments and 0 results
-	RString Error= "Error playing command:";
-	LuaHelpers::RunScriptOnStack(L, Error, 2, 0, true);
+	LuaHelpers::RunScriptOnStackAndReport( L, "Error playing command:", 2, 0 );
 
 	LUA->Release(L);
 }
@@ -1523,15 +1605,26 @@ void Actor::AddCommand( const RString &sCmdName, apActorCommands apac, bool warn
 	}
 
 	RString sMessage;
+	MessageSymbol sym;
 	if( GetMessageNameFromCommandName(sCmdName, sMessage) )
 	{
 		SubscribeToMessage( sMessage );
-		m_mapNameToCommands[sMessage] = apac;	// sCmdName w/o "Message" at the end
+		sym = InternMessageName( sMessage );	// sCmdName w/o "Message" at the end
 	}
 	else
 	{
-		m_mapNameToCommands[sCmdName] = apac;
+		sym = InternMessageName( sCmdName );
 	}
+
+	for( std::pair<MessageSymbol, apActorCommands> &cmd : m_vCommands )
+	{
+		if( cmd.first == sym )
+		{
+			cmd.second = apac;
+			return;
+		}
+	}
+	m_vCommands.push_back( std::make_pair(sym, apac) );
 }
 
 bool Actor::HasCommand( const RString &sCmdName ) const
@@ -1541,10 +1634,21 @@ bool Actor::HasCommand( const RString &sCmdName ) const
 
 const apActorCommands *Actor::GetCommand( const RString &sCommandName ) const
 {
-	std::map<RString, apActorCommands>::const_iterator it = m_mapNameToCommands.find( sCommandName );
-	if( it == m_mapNameToCommands.end() )
+	/* A name that was never interned can't be any actor's command. */
+	const MessageSymbol sym = FindMessageSymbol( sCommandName );
+	if( sym == MessageSymbol_Invalid )
 		return nullptr;
-	return &it->second;
+	return GetCommand( sym );
+}
+
+const apActorCommands *Actor::GetCommand( MessageSymbol sym ) const
+{
+	for( const std::pair<MessageSymbol, apActorCommands> &cmd : m_vCommands )
+	{
+		if( cmd.first == sym )
+			return &cmd.second;
+	}
+	return nullptr;
 }
 
 void Actor::HandleMessage( const Message &msg )
@@ -1554,7 +1658,7 @@ void Actor::HandleMessage( const Message &msg )
 
 void Actor::PlayCommandNoRecurse( const Message &msg )
 {
-	const apActorCommands *pCmd = GetCommand( msg.GetName() );
+	const apActorCommands *pCmd = GetCommand( msg.GetSymbol() );
 	if(pCmd != nullptr && (*pCmd)->IsSet() && !(*pCmd)->IsNil())
 	{
 		RunCommands( *pCmd, &msg.GetParamTable() );
@@ -1585,6 +1689,22 @@ void Actor::SetParent( Actor *pParent )
 	LUA->Release( L );
 }
 
+static RageSlabAllocator &GetTweenAllocator( std::size_t iSize )
+{
+	static RageSlabAllocator *pAllocator = new RageSlabAllocator( "TweenStateAndInfo", iSize );
+	return *pAllocator;
+}
+
+void *Actor::TweenStateAndInfo::operator new( std::size_t iSize )
+{
+	return GetTweenAllocator( sizeof(TweenStateAndInfo) ).Allocate( iSize );
+}
+
+void Actor::TweenStateAndInfo::operator delete( void *p, std::size_t iSize )
+{
+	GetTweenAllocator( sizeof(TweenStateAndInfo) ).Free( p, iSize );
+}
+
 Actor::TweenInfo::TweenInfo()
 {
 	m_pTween = nullptr;
@@ -261,6 +261,22 @@ public:
 	virtual void PostDraw();
 	/** @brief Start the drawing and push the transform on the world matrix stack. */
 	virtual void BeginDraw();
+	/**
+	 * @brief Get the rectangle, in local coordinates, that DrawPrimitives
+	 * stays inside.
+	 *
+	 * Subclasses that draw something other than what their base class does
+	 * must override this.
+	 * @return false if it isn't known, which is the default. */
+	virtual bool GetDrawBounds( RectF & /* rect */ ) const { return false; }
+	/**
+	 * @brief Would drawing this Actor put nothing on the screen?
+	 *
+	 * This is conservative: it's false for anything that it can't be sure
+	 * about, such as actors with effects or unknown bounds.
+	 * @param matViewProj the transform from world to clip space.
+	 * @param matParentWorld the parent's world matrix. */
+	bool IsOffScreen( const RageMatrix &matViewProj, const RageMatrix &matParentWorld );
 	/**
 	 * @brief Set the global rendering states of this Actor.
 	 *
@@ -293,6 +309,18 @@ public:
 	bool get_tween_uses_effect_delta() { return m_tween_uses_effect_delta; }
 	void set_tween_uses_effect_delta(bool t) { m_tween_uses_effect_delta= t; }
 
+	/* An ActorFrame doesn't update children that were idle after their last
+	 * update and haven't been touched since.  Anything that can give an actor
+	 * per-frame work again (tweens, effects, commands, hibernation) marks it
+	 * and its parents dirty. */
+	bool IsUpdateClean() const { return m_bUpdateClean; }
+	void MarkUpdateDirty()
+	{
+		m_bUpdateClean = false;
+		for( Actor *p = m_pParent; p != nullptr && p->m_bUpdateClean; p = p->m_pParent )
+			p->m_bUpdateClean = false;
+	}
+
 	/**
 	 * @brief Retrieve the Actor's name.
 	 * @return the Actor's name. */
@@ -573,11 +601,11 @@ public:
 	void SetShadowLengthY( float fLengthY )		{ m_fShadowLengthY = fLengthY; }
 	void SetShadowColor( RageColor c )		{ m_ShadowColor = c; }
 	// TODO: Implement hibernate as a tween type?
-	void SetHibernate( float fSecs )		{ m_fHibernateSecondsLeft = fSecs; }
+	void SetHibernate( float fSecs )		{ m_fHibernateSecondsLeft = fSecs; MarkUpdateDirty(); }
 	void SetDrawOrder( int iOrder )			{ m_iDrawOrder = iOrder; }
 	int GetDrawOrder() const			{ return m_iDrawOrder; }
 
-	virtual void EnableAnimation( bool b ) 		{ m_bIsAnimating = b; }	// Sprite needs to overload this
+	virtual void EnableAnimation( bool b ) 		{ m_bIsAnimating = b; MarkUpdateDirty(); }	// Sprite needs to overload this
 	void StartAnimating()				{ this->EnableAnimation(true); }
 	void StopAnimating()				{ this->EnableAnimation(false); }
 
@@ -601,6 +629,7 @@ public:
 	void AddCommand( const RString &sCmdName, apActorCommands apac, bool warn= true );
 	bool HasCommand( const RString &sCmdName ) const;
 	const apActorCommands *GetCommand( const RString &sCommandName ) const;
+	const apActorCommands *GetCommand( MessageSymbol sym ) const;
 	void PlayCommand( const RString &sCommandName ) { HandleMessage( Message(sCommandName) ); } // convenience
 	void PlayCommandNoRecurse( const Message &msg );
 
@@ -669,6 +698,11 @@ protected:
 	{
 		TweenState state;
 		TweenInfo info;
+
+		/* Every BeginTweening makes one of these, so they come from a slab
+		 * instead of the heap. */
+		static void *operator new( std::size_t iSize );
+		static void operator delete( void *p, std::size_t iSize );
 	};
 	std::vector<TweenStateAndInfo *>	m_Tweens;
 
@@ -676,6 +710,22 @@ protected:
 	TweenState *m_pTempState;
 
 	bool	m_bFirstUpdate;
+	bool	m_bUpdateClean;
+
+	/* BeginDraw's transform, without the quaternion, which is applied in
+	 * world space.  It's only rebuilt when the values it's made from change. */
+	void UpdateLocalMatrix( const TweenState &ts );
+	enum { NUM_LOCAL_MATRIX_INPUTS = 13 };
+	float	m_fLocalMatrixInputs[NUM_LOCAL_MATRIX_INPUTS];
+	bool	m_bLocalMatrixValid;
+	bool	m_bLocalMatrixIsIdentity;
+	RageMatrix	m_LocalMatrix;
+
+	/* Whether Update has nothing to do right now but count time.  A subclass
+	 * may do its own work every frame, so this is only true for the exact
+	 * classes that override it; ActorIsIdle checks the state they share. */
+	virtual bool IsIdle() const;
+	bool ActorIsIdle() const;
 
 	// Stuff for alignment
 	/** @brief The particular horizontal alignment.
@@ -753,8 +803,9 @@ protected:
 	static std::vector<float> g_vfCurrentBGMBeatPlayerNoOffset;
 
 private:
-	// commands
-	std::map<RString, apActorCommands> m_mapNameToCommands;
+	// commands, by interned name; actors only have a handful, so a flat
+	// vector is searched faster than a map.
+	std::vector<std::pair<MessageSymbol, apActorCommands>> m_vCommands;
 };
 
 #endif
@@ -11,6 +11,7 @@
 #include "ScreenDimensions.h"
 
 #include <cstdint>
+#include <typeinfo>
 #include <vector>
 
 /* Tricky: We need ActorFrames created in Lua to auto delete their children.
@@ -152,6 +153,7 @@ void ActorFrame::AddChild( Actor *pActor )
 	m_SubActors.push_back( pActor );
 
 	pActor->SetParent( this );
+	MarkUpdateDirty();
 }
 
 void ActorFrame::RemoveChild( Actor *pActor )
@@ -243,8 +245,7 @@ void ActorFrame::DrawPrimitives()
 			return;
 		}
 		this->PushSelf( L );
-		RString Error= "Error running DrawFunction: ";
-		LuaHelpers::RunScriptOnStack(L, Error, 1, 0, true); // 1 arg, 0 results
+		LuaHelpers::RunScriptOnStackAndReport( L, "Error running DrawFunction: ", 1, 0 ); // 1 arg, 0 results
 		LUA->Release(L);
 		return;
 	}
@@ -252,6 +253,11 @@ void ActorFrame::DrawPrimitives()
 	RageColor diffuse = m_pTempState->diffuse[0];
 	RageColor glow = m_pTempState->glow;
 
+	/* Everything between this frame's coordinate space and the screen is the
+	 * same for every child, so work it out once for the culling test. */
+	RageMatrix matWorld, matViewProj;
+	DISPLAY->GetWorldAndViewProjection( matWorld, matViewProj );
+
 	// Word of warning:  Actor::Draw duplicates the structure of how an Actor
 	// is drawn inside of an ActorFrame for its wrapping feature.  So if
 	// you're adding something new to ActorFrames that affects how Actors are
@@ -265,6 +271,8 @@ void ActorFrame::DrawPrimitives()
 		ActorUtil::SortByZPosition( subs );
 		for( unsigned i=0; i<subs.size(); i++ )
 		{
+			if( subs[i]->IsOffScreen(matViewProj, matWorld) )
+				continue;
 			subs[i]->SetInternalDiffuse( diffuse );
 			subs[i]->SetInternalGlow( glow );
 			subs[i]->Draw();
@@ -274,6 +282,8 @@ void ActorFrame::DrawPrimitives()
 	{
 		for( unsigned i=0; i<m_SubActors.size(); i++ )
 		{
+			if( m_SubActors[i]->IsOffScreen(matViewProj, matWorld) )
+				continue;
 			m_SubActors[i]->SetInternalDiffuse( diffuse );
 			m_SubActors[i]->SetInternalGlow( glow );
 			m_SubActors[i]->Draw();
@@ -479,6 +489,8 @@ void ActorFrame::UpdateInternal( float fDeltaTime )
 	for( std::vector<Actor*>::iterator it=m_SubActors.begin(); it!=m_SubActors.end(); it++ )
 	{
 		Actor *pActor = *it;
+		if( pActor->IsUpdateClean() )
+			continue;
 		pActor->Update(fDeltaTime);
 	}
 
@@ -494,12 +506,28 @@ void ActorFrame::UpdateInternal( float fDeltaTime )
 		}
 		this->PushSelf( L );
 		lua_pushnumber( L, fDeltaTime );
-		RString Error= "Error running UpdateFunction: ";
-		LuaHelpers::RunScriptOnStack(L, Error, 2, 0, true); // 1 args, 0 results
+		LuaHelpers::RunScriptOnStackAndReport( L, "Error running UpdateFunction: ", 2, 0 ); // 2 args, 0 results
 		LUA->Release(L);
 	}
 }
 
+bool ActorFrame::FrameIsIdle() const
+{
+	if( !ActorIsIdle() || !m_UpdateFunction.IsNil() )
+		return false;
+	for( const Actor *pActor : m_SubActors )
+		if( !pActor->IsUpdateClean() )
+			return false;
+	return true;
+}
+
+bool ActorFrame::IsIdle() const
+{
+	if( typeid(*this) != typeid(ActorFrame) && typeid(*this) != typeid(ActorFrameAutoDeleteChildren) )
+		return false;
+	return FrameIsIdle();
+}
+
 #define PropagateActorFrameCommand( cmd ) \
 	void ActorFrame::cmd()				\
 	{									\
@@ -47,7 +47,7 @@ public:
 	void SetDrawByZPosition( bool b );
 
 	void SetDrawFunction( const LuaReference &DrawFunction ) { m_DrawFunction = DrawFunction; }
-	void SetUpdateFunction( const LuaReference &UpdateFunction ) { m_UpdateFunction = UpdateFunction; }
+	void SetUpdateFunction( const LuaReference &UpdateFunction ) { m_UpdateFunction = UpdateFunction; MarkUpdateDirty(); }
 
 	LuaReference GetDrawFunction() const { return m_DrawFunction; }
 	virtual bool AutoLoadChildren() const { return false; } // derived classes override to automatically LoadChildrenFromNode
@@ -100,6 +100,10 @@ public:
 protected:
 	void LoadChildrenFromNode( const XNode* pNode );
 
+	virtual bool IsIdle() const override;
+	/* Idle, with no update function and no children that need updating. */
+	bool FrameIsIdle() const;
+
 	/** @brief The children Actors used by the ActorFrame. */
 	std::vector<Actor*>	m_SubActors;
 	bool m_bPropagateCommands;
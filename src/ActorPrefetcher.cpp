@@ -0,0 +1,173 @@
+#include "global.h"
+#include "ActorPrefetcher.h"
+#include "LuaBytecodeCache.h"
+#include "RageFileManager.h"
+#include "RageLog.h"
+#include "RageThreads.h"
+#include "RageUtil.h"
+#include "RageUtil_ThreadPool.h"
+#include "Preference.h"
+
+#include <map>
+
+static Preference<bool> g_bPrefetchActors( "PrefetchActors", true );
+
+struct PrefetchedChunk
+{
+	PrefetchedChunk(): bDone(false), bCompiled(false), iFileHash(0) { }
+	bool bDone;
+	bool bCompiled;
+	/* The source file's size and modification time when it was read. */
+	unsigned iFileHash;
+	RString sBytecode;
+};
+
+/* Keyed by GetKey.  Signalled whenever a chunk is done. */
+static RageEvent g_ChunksEvent( "ActorPrefetcher" );
+static std::map<RString, PrefetchedChunk> g_mapChunks;
+
+/* Created on first use; only touched from the main thread. */
+static RageThreadPool *g_pPool = nullptr;
+
+/* Actors find the same file by different spellings. */
+static RString GetKey( const RString &sFile )
+{
+	RString sKey = sFile;
+	CollapsePath( sKey );
+	if( BeginsWith(sKey, "/") )
+		sKey.erase( 0, 1 );
+	sKey.MakeLower();
+	return sKey;
+}
+
+static void CompileJob( const RString &sKey, const RString &sFile )
+{
+	/* Take the hash first, so a change made while compiling is noticed. */
+	const unsigned iFileHash = GetHashForFile( sFile );
+	RString sBytecode, sError;
+	const bool bCompiled = LuaBytecodeCache::CompileFile( sFile, sBytecode, sError );
+
+	g_ChunksEvent.Lock();
+	/* Pending entries are never removed, so this is always found. */
+	PrefetchedChunk &chunk = g_mapChunks[sKey];
+	chunk.bDone = true;
+	chunk.bCompiled = bCompiled;
+	chunk.iFileHash = iFileHash;
+	chunk.sBytecode.swap( sBytecode );
+	g_ChunksEvent.Broadcast();
+	g_ChunksEvent.Unlock();
+}
+
+/* Listing directories is cheap, since FILEMAN caches them, so the files are
+ * found here; only the reading and compiling is left to the workers. */
+static void GetScripts( const RString &sPath, std::vector<RString> &vsOut )
+{
+	if( FILEMAN->IsADirectory(sPath) )
+	{
+		RString sDir = sPath;
+		if( !EndsWith(sDir, "/") )
+			sDir += "/";
+		FILEMAN->GetDirListing( sDir + "*.lua", vsOut, false, true );
+	}
+	else if( GetExtension(sPath).CompareNoCase("lua") == 0 )
+	{
+		vsOut.push_back( sPath );
+	}
+}
+
+void ActorPrefetcher::Prefetch( const std::vector<RString> &vsPaths )
+{
+	if( !g_bPrefetchActors )
+		return;
+
+	std::vector<RString> vsFiles;
+	for( const RString &sPath : vsPaths )
+		GetScripts( sPath, vsFiles );
+
+	if( g_pPool == nullptr )
+		g_pPool = new RageThreadPool( "ActorPrefetcher" );
+
+	std::map<RString, RString> mapKeyToFile;
+	for( const RString &sFile : vsFiles )
+		mapKeyToFile[GetKey(sFile)] = sFile;
+
+	std::vector<std::pair<RString, RString>> vJobs;
+	g_ChunksEvent.Lock();
+	/* Keep anything this screen wants again, such as chunks prefetched during
+	 * the last screen's transition. */
+	for( std::map<RString, PrefetchedChunk>::iterator it = g_mapChunks.begin(); it != g_mapChunks.end(); )
+	{
+		if( it->second.bDone && mapKeyToFile.find(it->first) == mapKeyToFile.end() )
+			g_mapChunks.erase( it++ );
+		else
+			++it;
+	}
+
+	for( const std::pair<const RString, RString> &file : mapKeyToFile )
+	{
+		const RString &sKey = file.first, &sFile = file.second;
+		if( g_mapChunks.find(sKey) != g_mapChunks.end() )
+			continue;
+		g_mapChunks[sKey] = PrefetchedChunk();
+		vJobs.push_back( std::make_pair(sKey, sFile) );
+	}
+	g_ChunksEvent.Unlock();
+
+	if( !vJobs.empty() )
+		LOG->Trace( "ActorPrefetcher: compiling %i scripts", (int) vJobs.size() );
+	for( const std::pair<RString, RString> &job : vJobs )
+	{
+		const RString sKey = job.first, sFile = job.second;
+		g_pPool->Submit( [sKey, sFile]() { CompileJob(sKey, sFile); } );
+	}
+}
+
+bool ActorPrefetcher::TakeChunk( const RString &sFile, RString &sBytecodeOut )
+{
+	const RString sKey = GetKey( sFile );
+
+	PrefetchedChunk chunk;
+	g_ChunksEvent.Lock();
+	for(;;)
+	{
+		/* Look it up again after waiting; a done entry may have been discarded. */
+		std::map<RString, PrefetchedChunk>::iterator it = g_mapChunks.find( sKey );
+		if( it == g_mapChunks.end() )
+		{
+			g_ChunksEvent.Unlock();
+			return false;
+		}
+
+		if( it->second.bDone )
+		{
+			chunk.bCompiled = it->second.bCompiled;
+			chunk.iFileHash = it->second.iFileHash;
+			chunk.sBytecode.swap( it->second.sBytecode );
+			g_mapChunks.erase( it );
+			break;
+		}
+
+		g_ChunksEvent.Wait();
+	}
+	g_ChunksEvent.Unlock();
+
+	if( !chunk.bCompiled )
+		return false;
+	if( chunk.iFileHash != GetHashForFile(sFile) )
+	{
+		LOG->Trace( "ActorPrefetcher: \"%s\" changed since it was prefetched", sFile.c_str() );
+		return false;
+	}
+
+	sBytecodeOut.swap( chunk.sBytecode );
+	return true;
+}
+
+void ActorPrefetcher::Shutdown()
+{
+	SAFE_DELETE( g_pPool );
+
+	g_ChunksEvent.Lock();
+	g_mapChunks.clear();
+	g_ChunksEvent.Unlock();
+}
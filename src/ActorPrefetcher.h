@@ -0,0 +1,30 @@
+/* ActorPrefetcher - compiles a screen's scripts ahead of time on worker threads. */
+
+#ifndef ACTOR_PREFETCHER_H
+#define ACTOR_PREFETCHER_H
+
+#include <vector>
+
+/* Running an actor's Lua has to happen on the main thread, but reading and
+ * compiling the scripts doesn't.  Prefetch takes the element paths of a screen
+ * that's about to be loaded, and compiles every script in them on worker
+ * threads; when the screen is constructed, LuaBytecodeCache::LoadFile takes
+ * the compiled chunks from here instead of compiling them itself. */
+namespace ActorPrefetcher
+{
+	/* vsPaths are files or BGAnimation directories, as returned by
+	 * THEME->GetPathB.  Must be called from the main thread.  Chunks from an
+	 * earlier call that were never used, and aren't wanted again, are
+	 * discarded. */
+	void Prefetch( const std::vector<RString> &vsPaths );
+
+	/* If sFile was prefetched, wait for it to finish compiling, remove it and
+	 * return true with the chunk in sBytecodeOut.  Returns false if sFile
+	 * wasn't prefetched, didn't compile, or has changed since. */
+	bool TakeChunk( const RString &sFile, RString &sBytecodeOut );
+
+	/* Wait for outstanding work and stop the worker threads. */
+	void Shutdown();
+}
+
+#endif
@@ -10,6 +10,7 @@
 #include "XmlFileUtil.h"
 #include "IniFile.h"
 #include "LuaManager.h"
+#include "LuaBytecodeCache.h"
 #include "Song.h"
 #include "Course.h"
 #include "GameState.h"
@@ -240,14 +241,10 @@ namespace
 {
 	XNode *LoadXNodeFromLuaShowErrors( const RString &sFile )
 	{
-		RString sScript;
-		if( !GetFileContents(sFile, sScript) )
-			return nullptr;
-
 		Lua *L = LUA->Get();
 
 		RString sError;
-		if( !LuaHelpers::LoadScript(L, sScript, "@" + sFile, sError) )
+		if( !LuaBytecodeCache::LoadFile(L, sFile, sError) )
 		{
 			LUA->Release( L );
 			sError = ssprintf( "Lua runtime error: %s", sError.c_str() );
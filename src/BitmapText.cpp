@@ -10,8 +10,10 @@
 #include "ActorUtil.h"
 #include "LuaBinding.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <typeinfo>
 #include <vector>
 
 
@@ -75,6 +77,11 @@ BitmapText::~BitmapText()
 		FONT->UnloadFont( m_pFont );
 }
 
+bool BitmapText::IsIdle() const
+{
+	return typeid(*this) == typeid(BitmapText) && ActorIsIdle();
+}
+
 BitmapText & BitmapText::operator=(const BitmapText &cpy)
 {
 	Actor::operator=(cpy);
@@ -95,6 +102,7 @@ BitmapText & BitmapText::operator=(const BitmapText &cpy)
 	CPY( m_iVertSpacing );
 	CPY( m_MaxDimensionUsesZoom );
 	CPY( m_aVertices );
+	CPY( m_VertexBounds );
 	CPY( m_vpFontPageTextures );
 	CPY( m_mAttributes );
 	CPY( m_bHasGlowAttribute );
@@ -287,9 +295,10 @@ void BitmapText::BuildChars()
 	{
 		iY += m_pFont->GetHeight();
 
-		std::wstring sLine = m_wTextLines[i];
+		std::wstring sReversed;
 		if( m_pFont->IsRightToLeft() )
-			reverse( sLine.begin(), sLine.end() );
+			sReversed.assign( m_wTextLines[i].rbegin(), m_wTextLines[i].rend() );
+		const std::wstring &sLine = m_pFont->IsRightToLeft()? sReversed: m_wTextLines[i];
 		const int iLineWidth = m_iLineWidths[i];
 
 		float fX = SCALE( m_fHorizAlign, 0.0f, 1.0f, -m_size.x/2.0f, +m_size.x/2.0f - iLineWidth );
@@ -343,6 +352,28 @@ void BitmapText::BuildChars()
 			}
 		}
 	}
+
+	m_VertexBounds = RectF();
+	if( !m_aVertices.empty() )
+	{
+		m_VertexBounds = RectF( m_aVertices[0].p.x, m_aVertices[0].p.y, m_aVertices[0].p.x, m_aVertices[0].p.y );
+		for( const RageSpriteVertex &v : m_aVertices )
+		{
+			m_VertexBounds.left = std::min( m_VertexBounds.left, v.p.x );
+			m_VertexBounds.top = std::min( m_VertexBounds.top, v.p.y );
+			m_VertexBounds.right = std::max( m_VertexBounds.right, v.p.x );
+			m_VertexBounds.bottom = std::max( m_VertexBounds.bottom, v.p.y );
+		}
+	}
+}
+
+bool BitmapText::GetDrawBounds( RectF &rect ) const
+{
+	// Jitter moves the characters around at draw time.
+	if( m_bJitter )
+		return false;
+	rect = m_VertexBounds;
+	return true;
 }
 
 void BitmapText::DrawChars( bool bUseStrokeTexture )
@@ -483,9 +514,15 @@ void BitmapText::SetTextInternal()
 {
 	// Break the string into lines.
 
-	m_wTextLines.clear();
+	std::vector<std::wstring> vOldLines;
+	vOldLines.swap( m_wTextLines );
 
-	if( m_iWrapWidthPixels == -1 )
+	if( m_iWrapWidthPixels == -1 && !m_sText.empty() && m_sText.find('\n') == RString::npos )
+	{
+		// One line, as with scores and timers; no need to split.
+		m_wTextLines.push_back( RStringToWstring(m_sText) );
+	}
+	else if( m_iWrapWidthPixels == -1 )
 	{
 		split( RStringToWstring(m_sText), L"\n", m_wTextLines, false );
 	}
@@ -539,10 +576,72 @@ void BitmapText::SetTextInternal()
 		}
 	}
 
-	BuildChars();
+	if( !UpdateCharsInPlace(vOldLines) )
+		BuildChars();
 	UpdateBaseZoom();
 }
 
+static bool GlyphsHaveSameMetrics( const glyph &a, const glyph &b )
+{
+	return a.m_iHadvance == b.m_iHadvance && a.m_fWidth == b.m_fWidth &&
+		a.m_fHeight == b.m_fHeight && a.m_fHshift == b.m_fHshift &&
+		a.m_pPage->m_fVshift == b.m_pPage->m_fVshift;
+}
+
+/* If the new lines are laid out exactly like vOldLines, with each changed
+ * character replaced by one with the same metrics, then no vertex moves, and
+ * only the changed characters' texture coordinates need updating.  Most number
+ * fonts give every digit the same metrics, so this is what happens when a score
+ * or a timer ticks. */
+bool BitmapText::UpdateCharsInPlace( const std::vector<std::wstring> &vOldLines )
+{
+	// Distortion is random per build, and right-to-left lines are reversed.
+	if( m_pFont == nullptr || m_bUsingDistortion || m_pFont->IsRightToLeft() )
+		return false;
+	if( vOldLines.size() != m_wTextLines.size() )
+		return false;
+
+	std::size_t iChars = 0;
+	for( unsigned i = 0; i < m_wTextLines.size(); ++i )
+	{
+		if( m_wTextLines[i].size() != vOldLines[i].size() )
+			return false;
+		iChars += m_wTextLines[i].size();
+	}
+	if( m_aVertices.size() != iChars*4 || m_vpFontPageTextures.size() != iChars )
+		return false;
+
+	for( unsigned i = 0; i < m_wTextLines.size(); ++i )
+	{
+		const std::wstring &sNew = m_wTextLines[i], &sOld = vOldLines[i];
+		for( unsigned j = 0; j < sNew.size(); ++j )
+		{
+			if( sNew[j] != sOld[j] && !GlyphsHaveSameMetrics(m_pFont->GetGlyph(sNew[j]), m_pFont->GetGlyph(sOld[j])) )
+				return false;
+		}
+	}
+
+	std::size_t iGlyph = 0;
+	for( unsigned i = 0; i < m_wTextLines.size(); ++i )
+	{
+		const std::wstring &sNew = m_wTextLines[i], &sOld = vOldLines[i];
+		for( unsigned j = 0; j < sNew.size(); ++j, ++iGlyph )
+		{
+			if( sNew[j] == sOld[j] )
+				continue;
+
+			const glyph &g = m_pFont->GetGlyph( sNew[j] );
+			RageSpriteVertex *v = &m_aVertices[iGlyph*4];
+			v[0].t = RageVector2( g.m_TexRect.left,	g.m_TexRect.top );
+			v[1].t = RageVector2( g.m_TexRect.left,	g.m_TexRect.bottom );
+			v[2].t = RageVector2( g.m_TexRect.right,	g.m_TexRect.bottom );
+			v[3].t = RageVector2( g.m_TexRect.right,	g.m_TexRect.top );
+			m_vpFontPageTextures[iGlyph] = g.GetFontPageTextures();
+		}
+	}
+	return true;
+}
+
 void BitmapText::SetVertSpacing( int iSpacing )
 {
 	m_iVertSpacing = iSpacing;
@@ -71,6 +71,7 @@ public:
 
 	virtual bool EarlyAbortDraw() const override;
 	virtual void DrawPrimitives() override;
+	virtual bool GetDrawBounds( RectF &rect ) const override;
 
 	void SetUppercase( bool b );
 	void SetRainbowScroll( bool b )	{ m_bRainbowScroll = b; }
@@ -92,7 +93,7 @@ public:
 	void GetLines( std::vector<std::wstring> &wTextLines ) const { wTextLines = m_wTextLines; }
 	const std::vector<std::wstring> &GetLines() const { return m_wTextLines; }
 
-	RString GetText() const { return m_sText; }
+	const RString &GetText() const { return m_sText; }
 	// Return true if the string 's' will use an alternate string, if available.
 	bool StringWillUseAlternate( const RString& sText, const RString& sAlternateText ) const;
 
@@ -114,6 +115,8 @@ public:
 	virtual void PushSelf( lua_State *L ) override;
 
 protected:
+	virtual bool IsIdle() const override;
+
 	Font		*m_pFont;
 	bool		m_bUppercase;
 	RString		m_sText;
@@ -131,6 +134,7 @@ protected:
 	int			m_iVertSpacing;
 
 	std::vector<RageSpriteVertex>	m_aVertices;
+	RectF		m_VertexBounds;			// of m_aVertices, set by BuildChars
 
 	std::vector<FontPageTextures*>		m_vpFontPageTextures;
 	std::map<std::size_t, Attribute>	m_mAttributes;
@@ -140,6 +144,7 @@ protected:
 
 	// recalculate the items in SetText()
 	void BuildChars();
+	bool UpdateCharsInPlace( const std::vector<std::wstring> &vOldLines );
 	void DrawChars( bool bUseStrokeTexture );
 	void UpdateBaseZoom();
 
@@ -4,6 +4,7 @@ list(APPEND SMDATA_ACTOR_BASE_SRC
             "ActorFrameTexture.cpp"
             "ActorMultiTexture.cpp"
             "ActorMultiVertex.cpp"
+            "ActorPrefetcher.cpp"
             "ActorProxy.cpp"
             "ActorScroller.cpp"
             "ActorSound.cpp"
@@ -24,6 +25,7 @@ list(APPEND SMDATA_ACTOR_BASE_HPP
             "ActorFrameTexture.h"
             "ActorMultiTexture.h"
             "ActorMultiVertex.h"
+            "ActorPrefetcher.h"
             "ActorProxy.h"
             "ActorScroller.h"
             "ActorSound.h"
@@ -1,11 +1,15 @@
 list(APPEND SM_DATA_LUA_SRC
             "LuaBinding.cpp"
+            "LuaBytecodeCache.cpp"
             "LuaExpressionTransform.cpp"
+            "LuaProfiler.cpp"
             "LuaReference.cpp")
 
 list(APPEND SM_DATA_LUA_HPP
             "LuaBinding.h"
+            "LuaBytecodeCache.h"
             "LuaExpressionTransform.h"
+            "LuaProfiler.h"
             "LuaReference.h")
 
 source_group("Data Structures\\\\Lua"
@@ -173,6 +177,7 @@ list(APPEND SM_DATA_REST_SRC
             "CommonMetrics.cpp"
             "ControllerStateDisplay.cpp"
             "CreateZip.cpp"
+            "CryptHash.cpp"
             "CryptHelpers.cpp"
             "DateTime.cpp"
             "Difficulty.cpp"
@@ -200,12 +205,14 @@ list(APPEND SM_DATA_REST_SRC
             "PlayerState.cpp"
             "Preference.cpp"
             "Profile.cpp"
+            "ProfileWriter.cpp"
             "RadarValues.cpp"
             "RandomSample.cpp"
             "SampleHistory.cpp"
             "ScreenDimensions.cpp"
             "SoundEffectControl.cpp"
             "StageStats.cpp"
+            "StatsJournal.cpp"
             "TimingData.cpp"
             "TimingSegments.cpp"
             "TitleSubstitution.cpp")
@@ -223,6 +230,7 @@ list(APPEND SM_DATA_REST_HPP
             "CommonMetrics.h"
             "ControllerStateDisplay.h"
             "CreateZip.h"
+            "CryptHash.h"
             "CryptHelpers.h"
             "CubicSpline.h"
             "DateTime.h"
@@ -252,6 +260,7 @@ list(APPEND SM_DATA_REST_HPP
             "PlayerState.h"
             "Preference.h"
             "Profile.h"
+            "ProfileWriter.h"
             "RadarValues.h"
             "RandomSample.h"
             "SampleHistory.h"
@@ -259,6 +268,7 @@ list(APPEND SM_DATA_REST_HPP
             "SoundEffectControl.h"
             "SubscriptionManager.h"
             "StageStats.h"
+            "StatsJournal.h"
             "ThemeMetric.h"
             "TimingData.h"
             "TimingSegments.h"
@@ -5,6 +5,8 @@ list(APPEND SMDATA_RAGE_UTILS_SRC
             "RageUtil_BackgroundLoader.cpp"
             "RageUtil_CharConversions.cpp"
             "RageUtil_FileDB.cpp"
+            "RageUtil_SlabAllocator.cpp"
+            "RageUtil_ThreadPool.cpp"
             "RageUtil_WorkerThread.cpp")
 
 list(APPEND SMDATA_RAGE_UTILS_HPP
@@ -15,6 +17,8 @@ list(APPEND SMDATA_RAGE_UTILS_HPP
             "RageUtil_CharConversions.h"
             "RageUtil_CircularBuffer.h"
             "RageUtil_FileDB.h"
+            "RageUtil_SlabAllocator.h"
+            "RageUtil_ThreadPool.h"
             "RageUtil_WorkerThread.h")
 
 source_group("Rage\\\\Utils"
@@ -69,6 +73,7 @@ list(APPEND SMDATA_RAGE_GRAPHICS_SRC
             "RageSurfaceUtils_Palettize.cpp"
             "RageSurfaceUtils_Zoom.cpp"
             "RageTexture.cpp"
+            "RageTextureCache.cpp"
             "RageTextureID.cpp"
             "RageTextureManager.cpp"
             "RageTexturePreloader.cpp"
@@ -96,6 +101,7 @@ list(APPEND SMDATA_RAGE_GRAPHICS_HPP
             "RageSurfaceUtils_Palettize.h"
             "RageSurfaceUtils_Zoom.h"
             "RageTexture.h"
+            "RageTextureCache.h"
             "RageTextureID.h"
             "RageTextureManager.h"
             "RageTexturePreloader.h"
@@ -0,0 +1,321 @@
+#include "global.h"
+#include "CryptHash.h"
+
+// tomcrypt_cfg.h redefines malloc, realloc, calloc
+#pragma warning( push )
+#pragma warning( disable : 4565 )
+#include <tomcrypt.h>
+#pragma warning ( pop )
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define HAVE_SHA_NI
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+#define SHA_NI_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+#else
+#define SHA_NI_TARGET
+#endif
+#endif
+
+/* Registering a hash isn't thread-safe, and hashes are taken, and files
+ * signed, on worker threads, so they're all registered once, together. */
+struct RegisteredHashes
+{
+	RegisteredHashes()
+	{
+		iSHA1 = register_hash( &sha1_desc );
+		iSHA256 = register_hash( &sha256_desc );
+		iMD5 = register_hash( &md5_desc );
+		ASSERT( iSHA1 >= 0 && iSHA256 >= 0 && iMD5 >= 0 );
+	}
+	int iSHA1, iSHA256, iMD5;
+};
+
+int CryptHash::GetRegisteredIndex( Algorithm alg )
+{
+	static const RegisteredHashes hashes;
+	switch( alg )
+	{
+	case SHA1:	return hashes.iSHA1;
+	case SHA256:	return hashes.iSHA256;
+	default:	return hashes.iMD5;
+	}
+}
+
+#if defined(HAVE_SHA_NI)
+static bool CPUHasSHA()
+{
+	/* The kernels also use SSSE3 and SSE4.1, which every CPU with the SHA
+	 * extensions has, but check anyway. */
+	unsigned iLeaf1ECX, iLeaf7EBX;
+#if defined(_MSC_VER)
+	int regs[4];
+	__cpuid( regs, 0 );
+	if( regs[0] < 7 )
+		return false;
+	__cpuid( regs, 1 );
+	iLeaf1ECX = regs[2];
+	__cpuidex( regs, 7, 0 );
+	iLeaf7EBX = regs[1];
+#else
+	unsigned eax, ebx, ecx, edx;
+	if( __get_cpuid_max(0, nullptr) < 7 )
+		return false;
+	__cpuid( 1, eax, ebx, ecx, edx );
+	iLeaf1ECX = ecx;
+	__cpuid_count( 7, 0, eax, ebx, ecx, edx );
+	iLeaf7EBX = ebx;
+#endif
+	const bool bSSSE3 = (iLeaf1ECX & (1<<9)) != 0;
+	const bool bSSE41 = (iLeaf1ECX & (1<<19)) != 0;
+	const bool bSHA = (iLeaf7EBX & (1<<29)) != 0;
+	return bSSSE3 && bSSE41 && bSHA;
+}
+
+static const std::uint32_t SHA256_K[64] =
+{
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+/* Each group of four message words is computed from the previous four
+ * groups, kept in msg[] by their index mod 4. */
+SHA_NI_TARGET static void SHA1Blocks( std::uint32_t state[5], const unsigned char *pData, std::size_t iBlocks )
+{
+	// The instructions want the first word in the highest lane.
+	const __m128i MASK = _mm_set_epi8( 0,1,2,3, 4,5,6,7, 8,9,10,11, 12,13,14,15 );
+
+	__m128i abcd = _mm_shuffle_epi32( _mm_loadu_si128((const __m128i *) state), 0x1B );
+	__m128i e = _mm_set_epi32( (int) state[4], 0, 0, 0 );
+
+	while( iBlocks-- )
+	{
+		const __m128i abcdSave = abcd, eSave = e;
+		__m128i msg[4];
+		for( int i = 0; i < 20; ++i )
+		{
+			__m128i w;
+			if( i < 4 )
+			{
+				w = _mm_shuffle_epi8( _mm_loadu_si128((const __m128i *) (pData + i*16)), MASK );
+			}
+			else
+			{
+				w = _mm_sha1msg1_epu32( msg[i%4], msg[(i+1)%4] );
+				w = _mm_xor_si128( w, msg[(i+2)%4] );
+				w = _mm_sha1msg2_epu32( w, msg[(i+3)%4] );
+			}
+			msg[i%4] = w;
+
+			// e holds the previous abcd, from which E for these rounds comes.
+			e = i == 0? _mm_add_epi32( e, w ):_mm_sha1nexte_epu32( e, w );
+			const __m128i prev = abcd;
+			switch( i / 5 )
+			{
+			case 0: abcd = _mm_sha1rnds4_epu32( abcd, e, 0 ); break;
+			case 1: abcd = _mm_sha1rnds4_epu32( abcd, e, 1 ); break;
+			case 2: abcd = _mm_sha1rnds4_epu32( abcd, e, 2 ); break;
+			default: abcd = _mm_sha1rnds4_epu32( abcd, e, 3 ); break;
+			}
+			e = prev;
+		}
+
+		e = _mm_sha1nexte_epu32( e, eSave );
+		abcd = _mm_add_epi32( abcd, abcdSave );
+		pData += 64;
+	}
+
+	_mm_storeu_si128( (__m128i *) state, _mm_shuffle_epi32(abcd, 0x1B) );
+	state[4] = (std::uint32_t) _mm_extract_epi32( e, 3 );
+}
+
+SHA_NI_TARGET static void SHA256Blocks( std::uint32_t state[8], const unsigned char *pData, std::size_t iBlocks )
+{
+	// Byte-swap each word.
+	const __m128i MASK = _mm_set_epi8( 12,13,14,15, 8,9,10,11, 4,5,6,7, 0,1,2,3 );
+
+	// The instructions want the state as ABEF and CDGH.
+	__m128i tmp = _mm_shuffle_epi32( _mm_loadu_si128((const __m128i *) &state[0]), 0xB1 );	// CDAB
+	__m128i cdgh = _mm_shuffle_epi32( _mm_loadu_si128((const __m128i *) &state[4]), 0x1B );	// EFGH
+	__m128i abef = _mm_alignr_epi8( tmp, cdgh, 8 );
+	cdgh = _mm_blend_epi16( cdgh, tmp, 0xF0 );
+
+	while( iBlocks-- )
+	{
+		const __m128i abefSave = abef, cdghSave = cdgh;
+		__m128i msg[4];
+		for( int i = 0; i < 16; ++i )
+		{
+			__m128i w;
+			if( i < 4 )
+			{
+				w = _mm_shuffle_epi8( _mm_loadu_si128((const __m128i *) (pData + i*16)), MASK );
+			}
+			else
+			{
+				w = _mm_sha256msg1_epu32( msg[i%4], msg[(i+1)%4] );
+				w = _mm_add_epi32( w, _mm_alignr_epi8(msg[(i+3)%4], msg[(i+2)%4], 4) );
+				w = _mm_sha256msg2_epu32( w, msg[(i+3)%4] );
+			}
+			msg[i%4] = w;
+
+			__m128i wk = _mm_add_epi32( w, _mm_loadu_si128((const __m128i *) &SHA256_K[i*4]) );
+			cdgh = _mm_sha256rnds2_epu32( cdgh, abef, wk );
+			wk = _mm_shuffle_epi32( wk, 0x0E );
+			abef = _mm_sha256rnds2_epu32( abef, cdgh, wk );
+		}
+
+		abef = _mm_add_epi32( abef, abefSave );
+		cdgh = _mm_add_epi32( cdgh, cdghSave );
+		pData += 64;
+	}
+
+	tmp = _mm_shuffle_epi32( abef, 0x1B );	// FEBA
+	cdgh = _mm_shuffle_epi32( cdgh, 0xB1 );	// DCHG
+	_mm_storeu_si128( (__m128i *) &state[0], _mm_blend_epi16(tmp, cdgh, 0xF0) );	// DCBA
+	_mm_storeu_si128( (__m128i *) &state[4], _mm_alignr_epi8(cdgh, tmp, 8) );	// HGFE
+}
+#endif
+
+bool CryptHash::IsAccelerated()
+{
+#if defined(HAVE_SHA_NI)
+	static const bool bAccelerated = CPUHasSHA();
+	return bAccelerated;
+#else
+	return false;
+#endif
+}
+
+CryptHash::CryptHash( Algorithm alg )
+{
+	m_Algorithm = alg;
+	m_pState = (IsAccelerated() && alg != MD5)? nullptr:new hash_state;
+	Init();
+}
+
+CryptHash::~CryptHash()
+{
+	delete m_pState;
+}
+
+void CryptHash::Init()
+{
+	if( m_pState != nullptr )
+	{
+		int iRet = hash_descriptor[GetRegisteredIndex(m_Algorithm)].init( m_pState );
+		ASSERT_M( iRet == CRYPT_OK, error_to_string(iRet) );
+		return;
+	}
+
+	static const std::uint32_t SHA1_INIT[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+	static const std::uint32_t SHA256_INIT[8] =
+	{
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+	};
+	if( m_Algorithm == SHA1 )
+		memcpy( m_iState, SHA1_INIT, sizeof(SHA1_INIT) );
+	else
+		memcpy( m_iState, SHA256_INIT, sizeof(SHA256_INIT) );
+	m_iLength = 0;
+	m_iBuffered = 0;
+}
+
+#if defined(HAVE_SHA_NI)
+static void ProcessBlocks( CryptHash::Algorithm alg, std::uint32_t *pState, const unsigned char *pData, std::size_t iBlocks )
+{
+	if( alg == CryptHash::SHA1 )
+		SHA1Blocks( pState, pData, iBlocks );
+	else
+		SHA256Blocks( pState, pData, iBlocks );
+}
+#endif
+
+void CryptHash::Process( const void *pData, std::size_t iSize )
+{
+	if( m_pState != nullptr )
+	{
+		int iRet = hash_descriptor[GetRegisteredIndex(m_Algorithm)].process( m_pState, (const unsigned char *) pData, (unsigned long) iSize );
+		ASSERT_M( iRet == CRYPT_OK, error_to_string(iRet) );
+		return;
+	}
+
+#if defined(HAVE_SHA_NI)
+	const unsigned char *p = (const unsigned char *) pData;
+	m_iLength += iSize;
+
+	if( m_iBuffered != 0 )
+	{
+		std::size_t iCopy = std::min( iSize, sizeof(m_Buffer) - m_iBuffered );
+		memcpy( m_Buffer + m_iBuffered, p, iCopy );
+		m_iBuffered += iCopy;
+		p += iCopy;
+		iSize -= iCopy;
+		if( m_iBuffered < sizeof(m_Buffer) )
+			return;
+		ProcessBlocks( m_Algorithm, m_iState, m_Buffer, 1 );
+		m_iBuffered = 0;
+	}
+
+	// Hash whole blocks straight from the caller's buffer.
+	const std::size_t iBlocks = iSize / 64;
+	if( iBlocks != 0 )
+		ProcessBlocks( m_Algorithm, m_iState, p, iBlocks );
+	p += iBlocks * 64;
+	iSize -= iBlocks * 64;
+
+	memcpy( m_Buffer, p, iSize );
+	m_iBuffered = iSize;
+#endif
+}
+
+void CryptHash::Finish( unsigned char *pDigestOut )
+{
+	if( m_pState != nullptr )
+	{
+		int iRet = hash_descriptor[GetRegisteredIndex(m_Algorithm)].done( m_pState, pDigestOut );
+		ASSERT_M( iRet == CRYPT_OK, error_to_string(iRet) );
+		Init();
+		return;
+	}
+
+#if defined(HAVE_SHA_NI)
+	// Pad with a 1 bit, zeroes, then the length in bits, to a whole block.
+	const std::uint64_t iBits = m_iLength * 8;
+	m_Buffer[m_iBuffered++] = 0x80;
+	if( m_iBuffered > 56 )
+	{
+		memset( m_Buffer + m_iBuffered, 0, sizeof(m_Buffer) - m_iBuffered );
+		ProcessBlocks( m_Algorithm, m_iState, m_Buffer, 1 );
+		m_iBuffered = 0;
+	}
+	memset( m_Buffer + m_iBuffered, 0, 56 - m_iBuffered );
+	for( int i = 0; i < 8; ++i )
+		m_Buffer[56+i] = (unsigned char) (iBits >> (56 - i*8));
+	ProcessBlocks( m_Algorithm, m_iState, m_Buffer, 1 );
+
+	const int iWords = GetDigestSize() / 4;
+	for( int i = 0; i < iWords; ++i )
+	{
+		pDigestOut[i*4+0] = (unsigned char) (m_iState[i] >> 24);
+		pDigestOut[i*4+1] = (unsigned char) (m_iState[i] >> 16);
+		pDigestOut[i*4+2] = (unsigned char) (m_iState[i] >> 8);
+		pDigestOut[i*4+3] = (unsigned char) m_iState[i];
+	}
+#endif
+	Init();
+}
@@ -0,0 +1,56 @@
+/* CryptHash - MD5, SHA-1 and SHA-256, using the CPU's SHA instructions when it has them. */
+
+#ifndef CRYPT_HASH_H
+#define CRYPT_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+union Hash_state;
+
+/* libtomcrypt's hashes are portable C.  On x86 CPUs with the SHA extensions,
+ * SHA-1 and SHA-256 blocks are hashed with those instead, which is several
+ * times faster; anything else just calls libtomcrypt. */
+class CryptHash
+{
+public:
+	enum Algorithm { SHA1, SHA256, MD5 };
+
+	CryptHash( Algorithm alg );
+	~CryptHash();
+
+	void Process( const void *pData, std::size_t iSize );
+
+	/* Write the digest to pDigestOut, which holds GetDigestSize() bytes, and
+	 * start over. */
+	void Finish( unsigned char *pDigestOut );
+
+	int GetDigestSize() const { return m_Algorithm == MD5? 16: m_Algorithm == SHA1? 20:32; }
+
+	/* Whether the CPU's SHA instructions are used. */
+	static bool IsAccelerated();
+
+	/* The algorithm's index in libtomcrypt's hash_descriptor, for passing to
+	 * libtomcrypt's own functions, such as signing.  Use this instead of
+	 * register_hash. */
+	static int GetRegisteredIndex( Algorithm alg );
+
+private:
+	void Init();
+
+	Algorithm m_Algorithm;
+
+	/* libtomcrypt's state, if the CPU's instructions aren't used. */
+	Hash_state *m_pState;
+
+	std::uint32_t m_iState[8];
+	std::uint64_t m_iLength;
+	unsigned char m_Buffer[64];
+	std::size_t m_iBuffered;
+
+	// Swallow up warnings. If they must be used, define them.
+	CryptHash& operator=(const CryptHash& rhs);
+	CryptHash(const CryptHash& rhs);
+};
+
+#endif
@@ -7,16 +7,23 @@
 #pragma warning ( pop )
 
 #include "CryptManager.h"
+#include "CryptHash.h"
 #include "RageUtil.h"
 #include "RageLog.h"
 #include "RageFile.h"
 #include "RageFileManager.h"
+#include "RageThreads.h"
+#include "RageUtil_ThreadPool.h"
+#include "Preference.h"
+#include "SpecialFiles.h"
 #include "CryptHelpers.h"
 #include "LuaBinding.h"
 #include "LuaReference.h"
 #include "LuaManager.h"
 
 #include <cstdint>
+#include <future>
+#include <map>
 #include <vector>
 
 
@@ -26,36 +33,201 @@ static const RString PRIVATE_KEY_PATH = "Data/private.rsa";
 static const RString PUBLIC_KEY_PATH = "Data/public.rsa";
 static const RString ALTERNATE_PUBLIC_KEY_DIR = "Data/keys/";
 
-static bool HashFile( RageFileBasic &f, unsigned char buf_hash[20], int iHash )
-{
-	hash_state hash;
-	int iRet = hash_descriptor[iHash].init( &hash );
-	ASSERT_M( iRet == CRYPT_OK, error_to_string(iRet) );
+static Preference<bool> g_bCacheFileDigests( "CacheFileDigests", true );
+
+#define FILE_DIGESTS_PATH (SpecialFiles::CACHE_DIR + "FileDigests.txt")
+
+/* Files are read in chunks this big. */
+static const int HASH_READ_SIZE = 64*1024;
 
-	RString s;
-	while( !f.AtEOF() )
+static bool HashFile( RageFileBasic &f, unsigned char *buf_hash, CryptHash::Algorithm alg )
+{
+	CryptHash hash( alg );
+	std::vector<unsigned char> buf( HASH_READ_SIZE );
+	for(;;)
 	{
-		s.erase();
-		if( f.Read(s, 1024*4) == -1 )
+		int iGot = f.Read( buf.data(), buf.size() );
+		if( iGot == -1 )
 		{
 			LOG->Warn( "Error reading %s: %s", f.GetDisplayPath().c_str(), f.GetError().c_str() );
-			hash_descriptor[iHash].done( &hash, buf_hash );
+			hash.Finish( buf_hash );
 			return false;
 		}
+		if( iGot == 0 )
+			break;
 
-		iRet = hash_descriptor[iHash].process( &hash, (const unsigned char *) s.data(), s.size() );
-		ASSERT_M( iRet == CRYPT_OK, error_to_string(iRet) );
+		hash.Process( buf.data(), iGot );
 	}
 
-	iRet = hash_descriptor[iHash].done( &hash, buf_hash );
-	ASSERT_M( iRet == CRYPT_OK, error_to_string(iRet) );
-
+	hash.Finish( buf_hash );
 	return true;
 }
 
+enum DigestType { DIGEST_MD5, DIGEST_SHA1, DIGEST_SHA256, NUM_DIGEST_TYPES };
+static const char *g_szDigestNames[NUM_DIGEST_TYPES] = { "MD5", "SHA1", "SHA256" };
+
+static RString HashFileAtPath( const RString &sPath, DigestType type )
+{
+	RageFile file;
+	if( !file.Open(sPath, RageFile::READ) )
+	{
+		LOG->Warn( "Get%s: Failed to open file '%s'", g_szDigestNames[type], sPath.c_str() );
+		return RString();
+	}
+
+	static const CryptHash::Algorithm algs[NUM_DIGEST_TYPES] = { CryptHash::MD5, CryptHash::SHA1, CryptHash::SHA256 };
+	unsigned char digest[32];
+	// Don't return (and cache) a digest of part of the file.
+	if( !HashFile(file, digest, algs[type]) )
+		return RString();
+
+	const int iSize = type == DIGEST_MD5? 16: type == DIGEST_SHA1? 20:32;
+	return RString( (const char *) digest, iSize );
+}
+
+/* Digests of whole files, with the file's size and modification time
+ * (GetHashForFile) when it was hashed, so asking again for a file that hasn't
+ * changed is free.  Kept in FILE_DIGESTS_PATH between runs.  Never used to
+ * check signatures, since a file can be changed without changing those. */
+struct FileDigest
+{
+	unsigned iFileHash;
+	RString sDigest;
+};
+typedef std::pair<int, RString> FileDigestKey; // DigestType, path
+
+static RageMutex g_FileDigestsLock( "FileDigests" );
+static std::map<FileDigestKey, FileDigest> g_mapFileDigests;
+static bool g_bFileDigestsLoaded = false;
+static bool g_bFileDigestsChanged = false;
+
+/* Started on the first batch. */
+static RageThreadPool *g_pHashThreads = nullptr;
+
+/* Each line is "type filehash digest path". */
+static void LoadFileDigests()
+{
+	g_bFileDigestsLoaded = true;
+
+	RageFile f;
+	if( !f.Open(FILE_DIGESTS_PATH) )
+		return;
+
+	RString sLine;
+	while( f.GetLine(sLine) > 0 )
+	{
+		std::vector<RString> asParts;
+		split( sLine, " ", asParts );
+		if( asParts.size() < 4 )
+			continue;
+
+		int iType = StringToInt( asParts[0] );
+		if( iType < 0 || iType >= NUM_DIGEST_TYPES )
+			continue;
+
+		FileDigest digest;
+		digest.iFileHash = (unsigned) strtoul( asParts[1], nullptr, 10 );
+		if( !HexToBinary(asParts[2], &digest.sDigest) )
+			continue;
+
+		// The path is the rest of the line, spaces and all.
+		const std::size_t iPathStart = asParts[0].size() + asParts[1].size() + asParts[2].size() + 3;
+		g_mapFileDigests[FileDigestKey(iType, sLine.substr(iPathStart))] = digest;
+	}
+}
+
+static RString GetFileDigest( const RString &sPath, DigestType type )
+{
+	if( !g_bCacheFileDigests )
+		return HashFileAtPath( sPath, type );
+
+	const FileDigestKey key( type, sPath );
+	// Take the file's hash first, so a change made while hashing is noticed.
+	const unsigned iFileHash = GetHashForFile( sPath );
+
+	g_FileDigestsLock.Lock();
+	if( !g_bFileDigestsLoaded )
+		LoadFileDigests();
+	std::map<FileDigestKey, FileDigest>::const_iterator it = g_mapFileDigests.find( key );
+	if( it != g_mapFileDigests.end() && it->second.iFileHash == iFileHash )
+	{
+		RString sDigest = it->second.sDigest;
+		g_FileDigestsLock.Unlock();
+		return sDigest;
+	}
+	g_FileDigestsLock.Unlock();
+
+	FileDigest digest;
+	digest.iFileHash = iFileHash;
+	digest.sDigest = HashFileAtPath( sPath, type );
+	if( digest.sDigest.empty() )
+		return RString();
+
+	LockMut( g_FileDigestsLock );
+	g_mapFileDigests[key] = digest;
+	g_bFileDigestsChanged = true;
+	return digest.sDigest;
+}
+
+static void GetFileDigests( const std::vector<RString> &vsPaths, DigestType type, std::vector<RString> &vsDigestsOut )
+{
+	g_FileDigestsLock.Lock();
+	if( g_pHashThreads == nullptr )
+		g_pHashThreads = new RageThreadPool( "FileDigests" );
+	RageThreadPool *pThreads = g_pHashThreads;
+	g_FileDigestsLock.Unlock();
+
+	std::vector<std::future<RString>> vDigests;
+	vDigests.reserve( vsPaths.size() );
+	for( const RString &sPath : vsPaths )
+		vDigests.push_back( pThreads->Submit([sPath, type]() { return GetFileDigest(sPath, type); }) );
+
+	vsDigestsOut.clear();
+	vsDigestsOut.reserve( vsPaths.size() );
+	for( std::future<RString> &digest : vDigests )
+		vsDigestsOut.push_back( digest.get() );
+}
+
+/* Stop the batch threads, and save the digests of files that haven't
+ * changed since they were hashed. */
+static void SaveFileDigests()
+{
+	RageThreadPool *pThreads;
+	{
+		LockMut( g_FileDigestsLock );
+		pThreads = g_pHashThreads;
+		g_pHashThreads = nullptr;
+	}
+	delete pThreads;
+
+	LockMut( g_FileDigestsLock );
+	if( !g_bFileDigestsChanged )
+		return;
+	g_bFileDigestsChanged = false;
+
+	RageFile f;
+	if( !f.Open(FILE_DIGESTS_PATH, RageFile::WRITE) )
+	{
+		LOG->Trace( "Couldn't write %s: %s", FILE_DIGESTS_PATH.c_str(), f.GetError().c_str() );
+		return;
+	}
+
+	for( const std::pair<const FileDigestKey, FileDigest> &entry : g_mapFileDigests )
+	{
+		const RString &sPath = entry.first.second;
+		if( GetHashForFile(sPath) != entry.second.iFileHash )
+			continue;
+		f.PutLine( ssprintf("%i %u %s %s", entry.first.first, entry.second.iFileHash,
+			BinaryToHex(entry.second.sDigest).c_str(), sPath.c_str()) );
+	}
+}
+
 #if defined(DISABLE_CRYPTO)
 CryptManager::CryptManager() { }
-CryptManager::~CryptManager() { }
+CryptManager::~CryptManager()
+{
+	SaveFileDigests();
+}
 void CryptManager::GenerateRSAKey( unsigned int keyLength, RString privFilename, RString pubFilename ) { }
 void CryptManager::SignFileToFile( RString sPath, RString sSignatureFile ) { }
 bool CryptManager::VerifyFileWithFile( RString sPath, RString sSignatureFile, RString sPublicKeyFile ) { return true; }
@@ -89,6 +261,9 @@ static const int KEY_LENGTH = 1024;
  */
 
 static PRNGWrapper *g_pPRNG = nullptr;
+/* Profiles are signed by ProfileWriter, while the main thread may be reading
+ * random bytes. */
+static RageMutex g_PRNGLock( "PRNG" );
 ltc_math_descriptor ltc_mp = ltm_desc;
 
 CryptManager::CryptManager()
@@ -138,6 +313,7 @@ void CryptManager::GenerateGlobalKeys()
 
 CryptManager::~CryptManager()
 {
+	SaveFileDigests();
 	SAFE_DELETE( g_pPRNG );
 	// Unregister with Lua.
 	LUA->UnsetGlobal( "CRYPTMAN" );
@@ -168,7 +344,9 @@ void CryptManager::GenerateRSAKey( unsigned int keyLength, RString &sPrivKey, RS
 	int iRet;
 
 	rsa_key key;
+	g_PRNGLock.Lock();
 	iRet = rsa_make_key( &g_pPRNG->m_PRNG, g_pPRNG->m_iPRNG, keyLength / 8, 65537, &key );
+	g_PRNGLock.Unlock();
 	if( iRet != CRYPT_OK )
 	{
 		LOG->Warn( "GenerateRSAKey(%i) error: %s", keyLength, error_to_string(iRet) );
@@ -252,21 +430,22 @@ bool CryptManager::Sign( RString sPath, RString &sSignatureOut, RString sPrivKey
 		return false;
 	}
 
-	int iHash = register_hash( &sha1_desc );
-	ASSERT( iHash >= 0 );
+	int iHash = CryptHash::GetRegisteredIndex( CryptHash::SHA1 );
 
 	unsigned char buf_hash[20];
-	if( !HashFile(file, buf_hash, iHash) )
+	if( !HashFile(file, buf_hash, CryptHash::SHA1) )
 		return false;
 
 	unsigned char signature[256];
 	unsigned long signature_len = sizeof(signature);
 
+	g_PRNGLock.Lock();
 	int iRet = rsa_sign_hash_ex(
 			buf_hash, sizeof(buf_hash),
 			signature, &signature_len,
 			LTC_PKCS_1_V1_5, &g_pPRNG->m_PRNG, g_pPRNG->m_iPRNG, iHash,
 			0, &key.m_Key);
+	g_PRNGLock.Unlock();
 	if( iRet != CRYPT_OK )
 	{
 		LOG->Warn( "SignFileToFile error: %s", error_to_string(iRet) );
@@ -333,11 +512,10 @@ bool CryptManager::Verify( RageFileBasic &file, RString sSignature, RString sPub
 		return false;
 	}
 
-	int iHash = register_hash( &sha1_desc );
-	ASSERT( iHash >= 0 );
+	int iHash = CryptHash::GetRegisteredIndex( CryptHash::SHA1 );
 
 	unsigned char buf_hash[20];
-	HashFile( file, buf_hash, iHash );
+	HashFile( file, buf_hash, CryptHash::SHA1 );
 
 	int iMatch;
 	int iRet = rsa_verify_hash_ex( (const unsigned char *) sSignature.data(), sSignature.size(),
@@ -361,6 +539,7 @@ bool CryptManager::Verify( RageFileBasic &file, RString sSignature, RString sPub
 
 void CryptManager::GetRandomBytes( void *pData, int iBytes )
 {
+	LockMut( g_PRNGLock );
 	int iRet = prng_descriptor[g_pPRNG->m_iPRNG].read( (unsigned char *) pData, iBytes, &g_pPRNG->m_PRNG );
 	ASSERT( iRet == iBytes );
 }
@@ -368,31 +547,16 @@ void CryptManager::GetRandomBytes( void *pData, int iBytes )
 
 RString CryptManager::GetMD5ForFile( RString fn )
 {
-	RageFile file;
-	if( !file.Open( fn, RageFile::READ ) )
-	{
-		LOG->Warn( "GetMD5: Failed to open file '%s'", fn.c_str() );
-		return RString();
-	}
-	int iHash = register_hash( &md5_desc );
-	ASSERT( iHash >= 0 );
-
-	unsigned char digest[16];
-	HashFile( file, digest, iHash );
-
-	return RString( (const char *) digest, sizeof(digest) );
+	return GetFileDigest( fn, DIGEST_MD5 );
 }
 
 RString CryptManager::GetMD5ForString( RString sData )
 {
 	unsigned char digest[16];
 
-	int iHash = register_hash( &md5_desc );
-
-	hash_state hash;
-	hash_descriptor[iHash].init( &hash );
-	hash_descriptor[iHash].process( &hash, (const unsigned char *) sData.data(), sData.size() );
-	hash_descriptor[iHash].done( &hash, digest );
+	CryptHash hash( CryptHash::MD5 );
+	hash.Process( sData.data(), sData.size() );
+	hash.Finish( digest );
 
 	return RString( (const char *) digest, sizeof(digest) );
 }
@@ -401,62 +565,42 @@ RString CryptManager::GetSHA1ForString( RString sData )
 {
 	unsigned char digest[20];
 
-	int iHash = register_hash( &sha1_desc );
-
-	hash_state hash;
-	hash_descriptor[iHash].init( &hash );
-	hash_descriptor[iHash].process( &hash, (const unsigned char *) sData.data(), sData.size() );
-	hash_descriptor[iHash].done( &hash, digest );
+	CryptHash hash( CryptHash::SHA1 );
+	hash.Process( sData.data(), sData.size() );
+	hash.Finish( digest );
 
 	return RString( (const char *) digest, sizeof(digest) );
 }
 
 RString CryptManager::GetSHA1ForFile( RString fn )
 {
-	RageFile file;
-	if( !file.Open( fn, RageFile::READ ) )
-	{
-		LOG->Warn( "GetSHA1: Failed to open file '%s'", fn.c_str() );
-		return RString();
-	}
-	int iHash = register_hash( &sha1_desc );
-	ASSERT( iHash >= 0 );
-
-	unsigned char digest[20];
-	HashFile( file, digest, iHash );
+	return GetFileDigest( fn, DIGEST_SHA1 );
+}
 
-	return RString( (const char *) digest, sizeof(digest) );
+void CryptManager::GetSHA1ForFiles( const std::vector<RString> &vsPaths, std::vector<RString> &vsDigestsOut )
+{
+	GetFileDigests( vsPaths, DIGEST_SHA1, vsDigestsOut );
 }
 
 RString CryptManager::GetSHA256ForString( RString sData )
 {
 	unsigned char digest[32];
 
-	int iHash = register_hash( &sha256_desc );
-
-	hash_state hash;
-	hash_descriptor[iHash].init( &hash );
-	hash_descriptor[iHash].process( &hash, (const unsigned char *) sData.data(), sData.size() );
-	hash_descriptor[iHash].done( &hash, digest );
+	CryptHash hash( CryptHash::SHA256 );
+	hash.Process( sData.data(), sData.size() );
+	hash.Finish( digest );
 
 	return RString( (const char *) digest, sizeof(digest) );
 }
 
 RString CryptManager::GetSHA256ForFile( RString fn )
 {
-	RageFile file;
-	if( !file.Open( fn, RageFile::READ ) )
-	{
-		LOG->Warn( "GetSHA256: Failed to open file '%s'", fn.c_str() );
-		return RString();
-	}
-	int iHash = register_hash( &sha256_desc );
-	ASSERT( iHash >= 0 );
-
-	unsigned char digest[32];
-	HashFile( file, digest, iHash );
+	return GetFileDigest( fn, DIGEST_SHA256 );
+}
 
-	return RString( (const char *) digest, sizeof(digest) );
+void CryptManager::GetSHA256ForFiles( const std::vector<RString> &vsPaths, std::vector<RString> &vsDigestsOut )
+{
+	GetFileDigests( vsPaths, DIGEST_SHA256, vsDigestsOut );
 }
 
 RString CryptManager::GetPublicKeyFileName()
@@ -531,6 +675,24 @@ public:
 		lua_pushlstring(L, sha256fout, sha256fout.size());
 		return 1;
 	}
+	static int SHA1Files( T* p, lua_State *L )
+	{
+		std::vector<RString> vsPaths, vsDigests;
+		lua_pushvalue( L, 1 );
+		LuaHelpers::ReadArrayFromTable( vsPaths, L );
+		p->GetSHA1ForFiles( vsPaths, vsDigests );
+		LuaHelpers::CreateTableFromArray( vsDigests, L );
+		return 1;
+	}
+	static int SHA256Files( T* p, lua_State *L )
+	{
+		std::vector<RString> vsPaths, vsDigests;
+		lua_pushvalue( L, 1 );
+		LuaHelpers::ReadArrayFromTable( vsPaths, L );
+		p->GetSHA256ForFiles( vsPaths, vsDigests );
+		LuaHelpers::CreateTableFromArray( vsDigests, L );
+		return 1;
+	}
 	static int GenerateRandomUUID( T* p, lua_State *L )
 	{
 		RString uuidOut;
@@ -547,6 +709,8 @@ public:
 		ADD_METHOD( SHA1File );
 		ADD_METHOD( SHA256String );
 		ADD_METHOD( SHA256File );
+		ADD_METHOD( SHA1Files );
+		ADD_METHOD( SHA256Files );
 		ADD_METHOD( GenerateRandomUUID );
 	}
 };
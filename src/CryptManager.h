@@ -1,6 +1,8 @@
 #ifndef CryptManager_H
 #define CryptManager_H
 
+#include <vector>
+
 class RageFileBasic;
 struct lua_State;
 
@@ -31,6 +33,12 @@ public:
 	static RString GetSHA256ForString( RString sData ); // in binary
 	static RString GetSHA256ForFile( RString fn );      // in binary
 
+	/* Hash each of vsPaths on worker threads, and put the digests in
+	 * vsDigestsOut in the same order.  A file that can't be read gets an
+	 * empty digest. */
+	static void GetSHA1ForFiles( const std::vector<RString> &vsPaths, std::vector<RString> &vsDigestsOut );
+	static void GetSHA256ForFiles( const std::vector<RString> &vsPaths, std::vector<RString> &vsDigestsOut );
+
 	static RString GetPublicKeyFileName();
 
 	// Lua
@@ -9,24 +9,60 @@
 #include "ThemeManager.h"
 #include "FontCharmaps.h"
 #include "FontCharAliases.h"
+#include "Preference.h"
+#include "RageThreads.h"
 #include "arch/Dialog/Dialog.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
 #include <vector>
 
 
+static Preference<bool> g_bLazyFontPages( "LazyFontPages", true );
+
+/* Held while loading a deferred page, which may be first used by a loading
+ * thread and the main thread at once. */
+static RageMutex g_DeferredPageLock( "DeferredFontPage" );
+
 FontPage::FontPage(): m_iHeight(0), m_iLineSpacing(0), m_fVshift(0),
 	m_iDrawExtraPixelsLeft(0), m_iDrawExtraPixelsRight(0),
 	m_FontPageTextures(), m_sTexturePath(""), m_aGlyphs(),
-	m_iCharToGlyphNo() {}
+	m_iCharToGlyphNo(), m_pDeferredSettings(nullptr), m_bDeferred(false) {}
+
+void FontPage::Defer( const FontPageSettings &cfg )
+{
+	m_sTexturePath = cfg.m_sTexturePath;
+	m_iCharToGlyphNo = cfg.CharToGlyphNo;
+
+	/* The texture takes its frame layout from the file name, too. */
+	int iFramesWide, iFramesHigh;
+	RageTexture::GetFrameDimensionsFromFileName( m_sTexturePath, &iFramesWide, &iFramesHigh );
+	glyph g;
+	g.m_pPage = this;
+	m_aGlyphs.assign( std::max(iFramesWide*iFramesHigh, 1), g );
+
+	m_pDeferredSettings = new FontPageSettings( cfg );
+	m_bDeferred.store( true, std::memory_order_release );
+}
+
+void FontPage::LoadDeferred()
+{
+	LockMut( g_DeferredPageLock );
+	if( !m_bDeferred.load(std::memory_order_relaxed) )
+		return;
+
+	Load( *m_pDeferredSettings );
+	SAFE_DELETE( m_pDeferredSettings );
+	m_bDeferred.store( false, std::memory_order_release );
+}
 
 void FontPage::Load( const FontPageSettings &cfg )
 {
 	m_sTexturePath = cfg.m_sTexturePath;
 
 	// load texture
-	RageTextureID ID1( m_sTexturePath );
+	RageTextureID ID1( FONT->GetPageTexturePath(m_sTexturePath) );
 	if( cfg.m_sTextureHints != "default" )
 		ID1.AdditionalTextureHints = cfg.m_sTextureHints;
 
@@ -147,7 +183,13 @@ void FontPage::Load( const FontPageSettings &cfg )
 
 void FontPage::SetTextureCoords( const std::vector<int> &widths, int iAdvanceExtraPixels )
 {
-	for(int i = 0; i < m_FontPageTextures.m_pTextureMain->GetNumFrames(); ++i)
+	/* A deferred page's glyphs already exist, and fonts point at them, so they
+	 * must be filled in, not replaced. */
+	const int iNumFrames = m_FontPageTextures.m_pTextureMain->GetNumFrames();
+	if( (int) m_aGlyphs.size() < iNumFrames )
+		m_aGlyphs.resize( iNumFrames );
+
+	for(int i = 0; i < iNumFrames; ++i)
 	{
 		glyph g;
 
@@ -189,8 +231,13 @@ void FontPage::SetTextureCoords( const std::vector<int> &widths, int iAdvanceExt
 
 		g.m_FontPageTextures = m_FontPageTextures;
 
-		m_aGlyphs.push_back(g);
+		m_aGlyphs[i] = g;
 	}
+
+	/* If the texture turned out to have fewer frames than its name said, as
+	 * when it fails to load, don't leave placeholders behind. */
+	for( unsigned i = iNumFrames; i < m_aGlyphs.size(); ++i )
+		m_aGlyphs[i] = m_aGlyphs[0];
 }
 
 void FontPage::SetExtraPixels( int iDrawExtraPixelsLeft, int iDrawExtraPixelsRight )
@@ -225,6 +272,7 @@ void FontPage::SetExtraPixels( int iDrawExtraPixelsLeft, int iDrawExtraPixelsRig
 
 FontPage::~FontPage()
 {
+	delete m_pDeferredSettings;
 	if( m_FontPageTextures.m_pTextureMain != nullptr )
 	{
 		TEXTUREMAN->UnloadTexture( m_FontPageTextures.m_pTextureMain );
@@ -292,6 +340,10 @@ void Font::Unload()
 		delete m_apPages[i];
 	m_apPages.clear();
 
+	for( Font *pFont : m_apImportedFonts )
+		FONT->UnloadFont( pFont );
+	m_apImportedFonts.clear();
+
 	m_iCharToGlyph.clear();
 	m_pDefault = nullptr;
 
@@ -322,7 +374,7 @@ void Font::AddPage( FontPage *m_pPage )
 	}
 }
 
-void Font::MergeFont(Font &f)
+void Font::MergeFont( const Font &f )
 {
 	/* If we don't have a font page yet, and f does, grab the default font
 	 * page.  It'll usually be overridden later on by one of our own font
@@ -331,18 +383,42 @@ void Font::MergeFont(Font &f)
 	if( m_pDefault == nullptr )
 		m_pDefault = f.m_pDefault;
 
-	for(std::map<wchar_t,glyph*>::iterator it = f.m_iCharToGlyph.begin();
+	for(std::map<wchar_t,glyph*>::const_iterator it = f.m_iCharToGlyph.begin();
 		it != f.m_iCharToGlyph.end(); ++it)
 	{
 		m_iCharToGlyph[it->first] = it->second;
 	}
+}
 
-	m_apPages.insert( m_apPages.end(), f.m_apPages.begin(), f.m_apPages.end() );
+void Font::GetPageStats( int &iLoadedPages, int &iDeferredPages, std::vector<const RageTexture *> &vpTexturesOut ) const
+{
+	iLoadedPages = iDeferredPages = 0;
+	for( const FontPage *pPage : m_apPages )
+	{
+		if( pPage->IsDeferred() )
+		{
+			++iDeferredPages;
+			continue;
+		}
 
-	f.m_apPages.clear();
+		++iLoadedPages;
+		if( pPage->m_FontPageTextures.m_pTextureMain != nullptr )
+			vpTexturesOut.push_back( pPage->m_FontPageTextures.m_pTextureMain );
+		if( pPage->m_FontPageTextures.m_pTextureStroke != nullptr &&
+			pPage->m_FontPageTextures.m_pTextureStroke != pPage->m_FontPageTextures.m_pTextureMain )
+			vpTexturesOut.push_back( pPage->m_FontPageTextures.m_pTextureStroke );
+	}
 }
 
 const glyph &Font::GetGlyph( wchar_t c ) const
+{
+	const glyph &g = FindGlyph( c );
+	if( unlikely(g.m_pPage->IsDeferred()) )
+		g.m_pPage->LoadDeferred();
+	return g;
+}
+
+const glyph &Font::FindGlyph( wchar_t c ) const
 {
 	/* XXX: This is kind of nasty, but the parts that touch this are dark and
 	 * scary. --Colby
@@ -381,7 +457,7 @@ bool Font::FontCompleteForString( const std::wstring &str ) const
 	for( unsigned i = 0; i < str.size(); ++i )
 	{
 		// If the glyph for this character is the default glyph, we're incomplete.
-		const glyph &g = GetGlyph( str[i] );
+		const glyph &g = FindGlyph( str[i] );
 		if( &g == mapDefault->second )
 			return false;
 	}
@@ -828,9 +904,11 @@ void Font::Load( const RString &sIniPath, RString sChars )
 				continue;
 			}
 
-			Font subfont;
-			subfont.Load(sPath,"");
-			MergeFont(subfont);
+			/* Imported fonts are shared, so the pages of fonts that everything
+			 * imports, like "Common default", are only loaded once. */
+			Font *pSubfont = FONT->LoadImportedFont( sPath );
+			MergeFont( *pSubfont );
+			m_apImportedFonts.push_back( pSubfont );
 		}
 	}
 
@@ -854,8 +932,12 @@ void Font::Load( const RString &sIniPath, RString sChars )
 		LoadFontPageSettings( cfg, ini, sTexturePath, "common", sChars );
 		LoadFontPageSettings( cfg, ini, sTexturePath, sPagename, sChars );
 
-		// Load.
-		pPage->Load( cfg );
+		/* Only the default page is needed to lay out text.  Load the others,
+		 * like the big CJK pages of translated themes, when they're used. */
+		if( i == 0 || sPagename == "main" || !g_bLazyFontPages )
+			pPage->Load( cfg );
+		else
+			pPage->Defer( cfg );
 
 		/* Expect at least as many frames as we have premapped characters. */
 		/* Make sure that we don't map characters to frames we don't actually
@@ -863,14 +945,14 @@ void Font::Load( const RString &sIniPath, RString sChars )
 		for(std::map<wchar_t,int>::iterator it = pPage->m_iCharToGlyphNo.begin();
 			it != pPage->m_iCharToGlyphNo.end(); ++it)
 		{
-			if( it->second < pPage->m_FontPageTextures.m_pTextureMain->GetNumFrames() )
+			if( it->second < pPage->GetNumFrames() )
 				continue; /* OK */
 			LuaHelpers::ReportScriptErrorFmt(
 				"The font \"%s\" maps \"%s\" to frame %i, "
 				"but the font only has %i frames.",
 				sTexturePath.c_str(), WcharDisplayText(wchar_t(it->first)).c_str(),
 				it->second,
-				pPage->m_FontPageTextures.m_pTextureMain->GetNumFrames());
+				pPage->GetNumFrames());
 			it->second= 0;
 		}
 
@@ -893,15 +975,12 @@ void Font::Load( const RString &sIniPath, RString sChars )
 
 	LoadStack.pop_back();
 
-	if( LoadStack.empty() )
-	{
-		// Cache ASCII glyphs.
-		ZERO( m_iCharToGlyphCache );
-		std::map<wchar_t,glyph*>::iterator it;
-		for( it = m_iCharToGlyph.begin(); it != m_iCharToGlyph.end(); ++it )
-			if( it->first < (int) ARRAYLEN(m_iCharToGlyphCache) )
-				m_iCharToGlyphCache[it->first] = it->second;
-	}
+	// Cache ASCII glyphs.  Imported fonts are kept now, so they need it too.
+	ZERO( m_iCharToGlyphCache );
+	std::map<wchar_t,glyph*>::iterator it;
+	for( it = m_iCharToGlyph.begin(); it != m_iCharToGlyph.end(); ++it )
+		if( it->first < (int) ARRAYLEN(m_iCharToGlyphCache) )
+			m_iCharToGlyphCache[it->first] = it->second;
 }
 
 /*
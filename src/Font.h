@@ -7,6 +7,7 @@
 #include "RageUtil.h"
 #include "RageTypes.h"
 
+#include <atomic>
 #include <cstddef>
 #include <map>
 #include <vector>
@@ -120,6 +121,15 @@ public:
 
 	void Load( const FontPageSettings &cfg );
 
+	/* Set up the page's glyphs and character map, but don't load its texture
+	 * or work out its metrics until one of its glyphs is used.  Until then,
+	 * the glyphs are only placeholders. */
+	void Defer( const FontPageSettings &cfg );
+	bool IsDeferred() const { return m_bDeferred.load( std::memory_order_acquire ); }
+	void LoadDeferred();
+
+	int GetNumFrames() const { return (int) m_aGlyphs.size(); }
+
 	// Page-global properties.
 	int m_iHeight;
 	int m_iLineSpacing;
@@ -143,6 +153,10 @@ public:
 private:
 	void SetExtraPixels( int iDrawExtraPixelsLeft, int DrawExtraPixelsRight );
 	void SetTextureCoords( const std::vector<int> &aiWidths, int iAdvanceExtraPixels );
+
+	/* Set by Defer, and kept until the page is loaded. */
+	FontPageSettings *m_pDeferredSettings;
+	std::atomic<bool> m_bDeferred;
 };
 
 class Font
@@ -169,9 +183,11 @@ public:
 	void AddPage(FontPage *fp);
 
 	/**
-	 * @brief Steal all of a font's pages.
-	 * @param f the font whose pages we are stealing. */
-	void MergeFont(Font &f);
+	 * @brief Use all of another font's glyphs.
+	 *
+	 * The glyphs still belong to f, so f must outlive this font.
+	 * @param f the font whose glyphs we are using. */
+	void MergeFont( const Font &f );
 
 	void Load(const RString &sFontOrTextureFilePath, RString sChars);
 	void Unload();
@@ -186,6 +202,10 @@ public:
 
 	void SetDefaultGlyph( FontPage *pPage );
 
+	/* For FontManager's memory report: this font's own pages, not counting
+	 * the pages of fonts it imports. */
+	void GetPageStats( int &iLoadedPages, int &iDeferredPages, std::vector<const RageTexture *> &vpTexturesOut ) const;
+
 	bool IsRightToLeft() const { return m_bRightToLeft; };
 	bool IsDistanceField() const { return m_bDistanceField; };
 	const RageColor &GetDefaultStrokeColor() const { return m_DefaultStrokeColor; };
@@ -193,6 +213,8 @@ public:
 private:
 	/** @brief List of pages and fonts that we use (and are responsible for freeing). */
 	std::vector<FontPage *> m_apPages;
+	/** @brief Fonts we import, from FontManager, whose glyphs we use. */
+	std::vector<Font *> m_apImportedFonts;
 
 	/**
 	 * @brief This is the primary fontpage of this font.
@@ -201,6 +223,9 @@ private:
 	 * (This is one of pages[].) */
 	FontPage *m_pDefault;
 
+	/* Look up a glyph without loading its page. */
+	const glyph &FindGlyph( wchar_t c ) const;
+
 	/** @brief Map from characters to glyphs. */
 	std::map<wchar_t,glyph*> m_iCharToGlyph;
 	/** @brief Each glyph is part of one of the pages[]. */
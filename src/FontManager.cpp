@@ -3,13 +3,35 @@
 #include "Font.h"
 #include "RageUtil.h"
 #include "RageLog.h"
+#include "RageTexture.h"
+#include "RageThreads.h"
+#include "RageFileManager.h"
+
+#include <algorithm>
 #include <map>
+#include <set>
 
 FontManager*	FONT	= nullptr;	// global and accessible from anywhere in our program
 
 // map from file name to a texture holder
 typedef std::pair<RString,RString> FontName;
 static std::map<FontName, Font*> g_mapPathToFont;
+static std::map<RString, Font*> g_mapPathToImportedFont;
+
+/* Fonts release the fonts they import when they're deleted, but at shutdown
+ * everything is being deleted anyway. */
+static bool g_bShuttingDown = false;
+
+/* Page textures with the same file name and size are candidates for being
+ * the same page; only those are compared by content. */
+static RageMutex g_PageFilesLock( "FontManager page files" );
+static std::map<RString, std::vector<RString> > g_mapNameAndSizeToPages;
+struct PageContent
+{
+	unsigned iFileHash; // size and modification time, when iCRC was taken
+	unsigned iCRC;
+};
+static std::map<RString, PageContent> g_mapPageToContent;
 
 FontManager::FontManager()
 {
@@ -17,6 +39,8 @@ FontManager::FontManager()
 
 FontManager::~FontManager()
 {
+	g_bShuttingDown = true;
+
 	for( std::map<FontName, Font*>::iterator i = g_mapPathToFont.begin();
 		i != g_mapPathToFont.end(); ++i)
 	{
@@ -27,6 +51,14 @@ FontManager::~FontManager()
 		}
 		delete pFont;
 	}
+	g_mapPathToFont.clear();
+
+	for( std::map<RString, Font*>::iterator i = g_mapPathToImportedFont.begin();
+		i != g_mapPathToImportedFont.end(); ++i )
+		delete i->second;
+	g_mapPathToImportedFont.clear();
+
+	g_bShuttingDown = false;
 }
 
 Font* FontManager::LoadFont( const RString &sFontOrTextureFilePath, RString sChars )
@@ -53,18 +85,31 @@ Font* FontManager::LoadFont( const RString &sFontOrTextureFilePath, RString sCha
 	return f;
 }
 
+Font *FontManager::LoadImportedFont( const RString &sIniPath )
+{
+	std::map<RString, Font*>::iterator p = g_mapPathToImportedFont.find( sIniPath );
+	if( p != g_mapPathToImportedFont.end() )
+	{
+		p->second->m_iRefCount++;
+		return p->second;
+	}
+
+	Font *f = new Font;
+	f->Load( sIniPath, "" );
+	g_mapPathToImportedFont[sIniPath] = f;
+	return f;
+}
+
 Font *FontManager::CopyFont( Font *pFont )
 {
 	++pFont->m_iRefCount;
 	return pFont;
 }
 
-void FontManager::UnloadFont( Font *fp )
+template<typename Map>
+static bool ReleaseFont( Map &map, Font *fp )
 {
-	CHECKPOINT_M( ssprintf("FontManager::UnloadFont(%s).", fp->path.c_str()) );
-
-	for( std::map<FontName, Font*>::iterator i = g_mapPathToFont.begin();
-		i != g_mapPathToFont.end(); ++i)
+	for( typename Map::iterator i = map.begin(); i != map.end(); ++i )
 	{
 		if(i->second != fp)
 			continue;
@@ -75,15 +120,129 @@ void FontManager::UnloadFont( Font *fp )
 
 		if( fp->m_iRefCount == 0 )
 		{
-			delete i->second;		// free the texture
-			g_mapPathToFont.erase( i );	// and remove the key in the map
+			/* Remove it first; deleting it releases the fonts it imports,
+			 * which come back through here. */
+			map.erase( i );		// remove the key in the map
+			delete fp;		// and free the texture
 		}
-		return;
+		return true;
 	}
+	return false;
+}
+
+void FontManager::UnloadFont( Font *fp )
+{
+	if( g_bShuttingDown )
+		return;
+
+	CHECKPOINT_M( ssprintf("FontManager::UnloadFont(%s).", fp->path.c_str()) );
+
+	if( ReleaseFont(g_mapPathToFont, fp) || ReleaseFont(g_mapPathToImportedFont, fp) )
+		return;
 
 	FAIL_M( ssprintf("Unloaded an unknown font (%p)", static_cast<void*>(fp)) );
 }
 
+static bool GetPageCRC( const RString &sPath, unsigned &iCRCOut )
+{
+	const unsigned iFileHash = GetHashForFile( sPath );
+	std::map<RString, PageContent>::const_iterator it = g_mapPageToContent.find( sPath );
+	if( it != g_mapPageToContent.end() && it->second.iFileHash == iFileHash )
+	{
+		iCRCOut = it->second.iCRC;
+		return true;
+	}
+
+	RString sData;
+	if( !GetFileContents(sPath, sData) )
+		return false;
+
+	/* The stroke layer is loaded alongside, so it has to match, too. */
+	RString sStrokePath = sPath;
+	sStrokePath.Replace( "]", "-stroke]" );
+	RString sStrokeData;
+	if( sStrokePath != sPath && IsAFile(sStrokePath) )
+		GetFileContents( sStrokePath, sStrokeData );
+
+	unsigned iCRC = 0;
+	CRC32( iCRC, sData.data(), sData.size() );
+	CRC32( iCRC, sStrokeData.data(), sStrokeData.size() );
+
+	PageContent &content = g_mapPageToContent[sPath];
+	content.iFileHash = iFileHash;
+	content.iCRC = iCRC;
+	iCRCOut = iCRC;
+	return true;
+}
+
+RString FontManager::GetPageTexturePath( const RString &sTexturePath )
+{
+	/* The frame layout and texture hints come from the file name, so only
+	 * files with the same name can be interchanged.  Most pages have no
+	 * candidates at all, and are never read here. */
+	RString sName = Basename( sTexturePath );
+	sName.MakeLower();
+	const RString sKey = ssprintf( "%s|%i", sName.c_str(), FILEMAN->GetFileSizeInBytes(sTexturePath) );
+
+	LockMut( g_PageFilesLock );
+	std::vector<RString> &vsPages = g_mapNameAndSizeToPages[sKey];
+	unsigned iCRC = 0;
+	bool bHaveCRC = false;
+	for( const RString &sPage : vsPages )
+	{
+		if( sPage == sTexturePath )
+			return sTexturePath;
+
+		if( !bHaveCRC )
+		{
+			if( !GetPageCRC(sTexturePath, iCRC) )
+				return sTexturePath;
+			bHaveCRC = true;
+		}
+
+		unsigned iPageCRC;
+		if( GetPageCRC(sPage, iPageCRC) && iPageCRC == iCRC )
+			return sPage;
+	}
+
+	vsPages.push_back( sTexturePath );
+	return sTexturePath;
+}
+
+void FontManager::DiagnosticOutput() const
+{
+	LOG->Trace( "%u fonts loaded, %u imported:", unsigned(g_mapPathToFont.size()), unsigned(g_mapPathToImportedFont.size()) );
+
+	std::set<const RageTexture *> setAllTextures;
+	std::vector<std::pair<RString, const Font *> > vFonts;
+	for( const std::pair<const FontName, Font *> &font : g_mapPathToFont )
+		vFonts.push_back( std::make_pair(font.first.first, font.second) );
+	for( const std::pair<const RString, Font *> &font : g_mapPathToImportedFont )
+		vFonts.push_back( std::make_pair(font.first + " (imported)", font.second) );
+
+	for( const std::pair<RString, const Font *> &font : vFonts )
+	{
+		int iLoaded, iDeferred;
+		std::vector<const RageTexture *> vpTextures;
+		font.second->GetPageStats( iLoaded, iDeferred, vpTextures );
+
+		int iTexels = 0;
+		for( const RageTexture *pTexture : vpTextures )
+		{
+			iTexels += pTexture->GetTextureWidth() * pTexture->GetTextureHeight();
+			setAllTextures.insert( pTexture );
+		}
+
+		LOG->Trace( " %-48s (%2i) %i pages, %i not loaded, %i texels",
+			Basename(font.first).c_str(), font.second->m_iRefCount, iLoaded+iDeferred, iDeferred, iTexels );
+	}
+
+	int iTotal = 0;
+	for( const RageTexture *pTexture : setAllTextures )
+		iTotal += pTexture->GetTextureWidth() * pTexture->GetTextureHeight();
+	LOG->Trace( "total %i texels in %u font textures", iTotal, unsigned(setAllTextures.size()) );
+}
+
 /*
 void FontManager::PruneFonts() {
 	for( std::map<FontName, Font*>::iterator i = g_mapPathToFont.begin();i != g_mapPathToFont.end();) {
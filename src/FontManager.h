@@ -16,6 +16,19 @@ public:
 	Font *CopyFont( Font *pFont );
 	void UnloadFont( Font *fp );
 	//void PruneFonts();
+
+	/* Fonts imported by other fonts are shared between them, and kept apart
+	 * from fonts loaded with LoadFont, since a top-level font also imports
+	 * the default font.  Release with UnloadFont. */
+	Font *LoadImportedFont( const RString &sIniPath );
+
+	/* Return the path of an identical font page texture that's already been
+	 * seen, so that themes shipping copies of the same pages only load them
+	 * once; or sTexturePath if there isn't one. */
+	RString GetPageTexturePath( const RString &sTexturePath );
+
+	/* Log each font's pages and texture size. */
+	void DiagnosticOutput() const;
 };
 
 extern FontManager*	FONT;	// global and accessible from anywhere in our program
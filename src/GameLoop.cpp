@@ -13,11 +13,13 @@
 #include "SongManager.h"
 #include "GameState.h"
 #include "MemoryCardManager.h"
+#include "ProfileWriter.h"
 #include "ScreenManager.h"
 #include "InputFilter.h"
 #include "InputMapper.h"
 #include "RageFileManager.h"
 #include "LightsManager.h"
+#include "MessageManager.h"
 #include "RageTimer.h"
 #include "RageInput.h"
 
@@ -286,6 +288,7 @@ void GameLoop::UpdateAllButDraw(bool bRunningFromVBLANK)
 	GAMESTATE->Update(fDeltaTime);
 	SCREENMAN->Update(fDeltaTime);
 	MEMCARDMAN->Update();
+	ProfileWriter::Update();
 
 	/* Important: Process input AFTER updating game logic, or input will be
 	* acting on song beat from last frame */
@@ -330,6 +333,7 @@ void GameLoop::RunGameLoop()
 				SCREENMAN->SystemMessage( sMessage );
 		}
 
+		MESSAGEMAN->FlushDeferredMessages();
 		SCREENMAN->Draw();
 	}
 
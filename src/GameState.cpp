@@ -26,6 +26,7 @@
 #include "PrefsManager.h"
 #include "Profile.h"
 #include "ProfileManager.h"
+#include "ProfileWriter.h"
 #include "RageFile.h"
 #include "RageFileManager.h"
 #include "RageLog.h"
@@ -648,7 +649,10 @@ void GameState::SavePlayerProfile( PlayerNumber pn )
 		MEMCARDMAN->MountCard( pn );
 	PROFILEMAN->SaveProfile( pn );
 	if( bWasMemoryCard )
-		MEMCARDMAN->UnmountCard( pn );
+	{
+		// The card can't be unmounted until the profile is on it.
+		ProfileWriter::WhenIdle( MEM_CARD_MOUNT_POINT[pn], [pn]() { MEMCARDMAN->UnmountCard(pn); } );
+	}
 }
 
 bool GameState::HaveProfileToLoad()
@@ -7,6 +7,7 @@
 #include "ThemeManager.h"
 
 #include <cstddef>
+#include <typeinfo>
 
 REGISTER_ACTOR_CLASS( GradeDisplay );
 
@@ -42,6 +43,11 @@ void GradeDisplay::SetGrade( Grade grade )
 	}
 }
 
+bool GradeDisplay::IsIdle() const
+{
+	return typeid(*this) == typeid(GradeDisplay) && FrameIsIdle();
+}
+
 // lua start
 #include "LuaBinding.h"
 
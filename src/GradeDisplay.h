@@ -22,6 +22,8 @@ public:
 	// Lua
 	void PushSelf( lua_State *L );
 protected:
+	virtual bool IsIdle() const;
+
 	std::vector<AutoActor>	m_vSpr;
 };
 
@@ -16,12 +16,15 @@
 #include "RageSurfaceUtils_Palettize.h"
 #include "RageSurfaceUtils_Dither.h"
 #include "RageSurfaceUtils_Zoom.h"
+#include "RageTimer.h"
+#include "RageUtil_ThreadPool.h"
 #include "SpecialFiles.h"
 #include "Banner.h"
 
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <future>
 
 static Preference<bool> g_bPalettedImageCache( "PalettedImageCache", false );
 
@@ -115,6 +118,13 @@ void ImageCache::LoadImage( RString sImageDir, RString sImagePath )
 	    PREFSMAN->m_ImageCache != IMGCACHE_LOW_RES_LOAD_ON_DEMAND )
 		return;
 
+	if( m_bBatching )
+	{
+		if( g_ImagePathToImage.find(sImagePath) == g_ImagePathToImage.end() )
+			QueueBatchImage( m_vBatchLoad, sImageDir, sImagePath );
+		return;
+	}
+
 	/* Load it. */
 	const RString sCachePath = GetImageCachePath(sImageDir,sImagePath);
 
@@ -172,7 +182,7 @@ void ImageCache::UnloadAllImages()
 }
 
 ImageCache::ImageCache()
-	: delay_save_cache(false)
+	: delay_save_cache(false), m_bBatching(false)
 {
 	ReadFromDisk();
 }
@@ -371,19 +381,16 @@ void ImageCache::CacheImage( RString sImageDir, RString sImagePath )
 
 	/* The cache file doesn't exist, or is out of date.  Cache it.  This
 	 * will also load the cache into memory if in PRELOAD. */
-	CacheImageInternal( sImageDir, sImagePath );
+	if( m_bBatching )
+		QueueBatchImage( m_vBatchCache, sImageDir, sImagePath );
+	else
+		CacheImageInternal( sImageDir, sImagePath );
 }
 
-void ImageCache::CacheImageInternal( RString sImageDir, RString sImagePath )
+/* Scale a freshly decoded image down and convert it to the cached format.
+ * This only touches pImage, so it's safe to call from worker threads. */
+static void ShrinkImageForCache( RageSurface *&pImage )
 {
-	RString sError;
-	RageSurface *pImage = RageSurfaceUtils::LoadFile( sImagePath, sError );
-	if( pImage == nullptr )
-	{
-		LOG->UserLog( "Cache file", sImagePath, "couldn't be loaded: %s", sError.c_str() );
-		return;
-	}
-
 	const int iSourceWidth = pImage->w, iSourceHeight = pImage->h;
 
 	int iWidth = pImage->w / 2, iHeight = pImage->h / 2;
@@ -436,7 +443,26 @@ void ImageCache::CacheImageInternal( RString sImageDir, RString sImagePath )
 		delete pImage;
 		pImage = dst;
 	}
+}
 
+void ImageCache::CacheImageInternal( RString sImageDir, RString sImagePath )
+{
+	RString sError;
+	RageSurface *pImage = RageSurfaceUtils::LoadFile( sImagePath, sError );
+	if( pImage == nullptr )
+	{
+		LOG->UserLog( "Cache file", sImagePath, "couldn't be loaded: %s", sError.c_str() );
+		return;
+	}
+
+	const int iSourceWidth = pImage->w, iSourceHeight = pImage->h;
+	ShrinkImageForCache( pImage );
+	StoreCachedImage( sImageDir, sImagePath, pImage, iSourceWidth, iSourceHeight );
+}
+
+/* Write a shrunk image to the cache and record it.  Takes ownership of pImage. */
+void ImageCache::StoreCachedImage( RString sImageDir, RString sImagePath, RageSurface *pImage, int iSourceWidth, int iSourceHeight )
+{
 	const RString sCachePath = GetImageCachePath(sImageDir,sImagePath);
 	RageSurfaceUtils::SaveSurface( pImage, sCachePath );
 
@@ -470,6 +496,85 @@ void ImageCache::WriteToDisk()
 	ImageData.WriteFile(IMAGE_CACHE_INDEX);
 }
 
+void ImageCache::QueueBatchImage( std::vector<std::pair<RString, RString>> &vQueue, RString sImageDir, RString sImagePath )
+{
+	if( !m_BatchQueued.insert(sImagePath).second )
+		return;
+	vQueue.push_back( std::make_pair(sImageDir, sImagePath) );
+}
+
+void ImageCache::BeginBatch()
+{
+	ASSERT( !m_bBatching );
+	m_bBatching = true;
+}
+
+void ImageCache::FinishBatch()
+{
+	ASSERT( m_bBatching );
+	m_bBatching = false;
+
+	std::vector<std::pair<RString, RString>> vLoad, vCache;
+	vLoad.swap( m_vBatchLoad );
+	vCache.swap( m_vBatchCache );
+	m_BatchQueued.clear();
+	if( vLoad.empty() && vCache.empty() )
+		return;
+
+	RageTimer tm;
+	RageThreadPool pool( "ImageCache" );
+
+	/* Read existing cache files first.  Any that are missing get cached from
+	 * the original image, like LoadImage does. */
+	std::vector<std::future<RageSurface *>> vLoaded;
+	for( auto const &img : vLoad )
+	{
+		const RString sCachePath = GetImageCachePath( img.first, img.second );
+		vLoaded.push_back( pool.Submit( [sCachePath]() { return RageSurfaceUtils::LoadSurface( sCachePath ); } ) );
+	}
+
+	int iLoaded = 0;
+	for( unsigned i = 0; i < vLoad.size(); ++i )
+	{
+		RageSurface *pImage = vLoaded[i].get();
+		const RString &sImagePath = vLoad[i].second;
+		if( pImage == nullptr )
+		{
+			vCache.push_back( vLoad[i] );
+			continue;
+		}
+
+		++iLoaded;
+		if( g_ImagePathToImage.find(sImagePath) != g_ImagePathToImage.end() )
+			delete pImage; /* already loaded */
+		else
+			g_ImagePathToImage[sImagePath] = pImage;
+	}
+
+	std::vector<RString> vsSourcePaths;
+	for( auto const &img : vCache )
+		vsSourcePaths.push_back( img.second );
+
+	std::vector<std::future<RageSurfaceUtils::LoadResult>> vDecoded =
+		RageSurfaceUtils::LoadFiles( pool, vsSourcePaths, ShrinkImageForCache );
+
+	for( unsigned i = 0; i < vCache.size(); ++i )
+	{
+		RageSurfaceUtils::LoadResult res = vDecoded[i].get();
+		if( res.pSurface == nullptr )
+		{
+			LOG->UserLog( "Cache file", vCache[i].second, "couldn't be loaded: %s", res.sError.c_str() );
+			continue;
+		}
+
+		StoreCachedImage( vCache[i].first, vCache[i].second, res.pSurface, res.iSourceWidth, res.iSourceHeight );
+	}
+
+	LOG->Trace( "ImageCache: loaded %i and cached %i images on %i threads in %f seconds.",
+		iLoaded, (int) vsSourcePaths.size(),
+		pool.GetNumThreads(), tm.GetDeltaTime() );
+}
+
 
 /*
  * (c) 2003 Glenn Maynard
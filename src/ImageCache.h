@@ -5,7 +5,12 @@
 
 #include "RageTexture.h"
 
+#include <set>
+#include <utility>
+#include <vector>
+
 class LoadingWindow;
+struct RageSurface;
 /** @brief Maintains a cache of reduced-quality images. */
 class ImageCache
 {
@@ -24,14 +29,26 @@ public:
 
 	void OutputStats() const;
 
+	/* Between BeginBatch and FinishBatch, CacheImage and LoadImage only queue
+	 * their work; FinishBatch then decodes everything queued concurrently. */
+	void BeginBatch();
+	void FinishBatch();
+
 	bool delay_save_cache;
 
 private:
 	static RString GetImageCachePath( RString sImageDir, RString sImagePath );
 	void UnloadAllImages();
 	void CacheImageInternal( RString sImageDir, RString sImagePath );
+	void StoreCachedImage( RString sImageDir, RString sImagePath, RageSurface *pImage, int iSourceWidth, int iSourceHeight );
+	void QueueBatchImage( std::vector<std::pair<RString, RString>> &vQueue, RString sImageDir, RString sImagePath );
 
 	IniFile ImageData;
+
+	bool m_bBatching;
+	std::vector<std::pair<RString, RString>> m_vBatchLoad;
+	std::vector<std::pair<RString, RString>> m_vBatchCache;
+	std::set<RString> m_BatchQueued;
 };
 
 extern ImageCache *IMAGECACHE; // global and accessible from anywhere in our program
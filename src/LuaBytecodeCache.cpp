@@ -0,0 +1,184 @@
+#include "global.h"
+#include "LuaBytecodeCache.h"
+#include "ActorPrefetcher.h"
+#include "LuaManager.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageLog.h"
+#include "RageUtil.h"
+#include "Preference.h"
+#include "SpecialFiles.h"
+
+#include <cstdint>
+
+static Preference<bool> g_bLuaBytecodeCache( "LuaBytecodeCache", true );
+
+static const std::uint32_t BYTECODE_CACHE_VERSION = 1;
+static const std::uint32_t BYTECODE_CACHE_MAGIC = 0x3143424c; // "LBC1"
+
+#define BYTECODE_CACHE_DIR (SpecialFiles::CACHE_DIR + "Lua/")
+
+struct CacheHeader
+{
+	std::uint32_t magic, version;
+	/* The source file's size and modification time. */
+	std::uint32_t iFileHash;
+	std::uint32_t iBytecodeSize;
+};
+
+/* Paths may or may not have a leading slash. */
+static RString GetRelativePath( const RString &sPath )
+{
+	if( BeginsWith(sPath, "/") )
+		return sPath.substr( 1 );
+	return sPath;
+}
+
+static bool IsCacheable( const RString &sFile )
+{
+	if( !g_bLuaBytecodeCache )
+		return false;
+
+	const RString sPath = GetRelativePath( sFile );
+	return BeginsWith( sPath, SpecialFiles::THEMES_DIR ) || BeginsWith( sPath, SpecialFiles::NOTESKINS_DIR );
+}
+
+static RString GetCachePath( const RString &sFile )
+{
+	return BYTECODE_CACHE_DIR + GetRelativePath( sFile ) + "c";
+}
+
+static bool ReadCached( const RString &sFile, const RString &sCachePath, RString &sBytecode )
+{
+	RageFile f;
+	if( !f.Open(sCachePath) )
+		return false;
+
+	CacheHeader h;
+	if( f.Read(&h, sizeof(h)) != sizeof(h) )
+		return false;
+	if( h.magic != BYTECODE_CACHE_MAGIC || h.version != BYTECODE_CACHE_VERSION )
+		return false;
+	if( h.iFileHash != (std::uint32_t) GetHashForFile(sFile) )
+		return false;
+
+	return f.Read( sBytecode, h.iBytecodeSize ) == (int) h.iBytecodeSize;
+}
+
+static bool LoadBytecode( lua_State *L, const RString &sFile, const RString &sBytecode )
+{
+	/* The chunk carries the name it was compiled with, which is the same. */
+	if( luaL_loadbuffer(L, sBytecode.data(), sBytecode.size(), "@" + sFile) != 0 )
+	{
+		LOG->Trace( "Ignoring compiled bytecode for \"%s\": %s", sFile.c_str(), lua_tostring(L, -1) );
+		lua_pop( L, 1 );
+		return false;
+	}
+
+	return true;
+}
+
+static bool LoadCached( lua_State *L, const RString &sFile, const RString &sCachePath )
+{
+	RString sBytecode;
+	return ReadCached( sFile, sCachePath, sBytecode ) && LoadBytecode( L, sFile, sBytecode );
+}
+
+static int DumpWriter( lua_State *L, const void *p, std::size_t iSize, void *pData )
+{
+	((RString *) pData)->append( (const char *) p, iSize );
+	return 0;
+}
+
+static void WriteCached( const RString &sFile, const RString &sCachePath, const RString &sBytecode )
+{
+	CacheHeader h;
+	h.magic = BYTECODE_CACHE_MAGIC;
+	h.version = BYTECODE_CACHE_VERSION;
+	h.iFileHash = GetHashForFile( sFile );
+	h.iBytecodeSize = sBytecode.size();
+
+	RageFile f;
+	if( !f.Open(sCachePath, RageFile::WRITE) )
+	{
+		LOG->Trace( "Couldn't write Lua bytecode cache file \"%s\": %s", sCachePath.c_str(), f.GetError().c_str() );
+		return;
+	}
+
+	f.Write( &h, sizeof(h) );
+	f.Write( sBytecode );
+	if( f.Flush() == -1 )
+	{
+		f.Close();
+		FILEMAN->Remove( sCachePath );
+	}
+}
+
+/* Save the chunk at the top of the stack. */
+static void SaveCached( lua_State *L, const RString &sFile, const RString &sCachePath )
+{
+	RString sBytecode;
+	if( lua_dump(L, DumpWriter, &sBytecode) != 0 || sBytecode.empty() )
+		return;
+	WriteCached( sFile, sCachePath, sBytecode );
+}
+
+bool LuaBytecodeCache::LoadFile( lua_State *L, const RString &sFile, RString &sError )
+{
+	const bool bCacheable = IsCacheable( sFile );
+	const RString sCachePath = bCacheable? GetCachePath( sFile ): RString();
+
+	RString sBytecode;
+	if( ActorPrefetcher::TakeChunk(sFile, sBytecode) && LoadBytecode(L, sFile, sBytecode) )
+		return true;
+	if( bCacheable && LoadCached(L, sFile, sCachePath) )
+		return true;
+
+	RString sScript;
+	if( !GetFileContents(sFile, sScript) )
+	{
+		sError = ssprintf( "Couldn't read \"%s\"", sFile.c_str() );
+		return false;
+	}
+
+	if( !LuaHelpers::LoadScript(L, sScript, "@" + sFile, sError) )
+		return false;
+
+	/* Scripts with errors are never cached, so they're reported every time. */
+	if( bCacheable )
+		SaveCached( L, sFile, sCachePath );
+	return true;
+}
+
+bool LuaBytecodeCache::CompileFile( const RString &sFile, RString &sBytecode, RString &sError )
+{
+	const bool bCacheable = IsCacheable( sFile );
+	const RString sCachePath = bCacheable? GetCachePath( sFile ): RString();
+	if( bCacheable && ReadCached(sFile, sCachePath, sBytecode) )
+		return true;
+
+	RString sScript;
+	if( !GetFileContents(sFile, sScript) )
+	{
+		sError = ssprintf( "Couldn't read \"%s\"", sFile.c_str() );
+		return false;
+	}
+
+	/* The chunk doesn't run here, so a bare state without libraries will do. */
+	lua_State *L = luaL_newstate();
+	bool bCompiled = false;
+	if( luaL_loadbuffer(L, sScript.data(), sScript.size(), "@" + sFile) != 0 )
+	{
+		sError = lua_tostring( L, -1 );
+	}
+	else
+	{
+		sBytecode.clear();
+		bCompiled = lua_dump( L, DumpWriter, &sBytecode ) == 0 && !sBytecode.empty();
+	}
+	lua_close( L );
+
+	if( bCompiled && bCacheable )
+		WriteCached( sFile, sCachePath, sBytecode );
+	return bCompiled;
+}
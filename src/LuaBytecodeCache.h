@@ -0,0 +1,24 @@
+/* LuaBytecodeCache - a disk cache of compiled theme and noteskin Lua files. */
+
+#ifndef LUA_BYTECODE_CACHE_H
+#define LUA_BYTECODE_CACHE_H
+
+struct lua_State;
+
+/* Most theme and noteskin scripts don't change between runs, so their
+ * compiled chunks are kept under Cache/Lua/, keyed by the source file's
+ * path, size and modification time.  Lua checks a bytecode chunk's header
+ * before loading it, so a cache written by a different build is just
+ * ignored, and the file is compiled from source again. */
+namespace LuaBytecodeCache
+{
+	/* Load sFile as a chunk and push it.  On error, push nothing, set sError
+	 * and return false. */
+	bool LoadFile( lua_State *L, const RString &sFile, RString &sError );
+
+	/* Compile sFile, or read it from the cache, without touching any Lua
+	 * state, so it can be done from any thread. */
+	bool CompileFile( const RString &sFile, RString &sBytecode, RString &sError );
+}
+
+#endif
@@ -1,5 +1,7 @@
 #include "global.h"
 #include "LuaManager.h"
+#include "LuaBytecodeCache.h"
+#include "LuaProfiler.h"
 #include "LuaReference.h"
 #include "RageUtil.h"
 #include "RageLog.h"
@@ -11,6 +13,7 @@
 #include "RageLog.h"
 #include "RageTypes.h"
 #include "MessageManager.h"
+#include "DateTime.h"
 #include "ver.h"
 
 #include <cassert>
@@ -30,6 +33,8 @@ struct Impl
 	std::map<lua_State *, bool> g_ActiveStates;
 
 	RageMutex g_pLock;
+
+	LuaProfiler m_Profiler;
 };
 static Impl *pImpl = nullptr;
 
@@ -315,6 +320,9 @@ void LuaManager::Release( Lua *&p )
 {
 	pImpl->g_FreeStateList.push_back( p );
 
+	if( pImpl->m_Profiler.IsRunning() )
+		pImpl->m_Profiler.FinishState( p );
+
 	ASSERT( lua_gettop(p) == 0 );
 	ASSERT( pImpl->g_ActiveStates.find(p) != pImpl->g_ActiveStates.end() );
 	bool bDoUnlock = pImpl->g_ActiveStates[p];
@@ -363,6 +371,67 @@ void LuaManager::UnyieldLua()
 	pImpl->g_pLock.Lock();
 }
 
+void LuaManager::StartProfiling()
+{
+	Lua *L = Get();
+	if( !pImpl->m_Profiler.IsRunning() )
+	{
+		LOG->Trace( "Lua profiling started" );
+		pImpl->m_Profiler.Clear();
+		pImpl->m_Profiler.SetRunning( true );
+
+		/* New threads inherit the hook from the main state. */
+		pImpl->m_Profiler.Attach( m_pLuaMain );
+		for( lua_State *pState : pImpl->g_FreeStateList )
+			pImpl->m_Profiler.Attach( pState );
+		for( const std::pair<lua_State * const, bool> &state : pImpl->g_ActiveStates )
+			pImpl->m_Profiler.Attach( state.first );
+	}
+	Release( L );
+}
+
+RString LuaManager::StopProfiling()
+{
+	Lua *L = Get();
+	if( !pImpl->m_Profiler.IsRunning() )
+	{
+		Release( L );
+		return RString();
+	}
+
+	pImpl->m_Profiler.SetRunning( false );
+	pImpl->m_Profiler.Detach( m_pLuaMain );
+	for( lua_State *pState : pImpl->g_FreeStateList )
+		pImpl->m_Profiler.Detach( pState );
+	for( const std::pair<lua_State * const, bool> &state : pImpl->g_ActiveStates )
+		pImpl->m_Profiler.Detach( state.first );
+
+	const RString sReport = pImpl->m_Profiler.GetReport( 100 );
+	const RString sFolded = pImpl->m_Profiler.GetFoldedStacks();
+	pImpl->m_Profiler.Clear();
+	Release( L );
+
+	RString sBase = "/Logs/LuaProfile " + DateTime::GetNowDateTime().GetString();
+	sBase.Replace( ":", "" );
+	sBase.Replace( " ", "_" );
+
+	RageFile f;
+	if( f.Open(sBase + ".txt", RageFile::WRITE) )
+		f.PutLine( sReport );
+	f.Close();
+	if( f.Open(sBase + ".folded", RageFile::WRITE) )
+		f.Write( sFolded );
+	f.Close();
+
+	LOG->Trace( "Lua profiling stopped; wrote %s.txt and %s.folded", sBase.c_str(), sBase.c_str() );
+	return sBase + ".txt";
+}
+
+bool LuaManager::IsProfiling() const
+{
+	return pImpl->m_Profiler.IsRunning();
+}
+
 void LuaManager::RegisterTypes()
 {
 	Lua *L = Get();
@@ -761,14 +830,10 @@ XNode *LuaHelpers::GetLuaInformation()
 
 bool LuaHelpers::RunScriptFile( const RString &sFile )
 {
-	RString sScript;
-	if( !GetFileContents(sFile, sScript) )
-		return false;
-
 	Lua *L = LUA->Get();
 
 	RString sError;
-	if( !LuaHelpers::RunScript( L, sScript, "@" + sFile, sError, 0 ) )
+	if( !LuaBytecodeCache::LoadFile(L, sFile, sError) || !LuaHelpers::RunScriptOnStack(L, sError, 0, 0) )
 	{
 		LUA->Release( L );
 		sError = ssprintf( "Lua runtime error: %s", sError.c_str() );
@@ -863,6 +928,29 @@ bool LuaHelpers::RunScriptOnStack( Lua *L, RString &Error, int Args, int ReturnV
 	return true;
 }
 
+bool LuaHelpers::RunScriptOnStackAndReport( Lua *L, const char *szErrorPrefix, int Args, int ReturnValues )
+{
+	lua_pushcfunction( L, GetLuaStack );
+	int ErrFunc = lua_gettop(L) - Args - 1;
+	lua_insert( L, ErrFunc );
+
+	int ret = lua_pcall( L, Args, ReturnValues, ErrFunc );
+	if( ret )
+	{
+		RString Error = szErrorPrefix, lerror;
+		LuaHelpers::Pop( L, lerror );
+		Error += lerror;
+		ReportScriptError( Error );
+		lua_remove( L, ErrFunc );
+		for( int i = 0; i < ReturnValues; ++i )
+			lua_pushnil( L );
+		return false;
+	}
+
+	lua_remove( L, ErrFunc );
+	return true;
+}
+
 bool LuaHelpers::RunScript( Lua *L, const RString &Script, const RString &Name, RString &Error, int Args, int ReturnValues, bool ReportError )
 {
 	RString lerror;
@@ -895,7 +983,7 @@ bool LuaHelpers::RunExpression( Lua *L, const RString &sExpression, const RStrin
 	return true;
 }
 
-void LuaHelpers::ParseCommandList( Lua *L, const RString &sCommands, const RString &sName, bool bLegacy )
+RString LuaHelpers::GetCommandListScript( const RString &sCommands, bool bLegacy )
 {
 	RString sLuaFunction;
 	if( sCommands.size() > 0 && sCommands[0] == '\033' )
@@ -976,6 +1064,13 @@ void LuaHelpers::ParseCommandList( Lua *L, const RString &sCommands, const RStri
 		sLuaFunction = s.str();
 	}
 
+	return sLuaFunction;
+}
+
+void LuaHelpers::ParseCommandList( Lua *L, const RString &sCommands, const RString &sName, bool bLegacy )
+{
+	const RString sLuaFunction = GetCommandListScript( sCommands, bLegacy );
+
 	RString sError;
 	if( !LuaHelpers::RunScript(L, sLuaFunction, sName, sError, 0, 1) )
 		LOG->Warn( "Compiling \"%s\": %s", sLuaFunction.c_str(), sError.c_str() );
@@ -1077,6 +1172,18 @@ namespace
 		LOG->Flush();
 		return 0;
 	}
+	/* Like ReadFile followed by load, but goes through the bytecode cache. */
+	static int LoadFile( lua_State *L )
+	{
+		RString sError;
+		if( !LuaBytecodeCache::LoadFile(L, SArg(1), sError) )
+		{
+			lua_pushnil( L );
+			LuaHelpers::Push( L, sError );
+			return 2;
+		}
+		return 1;
+	}
 	static int CheckType( lua_State *L )
 	{
 		RString sType = SArg(1);
@@ -1169,6 +1276,7 @@ namespace
 		LIST_METHOD( Flush ),
 		LIST_METHOD( CheckType ),
 		LIST_METHOD( ReadFile ),
+		LIST_METHOD( LoadFile ),
 		LIST_METHOD( RunWithThreadVariables ),
 		LIST_METHOD( GetThreadVariable ),
 		LIST_METHOD( ReportScriptError ),
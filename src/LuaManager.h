@@ -50,6 +50,13 @@ public:
 	void SetGlobal( const RString &sName, const RString &val );
 	void UnsetGlobal( const RString &sName );
 
+	/* Time every Lua call until profiling is stopped.  Stopping writes a
+	 * report of the hottest functions and a flame graph of the call paths to
+	 * the Logs directory, and returns the report's path. */
+	void StartProfiling();
+	RString StopProfiling();
+	bool IsProfiling() const;
+
 private:
 	lua_State *m_pLuaMain;
 	// Swallow up warnings. If they must be used, define them.
@@ -88,6 +95,10 @@ namespace LuaHelpers
 	 * SCREENMAN->SystemMessage.
 	 */
 	bool RunScriptOnStack( Lua *L, RString &Error, int Args = 0, int ReturnValues = 0, bool ReportError = false );
+	/* The same, reporting any error with the given prefix.  For callers that
+	 * run every frame, so they don't build an error string that's almost
+	 * never used. */
+	bool RunScriptOnStackAndReport( Lua *L, const char *szErrorPrefix, int Args = 0, int ReturnValues = 0 );
 
 	/* LoadScript the given script, and RunScriptOnStack it.
 	 * iArgs arguments are at the top of the stack. */
@@ -114,6 +125,8 @@ namespace LuaHelpers
 	void ReadArrayFromTableB( Lua *L, std::vector<bool> &aOut );
 
 	void ParseCommandList( lua_State *L, const RString &sCommands, const RString &sName, bool bLegacy );
+	/* The chunk ParseCommandList runs, which returns the command function. */
+	RString GetCommandListScript( const RString &sCommands, bool bLegacy );
 
 	XNode *GetLuaInformation();
 
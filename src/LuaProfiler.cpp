@@ -0,0 +1,289 @@
+#include "global.h"
+#include "LuaProfiler.h"
+#include "LuaManager.h"
+#include "RageTimer.h"
+#include "RageUtil.h"
+
+#include <algorithm>
+#include <cstring>
+
+static LuaProfiler *g_pProfiler = nullptr;
+
+/* The root of the call tree, which stands for whatever C++ called into Lua. */
+static const int ROOT_NODE = 0;
+
+LuaProfiler::LuaProfiler()
+{
+	ASSERT( g_pProfiler == nullptr );
+	g_pProfiler = this;
+	m_bRunning = false;
+	Clear();
+}
+
+LuaProfiler::~LuaProfiler()
+{
+	g_pProfiler = nullptr;
+}
+
+void LuaProfiler::Clear()
+{
+	m_Functions.clear();
+	m_FunctionsByAddress.clear();
+	m_FunctionsByName.clear();
+	m_Stacks.clear();
+	m_iOverhead = 0;
+
+	m_Nodes.clear();
+	Node root;
+	root.iFunction = -1;
+	root.iParent = -1;
+	root.iFirstChild = root.iNextSibling = -1;
+	root.iCalls = root.iSelfTime = root.iTotalTime = 0;
+	m_Nodes.push_back( root );
+}
+
+void LuaProfiler::Attach( lua_State *L )
+{
+	lua_sethook( L, Hook, LUA_MASKCALL | LUA_MASKRET, 0 );
+}
+
+void LuaProfiler::Detach( lua_State *L )
+{
+	lua_sethook( L, nullptr, 0, 0 );
+	FinishState( L );
+}
+
+void LuaProfiler::FinishState( lua_State *L )
+{
+	std::unordered_map<lua_State *, std::vector<Frame>>::iterator it = m_Stacks.find( L );
+	if( it == m_Stacks.end() )
+		return;
+	PopFrames( it->second, 0, RageTimer::GetUsecsSinceStart() - m_iOverhead );
+	m_Stacks.erase( it );
+}
+
+void LuaProfiler::Hook( lua_State *L, lua_Debug *ar )
+{
+	LuaProfiler *pThis = g_pProfiler;
+
+	/* Coroutines created while we were running keep the hook; drop it lazily. */
+	if( pThis == nullptr || !pThis->m_bRunning )
+	{
+		lua_sethook( L, nullptr, 0, 0 );
+		return;
+	}
+
+	const std::uint64_t iEnter = RageTimer::GetUsecsSinceStart();
+	const std::uint64_t iNow = iEnter - pThis->m_iOverhead;
+	std::vector<Frame> &stack = pThis->m_Stacks[L];
+
+	/* i_ci is the depth of the call being entered or left.  Anything at or
+	 * above it that's still open was either replaced by a tail call or
+	 * unwound by an error, so close it first.  That also makes TAILRET
+	 * events unnecessary. */
+	switch( ar->event )
+	{
+	case LUA_HOOKCALL:
+	{
+		pThis->PopFrames( stack, ar->i_ci, iNow );
+		const int iParent = stack.empty()? ROOT_NODE: stack.back().iNode;
+		Frame frame;
+		frame.iNode = pThis->GetChildNode( iParent, pThis->GetFunction(L, ar) );
+		frame.iLevel = ar->i_ci;
+		frame.iStart = iNow;
+		frame.iChildTime = 0;
+		stack.push_back( frame );
+		break;
+	}
+	case LUA_HOOKRET:
+		pThis->PopFrames( stack, ar->i_ci, iNow );
+		break;
+	}
+
+	pThis->m_iOverhead += RageTimer::GetUsecsSinceStart() - iEnter;
+}
+
+void LuaProfiler::PopFrames( std::vector<Frame> &stack, int iLevel, std::uint64_t iNow )
+{
+	while( !stack.empty() && stack.back().iLevel >= iLevel )
+	{
+		const Frame &frame = stack.back();
+		const std::uint64_t iElapsed = iNow - frame.iStart;
+		Node &node = m_Nodes[frame.iNode];
+		++node.iCalls;
+		node.iTotalTime += iElapsed;
+		node.iSelfTime += iElapsed - std::min( iElapsed, frame.iChildTime );
+		stack.pop_back();
+
+		if( !stack.empty() )
+			stack.back().iChildTime += iElapsed;
+	}
+}
+
+int LuaProfiler::GetFunction( lua_State *L, lua_Debug *ar )
+{
+	lua_getinfo( L, "S", ar );
+
+	std::pair<const void *, int> key;
+	const bool bCFunction = ar->what[0] == 'C';
+	if( bCFunction )
+	{
+		lua_getinfo( L, "f", ar );
+		key.first = (const void *) lua_tocfunction( L, -1 );
+		key.second = -1;
+		lua_pop( L, 1 );
+	}
+	else
+	{
+		key.first = ar->source;
+		key.second = ar->linedefined;
+	}
+
+	std::map<std::pair<const void *, int>, int>::const_iterator it = m_FunctionsByAddress.find( key );
+	if( it != m_FunctionsByAddress.end() )
+	{
+		if( bCFunction || strcmp(m_Functions[it->second].sSource, ar->source) == 0 )
+			return it->second;
+	}
+
+	/* Name the function after whatever it was first called as. */
+	lua_getinfo( L, "n", ar );
+	RString sName = ar->name != nullptr? RString(ar->name): RString( ar->what[0] == 'm'? "(main chunk)": "(anonymous)" );
+
+	RString sFullName;
+	if( bCFunction )
+		sFullName = ssprintf( "%s [C %p]", sName.c_str(), key.first );
+	else
+		sFullName = ssprintf( "%s (%s:%i)", sName.c_str(), ar->short_src, ar->linedefined );
+	/* Semicolons separate frames in the folded output. */
+	sFullName.Replace( ";", ":" );
+
+	/* The same function may already be known under an older source string. */
+	const RString sLookup = bCFunction? sFullName: ssprintf( "%s:%i", ar->source, ar->linedefined );
+	std::map<RString, int>::const_iterator byName = m_FunctionsByName.find( sLookup );
+	int iFunction;
+	if( byName != m_FunctionsByName.end() )
+	{
+		iFunction = byName->second;
+	}
+	else
+	{
+		Function func;
+		func.sSource = ar->source;
+		func.iLine = ar->linedefined;
+		func.sDisplayName = sFullName;
+		iFunction = m_Functions.size();
+		m_Functions.push_back( func );
+		m_FunctionsByName[sLookup] = iFunction;
+	}
+
+	m_FunctionsByAddress[key] = iFunction;
+	return iFunction;
+}
+
+int LuaProfiler::GetChildNode( int iParent, int iFunction )
+{
+	for( int i = m_Nodes[iParent].iFirstChild; i != -1; i = m_Nodes[i].iNextSibling )
+		if( m_Nodes[i].iFunction == iFunction )
+			return i;
+
+	Node node;
+	node.iFunction = iFunction;
+	node.iParent = iParent;
+	node.iFirstChild = -1;
+	node.iNextSibling = m_Nodes[iParent].iFirstChild;
+	node.iCalls = node.iSelfTime = node.iTotalTime = 0;
+	const int iNode = m_Nodes.size();
+	m_Nodes.push_back( node );
+	m_Nodes[iParent].iFirstChild = iNode;
+	return iNode;
+}
+
+/* Sum each function's inclusive time, skipping calls made while the same
+ * function is already on the stack, so recursion isn't counted twice. */
+void LuaProfiler::GetFunctionTotals( int iNode, std::vector<int> &viActive, std::vector<std::uint64_t> &viTotal ) const
+{
+	const Node &node = m_Nodes[iNode];
+	if( node.iFunction != -1 )
+	{
+		if( viActive[node.iFunction] == 0 )
+			viTotal[node.iFunction] += node.iTotalTime;
+		++viActive[node.iFunction];
+	}
+
+	for( int i = node.iFirstChild; i != -1; i = m_Nodes[i].iNextSibling )
+		GetFunctionTotals( i, viActive, viTotal );
+
+	if( node.iFunction != -1 )
+		--viActive[node.iFunction];
+}
+
+RString LuaProfiler::GetReport( int iMaxFunctions ) const
+{
+	struct Stats
+	{
+		int iFunction;
+		std::uint64_t iCalls, iSelfTime, iTotalTime;
+	};
+	std::vector<Stats> vStats( m_Functions.size() );
+	for( unsigned i = 0; i < vStats.size(); ++i )
+	{
+		vStats[i].iFunction = i;
+		vStats[i].iCalls = vStats[i].iSelfTime = vStats[i].iTotalTime = 0;
+	}
+
+	std::uint64_t iTotalTime = 0;
+	for( const Node &node : m_Nodes )
+	{
+		if( node.iFunction == -1 )
+			continue;
+		vStats[node.iFunction].iCalls += node.iCalls;
+		vStats[node.iFunction].iSelfTime += node.iSelfTime;
+		iTotalTime += node.iSelfTime;
+	}
+
+	std::vector<int> viActive( m_Functions.size(), 0 );
+	std::vector<std::uint64_t> viTotal( m_Functions.size(), 0 );
+	GetFunctionTotals( ROOT_NODE, viActive, viTotal );
+	for( unsigned i = 0; i < vStats.size(); ++i )
+		vStats[i].iTotalTime = viTotal[i];
+
+	std::sort( vStats.begin(), vStats.end(), []( const Stats &a, const Stats &b ) { return a.iSelfTime > b.iSelfTime; } );
+	if( (int) vStats.size() > iMaxFunctions )
+		vStats.resize( iMaxFunctions );
+
+	RString sRet = ssprintf( "%.3fms in Lua, %i functions\n", iTotalTime / 1000.0, (int) m_Functions.size() );
+	sRet += ssprintf( "%10s %6s %10s %10s  %s\n", "self ms", "self%", "total ms", "calls", "function" );
+	for( const Stats &s : vStats )
+	{
+		sRet += ssprintf( "%10.3f %5.1f%% %10.3f %10llu  %s\n",
+			s.iSelfTime / 1000.0, iTotalTime? 100.0 * s.iSelfTime / iTotalTime: 0.0,
+			s.iTotalTime / 1000.0, (unsigned long long) s.iCalls,
+			m_Functions[s.iFunction].sDisplayName.c_str() );
+	}
+	return sRet;
+}
+
+void LuaProfiler::GetFoldedStacks( int iNode, const RString &sPath, RString &sOut ) const
+{
+	const Node &node = m_Nodes[iNode];
+	RString sThisPath = sPath;
+	if( node.iFunction != -1 )
+	{
+		if( !sThisPath.empty() )
+			sThisPath += ";";
+		sThisPath += m_Functions[node.iFunction].sDisplayName;
+		if( node.iSelfTime > 0 )
+			sOut += ssprintf( "%s %llu\n", sThisPath.c_str(), (unsigned long long) node.iSelfTime );
+	}
+
+	for( int i = node.iFirstChild; i != -1; i = m_Nodes[i].iNextSibling )
+		GetFoldedStacks( i, sThisPath, sOut );
+}
+
+RString LuaProfiler::GetFoldedStacks() const
+{
+	RString sRet;
+	GetFoldedStacks( ROOT_NODE, RString(), sRet );
+	return sRet;
+}
@@ -0,0 +1,92 @@
+/* LuaProfiler - measures where time goes in Lua, with a call and return hook. */
+
+#ifndef LUA_PROFILER_H
+#define LUA_PROFILER_H
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+struct lua_State;
+struct lua_Debug;
+
+/* Time and call counts are gathered per function (source file and the line
+ * it's defined on), and per call path.  The call paths are written in the
+ * folded stack format used by flamegraph.pl and speedscope.
+ *
+ * All Lua runs under the LuaManager lock, so this is only ever used by one
+ * thread at a time; LuaManager takes care of that. */
+class LuaProfiler
+{
+public:
+	LuaProfiler();
+	~LuaProfiler();
+
+	/* Install or remove the hook on L.  Threads created from a hooked state
+	 * inherit the hook. */
+	void Attach( lua_State *L );
+	void Detach( lua_State *L );
+
+	void SetRunning( bool bRunning ) { m_bRunning = bRunning; }
+	bool IsRunning() const { return m_bRunning; }
+	void Clear();
+
+	/* Close any calls still open on L.  An error unwinds Lua without running
+	 * return hooks, so this is called when a state goes back to the pool. */
+	void FinishState( lua_State *L );
+
+	/* A table of the functions with the most time spent in them. */
+	RString GetReport( int iMaxFunctions ) const;
+
+	/* One line per call path: "outer;inner;innermost <microseconds>". */
+	RString GetFoldedStacks() const;
+
+private:
+	static void Hook( lua_State *L, lua_Debug *ar );
+	int GetFunction( lua_State *L, lua_Debug *ar );
+	int GetChildNode( int iParent, int iFunction );
+
+	struct Frame
+	{
+		int iNode;
+		int iLevel;
+		std::uint64_t iStart, iChildTime;
+	};
+	void PopFrames( std::vector<Frame> &stack, int iLevel, std::uint64_t iNow );
+
+	struct Function
+	{
+		RString sSource;
+		int iLine;
+		RString sDisplayName;
+	};
+
+	/* A function at one position in the call tree. */
+	struct Node
+	{
+		int iFunction, iParent;
+		int iFirstChild, iNextSibling;
+		std::uint64_t iCalls, iSelfTime, iTotalTime;
+	};
+
+	void GetFunctionTotals( int iNode, std::vector<int> &viActive, std::vector<std::uint64_t> &viTotal ) const;
+	void GetFoldedStacks( int iNode, const RString &sPath, RString &sOut ) const;
+
+	bool m_bRunning;
+
+	std::vector<Function> m_Functions;
+	/* Lua functions are looked up by their source string's address, C
+	 * functions by their address.  The address is checked against the
+	 * source, in case the string was collected and reused. */
+	std::map<std::pair<const void *, int>, int> m_FunctionsByAddress;
+	std::map<RString, int> m_FunctionsByName;
+
+	std::vector<Node> m_Nodes;
+	std::unordered_map<lua_State *, std::vector<Frame>> m_Stacks;
+
+	/* Time spent inside the hook, which isn't charged to anything. */
+	std::uint64_t m_iOverhead;
+};
+
+#endif
@@ -11,6 +11,7 @@
 #include "RageUtil_WorkerThread.h"
 #include "arch/MemoryCard/MemoryCardDriver_Null.h"
 #include "LuaManager.h"
+#include "ProfileWriter.h"
 
 #include <cstddef>
 #include <vector>
@@ -649,6 +650,9 @@ void MemoryCardManager::UnmountCard( PlayerNumber pn )
 	if( !m_bMounted[pn] )
 		return;
 
+	// A saved profile may still be being written to the card.
+	ProfileWriter::Wait( MEM_CARD_MOUNT_POINT[pn] );
+
 	// Leave our own filesystem drivers mounted.  Unmount the kernel mount.
 	g_pWorker->Unmount( &m_Device[pn] );
 
@@ -5,9 +5,14 @@
 #include "EnumHelper.h"
 #include "LuaManager.h"
 #include "RageLog.h"
+#include "RageUtil_SlabAllocator.h"
 
-#include <set>
-#include <map>
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <deque>
+#include <string>
+#include <unordered_map>
 
 MessageManager*	MESSAGEMAN = nullptr;	// global and accessible from anywhere in our program
 
@@ -92,71 +97,241 @@ XToString( MessageID );
 
 static RageMutex g_Mutex( "MessageManager" );
 
-typedef std::set<IMessageSubscriber*> SubscribersSet;
-static std::map<RString,SubscribersSet> g_MessageToSubscribers;
+/* Messages are nearly always sent and subscribed to from the main thread, so
+ * it only takes g_Mutex while another thread is using messages too; mostly
+ * that's ConcurrentRenderer updating a loading screen.  Other threads count
+ * themselves in g_iOtherThreads before locking, then wait for the main thread
+ * to finish anything it started without the lock. */
+static thread_local bool g_bIsMainThread = false;
+static std::atomic<int> g_iOtherThreads( 0 );
+static std::atomic<int> g_iMainThreadUnlockedDepth( 0 );
+
+class MessageLock
+{
+public:
+	MessageLock()
+	{
+		m_bMainThread = g_bIsMainThread;
+		if( m_bMainThread )
+		{
+			/* Only the main thread writes this, so a nested call can just go on. */
+			if( g_iMainThreadUnlockedDepth.load(std::memory_order_relaxed) > 0 )
+			{
+				g_iMainThreadUnlockedDepth.fetch_add( 1, std::memory_order_relaxed );
+				m_bLocked = false;
+				return;
+			}
+
+			g_iMainThreadUnlockedDepth.store( 1 );
+			if( g_iOtherThreads.load() == 0 )
+			{
+				m_bLocked = false;
+				return;
+			}
+			g_iMainThreadUnlockedDepth.store( 0 );
+		}
+		else
+		{
+			++g_iOtherThreads;
+		}
+
+		g_Mutex.Lock();
+		m_bLocked = true;
+		if( !m_bMainThread )
+		{
+			while( g_iMainThreadUnlockedDepth.load() > 0 )
+				usleep( 100 );
+		}
+	}
+
+	~MessageLock()
+	{
+		if( !m_bLocked )
+		{
+			g_iMainThreadUnlockedDepth.fetch_sub( 1, std::memory_order_relaxed );
+			return;
+		}
+
+		g_Mutex.Unlock();
+		if( !m_bMainThread )
+			--g_iOtherThreads;
+	}
+
+private:
+	bool m_bMainThread;
+	bool m_bLocked;
+};
+
+/* Subscribers are kept in the order they subscribed.  A subscriber removed
+ * while its message is being delivered is nulled out, and the holes are
+ * closed up once delivery finishes. */
+struct MessageInfo
+{
+	MessageInfo(): iBroadcasting(0), bHasHoles(false), bDeferred(false), bCoalesce(false) { }
+	std::vector<IMessageSubscriber *> vpSubscribers;
+	int iBroadcasting;
+	bool bHasHoles;
+	bool bDeferred, bCoalesce;
+};
+
+/* Indexed by MessageSymbol.  A deque, so a handler that interns a new name
+ * doesn't move the list being delivered.  The MessageIDs are there from the
+ * start, since Message(MessageID) uses the ID as the symbol without interning
+ * it. */
+static std::deque<MessageInfo> g_Messages( NUM_MessageID );
+
+static std::unordered_map<std::string, MessageSymbol> MakeMessageIDSymbols()
+{
+	std::unordered_map<std::string, MessageSymbol> map;
+	for( int i = 0; i < NUM_MessageID; ++i )
+		map[MessageIDNames[i]] = i;
+	return map;
+}
+static std::unordered_map<std::string, MessageSymbol> g_NameToSymbol = MakeMessageIDSymbols();
+
+struct DeferredMessage
+{
+	Message *pMsg;
+	/* Coalesced messages replace an earlier one with the same symbol and key. */
+	bool bCoalesce;
+	RString sKey;
+};
+static std::vector<DeferredMessage> g_DeferredMessages;
+
+static MessageSymbol InternMessageNameLocked( const RString &sName )
+{
+	std::unordered_map<std::string, MessageSymbol>::const_iterator it = g_NameToSymbol.find( sName );
+	if( it != g_NameToSymbol.end() )
+		return it->second;
+
+	const MessageSymbol sym = g_Messages.size();
+	g_NameToSymbol[sName] = sym;
+	g_Messages.push_back( MessageInfo() );
+	return sym;
+}
+
+MessageSymbol InternMessageName( const RString &sName )
+{
+	MessageLock lock;
+	return InternMessageNameLocked( sName );
+}
+
+MessageSymbol FindMessageSymbol( const RString &sName )
+{
+	MessageLock lock;
+	std::unordered_map<std::string, MessageSymbol>::const_iterator it = g_NameToSymbol.find( sName );
+	if( it == g_NameToSymbol.end() )
+		return MessageSymbol_Invalid;
+	return it->second;
+}
+
+static RageSlabAllocator &GetMessageAllocator()
+{
+	static RageSlabAllocator *pAllocator = new RageSlabAllocator( "Message", sizeof(Message) );
+	return *pAllocator;
+}
+
+static RageSlabAllocator &GetParamTableAllocator()
+{
+	static RageSlabAllocator *pAllocator = new RageSlabAllocator( "Message params", sizeof(LuaTable) );
+	return *pAllocator;
+}
+
+void *Message::operator new( std::size_t iSize )
+{
+	return GetMessageAllocator().Allocate( iSize );
+}
+
+void Message::operator delete( void *p, std::size_t iSize )
+{
+	GetMessageAllocator().Free( p, iSize );
+}
 
 Message::Message( const RString &s )
 {
 	m_sName = s;
-	m_pParams = new LuaTable;
+	m_Symbol = InternMessageName( s );
+	m_pParams = nullptr;
 	m_bBroadcast = false;
 }
 
 Message::Message(const MessageID id)
 {
 	m_sName= MessageIDToString(id);
-	m_pParams = new LuaTable;
+	m_Symbol = id;
+	m_pParams = nullptr;
 	m_bBroadcast = false;
 }
 
 Message::Message( const RString &s, const LuaReference &params )
 {
 	m_sName = s;
+	m_Symbol = InternMessageName( s );
+	m_pParams = nullptr;
 	m_bBroadcast = false;
-	Lua *L = LUA->Get();
-	m_pParams = new LuaTable; // XXX: creates an extra table
-	params.PushSelf( L );
-	m_pParams->SetFromStack( L );
-	LUA->Release( L );
-//	m_pParams = new LuaTable( params );
+	SetParamTable( params );
 }
 
 Message::~Message()
 {
-	delete m_pParams;
+	if( m_pParams != nullptr )
+	{
+		m_pParams->~LuaTable();
+		GetParamTableAllocator().Free( m_pParams, sizeof(LuaTable) );
+	}
+}
+
+LuaTable &Message::GetParams() const
+{
+	if( m_pParams == nullptr )
+		m_pParams = new( GetParamTableAllocator().Allocate(sizeof(LuaTable)) ) LuaTable;
+	return *m_pParams;
+}
+
+void Message::SetName( const RString &sName )
+{
+	m_sName = sName;
+	m_Symbol = InternMessageName( sName );
 }
 
 void Message::PushParamTable( lua_State *L )
 {
-	m_pParams->PushSelf( L );
+	GetParams().PushSelf( L );
 }
 
 void Message::SetParamTable( const LuaReference &params )
 {
+	LuaTable &table = GetParams(); // XXX: creates an extra table
 	Lua *L = LUA->Get();
 	params.PushSelf( L );
-	m_pParams->SetFromStack( L );
+	table.SetFromStack( L );
 	LUA->Release( L );
 }
 
 const LuaReference &Message::GetParamTable() const
 {
-	return *m_pParams;
+	return GetParams();
 }
 
 void Message::GetParamFromStack( lua_State *L, const RString &sName ) const
 {
+	if( m_pParams == nullptr )
+	{
+		lua_pushnil( L );
+		return;
+	}
 	m_pParams->Get( L, sName );
 }
 
 void Message::SetParamFromStack( lua_State *L, const RString &sName )
 {
-	m_pParams->Set( L, sName );
+	GetParams().Set( L, sName );
 }
 
 MessageManager::MessageManager()
 {
 	m_Logging= false;
+	g_bIsMainThread = true;
 	// Register with Lua.
 	{
 		Lua *L = LUA->Get();
@@ -169,43 +344,78 @@ MessageManager::MessageManager()
 
 MessageManager::~MessageManager()
 {
+	for( DeferredMessage &deferred : g_DeferredMessages )
+		delete deferred.pMsg;
+	g_DeferredMessages.clear();
+
 	// Unregister with Lua.
 	LUA->UnsetGlobal( "MESSAGEMAN" );
 }
 
-void MessageManager::Subscribe( IMessageSubscriber* pSubscriber, const RString& sMessage )
+void MessageManager::Subscribe( IMessageSubscriber* pSubscriber, MessageSymbol sym )
 {
-	LockMut(g_Mutex);
+	MessageLock lock;
 
-	SubscribersSet& subs = g_MessageToSubscribers[sMessage];
+	std::vector<IMessageSubscriber *> &subs = g_Messages[sym].vpSubscribers;
 #ifdef DEBUG
-	SubscribersSet::iterator iter = subs.find(pSubscriber);
-	ASSERT_M( iter == subs.end(), ssprintf("already subscribed to '%s'",sMessage.c_str()) );
+	ASSERT_M( find(subs.begin(), subs.end(), pSubscriber) == subs.end(), ssprintf("already subscribed to symbol %i",sym) );
 #endif
-	subs.insert( pSubscriber );
+	subs.push_back( pSubscriber );
+}
+
+void MessageManager::Subscribe( IMessageSubscriber* pSubscriber, const RString& sMessage )
+{
+	Subscribe( pSubscriber, InternMessageName(sMessage) );
 }
 
 void MessageManager::Subscribe( IMessageSubscriber* pSubscriber, MessageID m )
 {
-	Subscribe( pSubscriber, MessageIDToString(m) );
+	Subscribe( pSubscriber, MessageSymbol(m) );
 }
 
-void MessageManager::Unsubscribe( IMessageSubscriber* pSubscriber, const RString& sMessage )
+void MessageManager::Unsubscribe( IMessageSubscriber* pSubscriber, MessageSymbol sym )
 {
-	LockMut(g_Mutex);
+	MessageLock lock;
 
-	SubscribersSet& subs = g_MessageToSubscribers[sMessage];
-	SubscribersSet::iterator iter = subs.find(pSubscriber);
-	ASSERT( iter != subs.end() );
-	subs.erase( iter );
+	MessageInfo &list = g_Messages[sym];
+	std::vector<IMessageSubscriber *>::iterator iter = find( list.vpSubscribers.begin(), list.vpSubscribers.end(), pSubscriber );
+	ASSERT( iter != list.vpSubscribers.end() );
+	if( list.iBroadcasting > 0 )
+	{
+		*iter = nullptr;
+		list.bHasHoles = true;
+	}
+	else
+	{
+		list.vpSubscribers.erase( iter );
+	}
+}
+
+void MessageManager::Unsubscribe( IMessageSubscriber* pSubscriber, const RString& sMessage )
+{
+	Unsubscribe( pSubscriber, InternMessageName(sMessage) );
 }
 
 void MessageManager::Unsubscribe( IMessageSubscriber* pSubscriber, MessageID m )
 {
-	Unsubscribe( pSubscriber, MessageIDToString(m) );
+	Unsubscribe( pSubscriber, MessageSymbol(m) );
 }
 
 void MessageManager::Broadcast( Message &msg ) const
+{
+	bool bDeferred;
+	{
+		MessageLock lock;
+		bDeferred = g_Messages[msg.GetSymbol()].bDeferred;
+	}
+
+	if( bDeferred )
+		BroadcastDeferred( msg );
+	else
+		Deliver( msg );
+}
+
+void MessageManager::Deliver( Message &msg ) const
 {
 	if(m_Logging)
 	{
@@ -213,15 +423,26 @@ void MessageManager::Broadcast( Message &msg ) const
 	}
 	msg.SetBroadcast(true);
 
-	LockMut(g_Mutex);
+	MessageLock lock;
 
-	std::map<RString, SubscribersSet>::const_iterator iter = g_MessageToSubscribers.find( msg.GetName() );
-	if( iter == g_MessageToSubscribers.end() )
+	MessageInfo &list = g_Messages[msg.GetSymbol()];
+	if( list.vpSubscribers.empty() )
 		return;
 
-	for (IMessageSubscriber *subscriber : iter->second)
+	/* Anything subscribed by a handler won't see this message. */
+	++list.iBroadcasting;
+	const std::size_t iCount = list.vpSubscribers.size();
+	for( std::size_t i = 0; i < iCount; ++i )
+	{
+		IMessageSubscriber *pSubscriber = list.vpSubscribers[i];
+		if( pSubscriber != nullptr )
+			pSubscriber->HandleMessage( msg );
+	}
+
+	if( --list.iBroadcasting == 0 && list.bHasHoles )
 	{
-		subscriber->HandleMessage( msg );
+		list.vpSubscribers.erase( remove(list.vpSubscribers.begin(), list.vpSubscribers.end(), (IMessageSubscriber *) nullptr), list.vpSubscribers.end() );
+		list.bHasHoles = false;
 	}
 }
 
@@ -234,14 +455,99 @@ void MessageManager::Broadcast( const RString& sMessage ) const
 
 void MessageManager::Broadcast( MessageID m ) const
 {
-	Broadcast( MessageIDToString(m) );
+	Message msg(m);
+	Broadcast( msg );
+}
+
+/* Players' copies of the same message are coalesced separately. */
+static RString GetCoalesceKey( const Message &msg )
+{
+	RString sKey;
+	Lua *L = LUA->Get();
+	msg.GetParamFromStack( L, "Player" );
+	if( lua_isstring(L, -1) )
+		sKey = lua_tostring( L, -1 );
+	lua_pop( L, 1 );
+	LUA->Release( L );
+	return sKey;
+}
+
+void MessageManager::BroadcastDeferred( Message &msg ) const
+{
+	DeferredMessage deferred;
+	{
+		MessageLock lock;
+		deferred.bCoalesce = g_Messages[msg.GetSymbol()].bCoalesce;
+	}
+	if( deferred.bCoalesce )
+		deferred.sKey = GetCoalesceKey( msg );
+
+	/* The queued copy refers to the same parameter table. */
+	deferred.pMsg = new Message( msg.GetName(), msg.GetParamTable() );
+
+	MessageLock lock;
+	if( deferred.bCoalesce )
+	{
+		/* Last value wins, in the place of the last send. */
+		for( std::vector<DeferredMessage>::iterator it = g_DeferredMessages.begin(); it != g_DeferredMessages.end(); ++it )
+		{
+			if( it->bCoalesce && it->pMsg->GetSymbol() == msg.GetSymbol() && it->sKey == deferred.sKey )
+			{
+				delete it->pMsg;
+				g_DeferredMessages.erase( it );
+				break;
+			}
+		}
+	}
+	g_DeferredMessages.push_back( deferred );
+}
+
+void MessageManager::SetDeferred( const RString &sMessage, bool bDeferred, bool bCoalesce )
+{
+	const MessageSymbol sym = InternMessageName( sMessage );
+	MessageLock lock;
+	g_Messages[sym].bDeferred = bDeferred;
+	g_Messages[sym].bCoalesce = bDeferred && bCoalesce;
+}
+
+void MessageManager::ClearDeferred()
+{
+	MessageLock lock;
+	for( MessageInfo &info : g_Messages )
+		info.bDeferred = info.bCoalesce = false;
+}
+
+void MessageManager::FlushDeferredMessages()
+{
+	/* Anything sent while flushing waits for the next frame. */
+	std::vector<DeferredMessage> vMessages;
+	{
+		MessageLock lock;
+		vMessages.swap( g_DeferredMessages );
+	}
+
+	for( DeferredMessage &deferred : vMessages )
+	{
+		Deliver( *deferred.pMsg );
+		delete deferred.pMsg;
+	}
 }
 
 bool MessageManager::IsSubscribedToMessage( IMessageSubscriber* pSubscriber, const RString &sMessage ) const
 {
-	SubscribersSet& subs = g_MessageToSubscribers[sMessage];
-	return subs.find( pSubscriber ) != subs.end();
-}	
+	const MessageSymbol sym = FindMessageSymbol( sMessage );
+	if( sym == MessageSymbol_Invalid )
+		return false;
+
+	MessageLock lock;
+	const std::vector<IMessageSubscriber *> &subs = g_Messages[sym].vpSubscribers;
+	return find( subs.begin(), subs.end(), pSubscriber ) != subs.end();
+}
+
+bool MessageManager::IsSubscribedToMessage( IMessageSubscriber* pSubscriber, MessageID message ) const
+{
+	return IsSubscribedToMessage( pSubscriber, MessageIDToString(message) );
+}
 
 void IMessageSubscriber::ClearMessages( const RString sMessage )
 {
@@ -250,8 +556,11 @@ void IMessageSubscriber::ClearMessages( const RString sMessage )
 MessageSubscriber::MessageSubscriber( const MessageSubscriber &cpy ):
 	IMessageSubscriber(cpy)
 {
-	for (RString const &msg : cpy.m_vsSubscribedTo)
-		this->SubscribeToMessage( msg );
+	for (MessageSymbol sym : cpy.m_vSubscribedTo)
+	{
+		MESSAGEMAN->Subscribe( this, sym );
+		m_vSubscribedTo.push_back( sym );
+	}
 }
 
 MessageSubscriber &MessageSubscriber::operator=(const MessageSubscriber &cpy)
@@ -261,29 +570,33 @@ MessageSubscriber &MessageSubscriber::operator=(const MessageSubscriber &cpy)
 
 	UnsubscribeAll();
 
-	for (RString const &msg : cpy.m_vsSubscribedTo)
-		this->SubscribeToMessage( msg );
+	for (MessageSymbol sym : cpy.m_vSubscribedTo)
+	{
+		MESSAGEMAN->Subscribe( this, sym );
+		m_vSubscribedTo.push_back( sym );
+	}
 
 	return *this;
 }
 
 void MessageSubscriber::SubscribeToMessage( const RString &sMessageName )
 {
-	MESSAGEMAN->Subscribe( this, sMessageName );
-	m_vsSubscribedTo.push_back( sMessageName );
+	const MessageSymbol sym = InternMessageName( sMessageName );
+	MESSAGEMAN->Subscribe( this, sym );
+	m_vSubscribedTo.push_back( sym );
 }
 
 void MessageSubscriber::SubscribeToMessage( MessageID message )
 {
 	MESSAGEMAN->Subscribe( this, message );
-	m_vsSubscribedTo.push_back( MessageIDToString(message) );
+	m_vSubscribedTo.push_back( message );
 }
 
 void MessageSubscriber::UnsubscribeAll()
 {
-	for (RString const &s : m_vsSubscribedTo)
-		MESSAGEMAN->Unsubscribe( this, s );
-	m_vsSubscribedTo.clear();
+	for (MessageSymbol sym : m_vSubscribedTo)
+		MESSAGEMAN->Unsubscribe( this, sym );
+	m_vSubscribedTo.clear();
 }
 
 
@@ -307,6 +620,24 @@ public:
 		p->Broadcast( msg );
 		COMMON_RETURN_SELF;
 	}
+	static int BroadcastDeferred( T* p, lua_State *L )
+	{
+		if( !lua_istable(L, 2) && !lua_isnoneornil(L, 2) )
+			luaL_typerror( L, 2, "table or nil" );
+
+		LuaReference ParamTable;
+		lua_pushvalue( L, 2 );
+		ParamTable.SetFromStack( L );
+
+		Message msg( SArg(1), ParamTable );
+		p->BroadcastDeferred( msg );
+		COMMON_RETURN_SELF;
+	}
+	static int SetDeferred( T* p, lua_State *L )
+	{
+		p->SetDeferred( SArg(1), BArg(2), lua_toboolean(L, 3) != 0 );
+		COMMON_RETURN_SELF;
+	}
 	static int SetLogging(T* p, lua_State *L)
 	{
 		p->SetLogging(lua_toboolean(L, -1));
@@ -316,6 +647,8 @@ public:
 	LunaMessageManager()
 	{
 		ADD_METHOD( Broadcast );
+		ADD_METHOD( BroadcastDeferred );
+		ADD_METHOD( SetDeferred );
 		ADD_METHOD( SetLogging );
 	}
 };
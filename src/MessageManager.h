@@ -3,6 +3,7 @@
 
 #include "LuaManager.h"
 
+#include <cstddef>
 #include <vector>
 
 
@@ -92,6 +93,19 @@ enum MessageID
 };
 const RString& MessageIDToString( MessageID m );
 
+/** @brief A message or command name, interned.
+ *
+ * Each distinct name gets a small integer the first time it's seen, and
+ * keeps it for the life of the program, so messages and commands can be
+ * looked up by index instead of by string.  The MessageID names are
+ * interned first, so each MessageID is also its own symbol. */
+typedef int MessageSymbol;
+const MessageSymbol MessageSymbol_Invalid = -1;
+MessageSymbol InternMessageName( const RString &sName );
+/** @brief Look up a name without interning it.
+ * @return MessageSymbol_Invalid if the name has never been interned. */
+MessageSymbol FindMessageSymbol( const RString &sName );
+
 struct Message
 {
 	explicit Message( const RString &s );
@@ -99,8 +113,9 @@ struct Message
 	Message( const RString &s, const LuaReference &params );
 	~Message();
 
-	void SetName( const RString &sName ) { m_sName = sName; }
-	RString GetName() const { return m_sName; }
+	void SetName( const RString &sName );
+	const RString &GetName() const { return m_sName; }
+	MessageSymbol GetSymbol() const { return m_Symbol; }
 
 	bool IsBroadcast() const { return m_bBroadcast; }
 	void SetBroadcast( bool b ) { m_bBroadcast = b; }
@@ -141,11 +156,21 @@ struct Message
 	}
 
 	bool operator==( const RString &s ) const { return m_sName == s; }
-	bool operator==( MessageID id ) const { return MessageIDToString(id) == m_sName; }
+	bool operator==( MessageID id ) const { return m_Symbol == id; }
+
+	/* Deferred messages are queued on the heap; they share a slab. */
+	static void *operator new( std::size_t iSize );
+	static void operator delete( void *p, std::size_t iSize );
 
 private:
+	LuaTable &GetParams() const;
+
 	RString m_sName;
-	LuaTable *m_pParams;
+	MessageSymbol m_Symbol;
+	/* Created the first time anything asks for it.  Most messages are never
+	 * delivered to a command and never get parameters, so most never need a
+	 * table at all. */
+	mutable LuaTable *m_pParams;
 	bool m_bBroadcast;
 
 	Message &operator=( const Message &rhs ); // don't use
@@ -171,7 +196,7 @@ private:
 class MessageSubscriber : public IMessageSubscriber
 {
 public:
-	MessageSubscriber(): m_vsSubscribedTo() {}
+	MessageSubscriber(): m_vSubscribedTo() {}
 	MessageSubscriber( const MessageSubscriber &cpy );
 	MessageSubscriber &operator=(const MessageSubscriber &cpy);
 
@@ -184,7 +209,7 @@ public:
 	void UnsubscribeAll();
 
 private:
-	std::vector<RString> m_vsSubscribedTo;
+	std::vector<MessageSymbol> m_vSubscribedTo;
 };
 
 /** @brief Deliver messages to any part of the program as needed. */
@@ -198,17 +223,33 @@ public:
 	void Subscribe( IMessageSubscriber* pSubscriber, MessageID m );
 	void Unsubscribe( IMessageSubscriber* pSubscriber, const RString& sMessage );
 	void Unsubscribe( IMessageSubscriber* pSubscriber, MessageID m );
+	void Subscribe( IMessageSubscriber* pSubscriber, MessageSymbol sym );
+	void Unsubscribe( IMessageSubscriber* pSubscriber, MessageSymbol sym );
 	void Broadcast( Message &msg ) const;
 	void Broadcast( const RString& sMessage ) const;
 	void Broadcast( MessageID m ) const;
+
+	/* Deferred messages are queued and delivered together once per frame,
+	 * just before drawing, in the order they were sent.  A message that is
+	 * also coalesced is only delivered once per frame (per player, if it has
+	 * a Player parameter), with the parameters it was sent with last.
+	 * Messages that aren't deferred are still delivered immediately. */
+	void BroadcastDeferred( Message &msg ) const;
+	void SetDeferred( const RString &sMessage, bool bDeferred, bool bCoalesce = false );
+	void ClearDeferred();
+	void FlushDeferredMessages();
+
 	bool IsSubscribedToMessage( IMessageSubscriber* pSubscriber, const RString &sMessage ) const;
-	inline bool IsSubscribedToMessage( IMessageSubscriber* pSubscriber, MessageID message ) const { return IsSubscribedToMessage( pSubscriber, MessageIDToString(message) ); }
+	bool IsSubscribedToMessage( IMessageSubscriber* pSubscriber, MessageID message ) const;
 
 	void SetLogging(bool set) { m_Logging= set; }
 	bool m_Logging;
 
 	// Lua
 	void PushSelf( lua_State *L );
+
+private:
+	void Deliver( Message &msg ) const;
 };
 
 extern MessageManager*	MESSAGEMAN;	// global and accessible from anywhere in our program
@@ -223,7 +264,7 @@ private:
 public:
 	explicit BroadcastOnChange( MessageID m ) { mSendWhenChanged = m; }
 	const T Get() const { return val; }
-	void Set( T t ) { val = t; MESSAGEMAN->Broadcast( MessageIDToString(mSendWhenChanged) ); }
+	void Set( T t ) { val = t; MESSAGEMAN->Broadcast( mSendWhenChanged ); }
 	operator T () const { return val; }
 	bool operator == ( const T &other ) const { return val == other; }
 	bool operator != ( const T &other ) const { return val != other; }
@@ -263,7 +304,7 @@ private:
 public:
 	explicit BroadcastOnChangePtr( MessageID m ) { mSendWhenChanged = m; val = nullptr; }
 	T* Get() const { return val; }
-	void Set( T* t ) { val = t; if(MESSAGEMAN) MESSAGEMAN->Broadcast( MessageIDToString(mSendWhenChanged) ); }
+	void Set( T* t ) { val = t; if(MESSAGEMAN) MESSAGEMAN->Broadcast( mSendWhenChanged ); }
 	/* This is only intended to be used for setting temporary values; always
 	 * restore the original value when finished, so listeners don't get confused
 	 * due to missing a message. */
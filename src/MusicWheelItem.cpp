@@ -19,6 +19,8 @@
 #include "ScreenSelectMusic.h"
 #include "ScreenManager.h"
 
+#include <typeinfo>
+
 static const char *MusicWheelItemTypeNames[] = {
 	"Song",
 	"SectionExpanded",
@@ -178,6 +180,11 @@ MusicWheelItem::~MusicWheelItem()
 	delete m_pTextSectionCount;
 }
 
+bool MusicWheelItem::IsIdle() const
+{
+	return typeid(*this) == typeid(MusicWheelItem) && FrameIsIdle();
+}
+
 void MusicWheelItem::LoadFromWheelItemData( const WheelItemBaseData *pData, int iIndex, bool bHasFocus, int iDrawIndex )
 {
 	WheelItemBase::LoadFromWheelItemData( pData, iIndex, bHasFocus, iDrawIndex );
@@ -45,6 +45,9 @@ public:
 	virtual void HandleMessage( const Message &msg );
 	void RefreshGrades();
 
+protected:
+	virtual bool IsIdle() const;
+
 private:
 	ThemeMetric<bool>	GRADES_SHOW_MACHINE;
 
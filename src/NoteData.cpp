@@ -12,7 +12,9 @@
 #include "GameState.h" // blame radar calculations.
 #include "RageUtil_AutoPtr.h"
 
+#include <algorithm>
 #include <cstddef>
+#include <utility>
 #include <vector>
 
 
@@ -21,6 +23,8 @@ REGISTER_CLASS_TRAITS( NoteData, new NoteData(*pCopy) )
 void NoteData::Init()
 {
 	m_TapNotes = std::vector<TrackMap>();	// ensure that the memory is freed
+	m_HoldIndex = std::vector<HoldIndex>();
+	InvalidateHoldIndex();
 }
 
 void NoteData::SetNumTracks( int iNewNumTracks )
@@ -28,6 +32,7 @@ void NoteData::SetNumTracks( int iNewNumTracks )
 	ASSERT( iNewNumTracks > 0 );
 
 	m_TapNotes.resize( iNewNumTracks );
+	InvalidateHoldIndex();
 }
 
 bool NoteData::IsComposite() const
@@ -44,6 +49,8 @@ bool NoteData::IsComposite() const
 // Clear (rowBegin,rowEnd).
 void NoteData::ClearRangeForTrack( int rowBegin, int rowEnd, int iTrack )
 {
+	InvalidateHoldIndex();
+
 	// Optimization: if the range encloses everything, just clear the whole maps.
 	if( rowBegin == 0 && rowEnd == MAX_NOTE_ROW )
 	{
@@ -123,6 +130,7 @@ void NoteData::ClearAll()
 {
 	for( int t=0; t<GetNumTracks(); t++ )
 		m_TapNotes[t].clear();
+	InvalidateHoldIndex();
 }
 
 /* Copy [rowFromBegin,rowFromEnd) from pFrom to this. (Note that this does
@@ -940,6 +948,7 @@ void NoteData::MoveTapNoteTrack( int dest, int src )
 	if(dest == src) return;
 	m_TapNotes[dest] = m_TapNotes[src];
 	m_TapNotes[src].clear();
+	InvalidateHoldIndex();
 }
 
 void NoteData::SetTapNote( int track, int row, const TapNote& t )
@@ -949,6 +958,8 @@ void NoteData::SetTapNote( int track, int row, const TapNote& t )
 	if( row < 0 )
 		return;
 
+	InvalidateHoldIndex();
+
 	// There's no point in inserting empty notes into the map.
 	// Any blank space in the map is defined to be empty.
 	// If we're trying to insert an empty at a spot where another note
@@ -966,6 +977,26 @@ void NoteData::SetTapNote( int track, int row, const TapNote& t )
 	}
 }
 
+NoteData::iterator NoteData::AppendTapNote( int track, int row, TapNote &&tn )
+{
+	DEBUG_ASSERT( track>=0 && track<GetNumTracks() );
+	DEBUG_ASSERT( tn.type != TapNoteType_Empty );
+
+	InvalidateHoldIndex();
+	TrackMap &trackMap = m_TapNotes[track];
+	if( trackMap.empty() || trackMap.rbegin()->first < row )
+		return trackMap.emplace_hint( trackMap.end(), row, std::move(tn) );
+
+	// Out of order, or replacing a note; do what SetTapNote would.
+	iterator it = trackMap.lower_bound( row );
+	if( it != trackMap.end() && it->first == row )
+	{
+		it->second = std::move( tn );
+		return it;
+	}
+	return trackMap.emplace_hint( it, row, std::move(tn) );
+}
+
 void NoteData::GetTracksHeldAtRow( int row, std::set<int>& addTo )
 {
 	for( int t=0; t<GetNumTracks(); ++t )
@@ -1132,7 +1163,56 @@ void NoteData::GetTapNoteRangeExclusive( int iTrack, int iStartRow, int iEndRow,
 	lEnd = const_end;
 }
 
+void NoteData::BuildHoldIndex( int iTrack ) const
+{
+	if( !m_bHoldIndexValid )
+	{
+		m_HoldIndex.clear();
+		m_HoldIndex.resize( GetNumTracks() );
+		m_bHoldIndexValid = true;
+	}
 
+	HoldIndex &index = m_HoldIndex[iTrack];
+	if( index.bBuilt )
+		return;
+
+	int iMaxEndRow = -1;
+	for (const std::pair<const int, TapNote> &note : m_TapNotes[iTrack])
+	{
+		if( note.second.type != TapNoteType_HoldHead )
+			continue;
+		iMaxEndRow = std::max( iMaxEndRow, note.first + note.second.iDuration );
+		index.viStartRows.push_back( note.first );
+		index.viMaxEndRows.push_back( iMaxEndRow );
+	}
+	index.bBuilt = true;
+}
+
+void NoteData::GetHoldsOverlappingRow( int iTrack, int iRow, std::vector<const_iterator> &vOut ) const
+{
+	BuildHoldIndex( iTrack );
+	const HoldIndex &index = m_HoldIndex[iTrack];
+
+	/* Only holds starting before iRow can overlap it, and none before the first
+	 * one whose running end row passes iRow.  Holds in a track don't normally
+	 * overlap each other, so that leaves only the holds wanted. */
+	const std::vector<int>::const_iterator itStartsEnd =
+		std::lower_bound( index.viStartRows.begin(), index.viStartRows.end(), iRow );
+	const std::size_t iEnd = itStartsEnd - index.viStartRows.begin();
+	const std::size_t iBegin = std::upper_bound( index.viMaxEndRows.begin(), index.viMaxEndRows.begin() + iEnd, iRow )
+		- index.viMaxEndRows.begin();
+
+	for( std::size_t i = iBegin; i < iEnd; ++i )
+	{
+		/* Notes can be changed through iterators without going through
+		 * NoteData, so check the note is still what it was. */
+		const_iterator it = FindTapNote( iTrack, index.viStartRows[i] );
+		if( it == end(iTrack) || it->second.type != TapNoteType_HoldHead )
+			continue;
+		if( it->first + it->second.iDuration > iRow )
+			vOut.push_back( it );
+	}
+}
 
 bool NoteData::GetNextTapNoteRowForAllTracks( int &rowInOut ) const
 {
@@ -1238,6 +1318,7 @@ void NoteData::RemoveATIFromList(all_tracks_const_iterator* iter) const
 
 void NoteData::RevalidateATIs(std::vector<int> const& added_or_removed_tracks, bool added)
 {
+	InvalidateHoldIndex();
 	for(std::set<all_tracks_iterator*>::iterator cur= m_atis.begin();
 			cur != m_atis.end(); ++cur)
 	{
@@ -36,7 +36,7 @@ public:
 	typedef std::map<int,TapNote>::reverse_iterator reverse_iterator;
 	typedef std::map<int,TapNote>::const_reverse_iterator const_reverse_iterator;
 
-	NoteData(): m_TapNotes() {}
+	NoteData(): m_TapNotes(), m_bHoldIndexValid(false) {}
 
 	iterator begin( int iTrack )					{ return m_TapNotes[iTrack].begin(); }
 	const_iterator begin( int iTrack ) const			{ return m_TapNotes[iTrack].begin(); }
@@ -55,6 +55,8 @@ public:
 		m_TapNotes.swap(nd.m_TapNotes);
 		m_atis.swap(nd.m_atis);
 		m_const_atis.swap(nd.m_const_atis);
+		InvalidateHoldIndex();
+		nd.InvalidateHoldIndex();
 	}
 
 
@@ -156,6 +158,22 @@ private:
 	mutable std::set<all_tracks_iterator*> m_atis;
 	mutable std::set<all_tracks_const_iterator*> m_const_atis;
 
+	/* Per track, the rows of every hold head in order, and the furthest end row
+	 * of any hold up to and including each one.  Built by GetHoldsOverlappingRow
+	 * the first time a track is asked for, and thrown away by anything that
+	 * changes the notes. */
+	struct HoldIndex
+	{
+		HoldIndex(): bBuilt(false) { }
+		bool bBuilt;
+		std::vector<int> viStartRows;
+		std::vector<int> viMaxEndRows;
+	};
+	mutable std::vector<HoldIndex> m_HoldIndex;
+	mutable bool m_bHoldIndexValid;
+	void InvalidateHoldIndex()	{ m_bHoldIndexValid = false; }
+	void BuildHoldIndex( int iTrack ) const;
+
 	void AddATIToList(all_tracks_iterator* iter) const;
 	void AddATIToList(all_tracks_const_iterator* iter) const;
 	void RemoveATIFromList(all_tracks_iterator* iter) const;
@@ -192,7 +210,7 @@ public:
 
 	inline iterator FindTapNote( unsigned iTrack, int iRow )	{ return m_TapNotes[iTrack].find( iRow ); }
 	inline const_iterator FindTapNote( unsigned iTrack, int iRow ) const { return m_TapNotes[iTrack].find( iRow ); }
-	void RemoveTapNote( unsigned iTrack, iterator it )		{ m_TapNotes[iTrack].erase( it ); }
+	void RemoveTapNote( unsigned iTrack, iterator it )		{ m_TapNotes[iTrack].erase( it ); InvalidateHoldIndex(); }
 
 	/**
 	 * @brief Return an iterator range for [rowBegin,rowEnd).
@@ -238,6 +256,12 @@ public:
 	void RevalidateATIs(std::vector<int> const& added_or_removed_tracks, bool added);
 	void TransferATIs(NoteData& to);
 
+	/* Add every hold note in iTrack that starts before iRow and ends after it to
+	 * vOut, in row order.  This is O(log n + k) for k holds overlapping the row,
+	 * however far back they start, so drawing can find the holds running into
+	 * the top of the screen without searching backwards through the chart. */
+	void GetHoldsOverlappingRow( int iTrack, int iRow, std::vector<const_iterator> &vOut ) const;
+
 	/* Return an iterator range include iStartRow to iEndRow.  Extend the range to include
 	 * hold notes overlapping the boundary. */
 	void GetTapNoteRangeInclusive(int iTrack, int iStartRow, int iEndRow,
@@ -261,6 +285,16 @@ public:
 
 	void MoveTapNoteTrack( int dest, int src );
 	void SetTapNote( int track, int row, const TapNote& tn );
+	/**
+	 * @brief Set a non-empty note, moving it into place.
+	 *
+	 * This is for loaders, which add each track's notes in order: a note
+	 * after the last one in its track is added without searching the track.
+	 * @param track the column to work with.
+	 * @param row the row of the note.
+	 * @param tn the tap note, which is left unspecified.
+	 * @return the note's position in the track. */
+	iterator AppendTapNote( int track, int row, TapNote &&tn );
 	/**
 	 * @brief Add a hold note, merging other overlapping holds and destroying
 	 * tap notes underneath.
@@ -13,6 +13,8 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <utility>
 #include <vector>
 
@@ -59,54 +61,69 @@ NoteType NoteDataUtil::GetSmallestNoteTypeInRange( const NoteData &n, int iStart
 	return NoteType_Invalid;	// well-formed notes created in the editor should never get here
 }
 
+static inline bool IsSMWhitespace( char c )
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
 static void LoadFromSMNoteDataStringWithPlayer( NoteData& out, const RString &sSMNoteData, int start,
 						int len, PlayerNumber pn, int iNumTracks )
 {
-	/* Don't allocate memory for the entire string, nor per measure. Instead, use the in-place
-	 * partial string split twice. By maintaining begin and end pointers to each measure line
-	 * we can perform this without copying the string at all. */
-	int size = -1;
-	const int end = start + len;
+	/* Work in place: each measure's lines are kept as begin and end pointers
+	 * into the string, and each note is moved straight into its track.  A
+	 * track's notes are added in row order, so NoteData never has to search
+	 * for where one goes. */
+	const char *p = sSMNoteData.data() + start;
+	const char *const pEnd = p + len;
+
+	/* The last note in each track, ignoring autokeysounds, which is the only
+	 * note a '3' can end. */
+	std::vector<NoteData::iterator> aLastNote;
+	for( int t = 0; t < iNumTracks; ++t )
+		aLastNote.push_back( out.end(t) );
+	int iOpenHolds = 0;
+
 	std::vector<std::pair<const char*, const char*> > aMeasureLines;
-	for( unsigned m = 0; true; ++m )
+	unsigned m = 0;
+	while( p < pEnd )
 	{
+		const char *pMeasureEnd = static_cast<const char *>( memchr(p, ',', pEnd - p) );
+		if( pMeasureEnd == nullptr )
+			pMeasureEnd = pEnd;
+
 		/* XXX Ignoring empty seems wrong for measures. It means that ",,," is treated as
 		 * "," where I would expect most people would want 2 empty measures. ",\n,\n,"
 		 * would do as I would expect. */
-		split( sSMNoteData, ",", start, size, end, true ); // Ignore empty is important.
-		if( start == end )
+		if( pMeasureEnd == p )
 		{
-			break;
+			++p;
+			continue;
 		}
-		// Partial string split.
-		int measureLineStart = start, measureLineSize = -1;
-		const int measureEnd = start + size;
 
 		aMeasureLines.clear();
-		for(;;)
+		for( const char *pLine = p; pLine < pMeasureEnd; )
 		{
-			// Ignore empty is clearly important here.
-			split( sSMNoteData, "\n", measureLineStart, measureLineSize, measureEnd, true );
-			if( measureLineStart == measureEnd )
-			{
-				break;
-			}
-			//RString &line = sSMNoteData.substr( measureLineStart, measureLineSize );
-			const char *beginLine = sSMNoteData.data() + measureLineStart;
-			const char *endLine = beginLine + measureLineSize;
+			const char *pLineEnd = static_cast<const char *>( memchr(pLine, '\n', pMeasureEnd - pLine) );
+			if( pLineEnd == nullptr )
+				pLineEnd = pMeasureEnd;
 
-			while( beginLine < endLine && strchr("\r\n\t ", *beginLine) )
+			const char *beginLine = pLine;
+			const char *endLine = pLineEnd;
+			while( beginLine < endLine && IsSMWhitespace(*beginLine) )
 				++beginLine;
-			while( endLine > beginLine && strchr("\r\n\t ", *(endLine - 1)) )
+			while( endLine > beginLine && IsSMWhitespace(*(endLine - 1)) )
 				--endLine;
 			if( beginLine < endLine ) // nonempty
 				aMeasureLines.push_back( std::pair<const char*, const char*>(beginLine, endLine) );
+
+			pLine = pLineEnd + 1;
 		}
+		p = pMeasureEnd + 1;
 
 		for( unsigned l=0; l<aMeasureLines.size(); l++ )
 		{
-			const char *p = aMeasureLines[l].first;
-			const char *const beginLine = p;
+			const char *pNote = aMeasureLines[l].first;
+			const char *const beginLine = pNote;
 			const char *const endLine = aMeasureLines[l].second;
 
 			const float fPercentIntoMeasure = l/(float)aMeasureLines.size();
@@ -114,144 +131,95 @@ static void LoadFromSMNoteDataStringWithPlayer( NoteData& out, const RString &sS
 			const int iIndex = BeatToNoteRow( fBeat );
 
 			int iTrack = 0;
-			while( iTrack < iNumTracks && p < endLine )
+			while( iTrack < iNumTracks && pNote < endLine )
 			{
-				TapNote tn;
-				char ch = *p;
+				const TapNote *pSource = nullptr;
+				const char ch = *pNote++;
 
 				switch( ch )
 				{
-				case '0': tn = TAP_EMPTY;				break;
-				case '1': tn = TAP_ORIGINAL_TAP;			break;
-				case '2':
-				case '4':
-				// case 'N': // minefield
-					tn = ch == '2' ? TAP_ORIGINAL_HOLD_HEAD : TAP_ORIGINAL_ROLL_HEAD;
-					/*
-					// upcoming code for minefields -aj
-					switch(ch)
-					{
-					case '2': tn = TAP_ORIGINAL_HOLD_HEAD; break;
-					case '4': tn = TAP_ORIGINAL_ROLL_HEAD; break;
-					case 'N': tn = TAP_ORIGINAL_MINE_HEAD; break;
-					}
-					*/
-
-					/* Set the hold note to have infinite length. We'll clamp
-					 * it when we hit the tail. */
-					tn.iDuration = MAX_NOTE_ROW;
-					break;
+				case '1': pSource = &TAP_ORIGINAL_TAP;			break;
+				case '2': pSource = &TAP_ORIGINAL_HOLD_HEAD;		break;
+				case '4': pSource = &TAP_ORIGINAL_ROLL_HEAD;		break;
+				// case 'N': // minefield -aj
 				case '3':
 				{
-					// This is the end of a hold. Search for the beginning.
-					int iHeadRow;
-					if( !out.IsHoldNoteAtRow( iTrack, iIndex, &iHeadRow ) )
+					// This is the end of a hold.  Its head is the last note in the track.
+					NoteData::iterator head = aLastNote[iTrack];
+					if( head == out.end(iTrack) || head->second.type != TapNoteType_HoldHead ||
+						head->first + head->second.iDuration < iIndex )
 					{
 						int n = std::intptr_t(endLine) - std::intptr_t(beginLine);
 						LOG->Warn( "Unmatched 3 in \"%.*s\"", n, beginLine );
 					}
 					else
 					{
-						out.FindTapNote( iTrack, iHeadRow )->second.iDuration = iIndex - iHeadRow;
+						head->second.iDuration = iIndex - head->first;
+						--iOpenHolds;
 					}
-
-					// This won't write tn, but keep parsing normally anyway.
 					break;
 				}
-				//				case 'm':
 				// Don't be loose with the definition.  Use only 'M' since
 				// that's what we've been writing to disk.  -Chris
-				case 'M': tn = TAP_ORIGINAL_MINE;			break;
-				// case 'A': tn = TAP_ORIGINAL_ATTACK;			break;
-				case 'K': tn = TAP_ORIGINAL_AUTO_KEYSOUND;		break;
-				case 'L': tn = TAP_ORIGINAL_LIFT;			break;
-				case 'F': tn = TAP_ORIGINAL_FAKE;			break;
-				// case 'I': tn = TAP_ORIGINAL_ITEM;			break;
+				case 'M': pSource = &TAP_ORIGINAL_MINE;			break;
+				// case 'A': pSource = &TAP_ORIGINAL_ATTACK;		break;
+				case 'K': pSource = &TAP_ORIGINAL_AUTO_KEYSOUND;	break;
+				case 'L': pSource = &TAP_ORIGINAL_LIFT;			break;
+				case 'F': pSource = &TAP_ORIGINAL_FAKE;			break;
+				// case 'I': pSource = &TAP_ORIGINAL_ITEM;		break;
 				default:
-					/* Invalid data. We don't want to assert, since there might
-					 * simply be invalid data in an .SM, and we don't want to die
-					 * due to invalid data. We should probably check for this when
-					 * we load SM data for the first time ... */
-					// FAIL_M("Invalid data in SM");
-					tn = TAP_EMPTY;
+					/* '0', or invalid data. We don't want to assert, since there
+					 * might simply be invalid data in an .SM, and we don't want to
+					 * die due to invalid data. */
 					break;
 				}
 
-				p++;
-				// We won't scan past the end of the line so these are safe to do.
-#if 0
-				// look for optional attack info (e.g. "{tipsy,50% drunk:15.2}")
-				if( *p == '{' )
-				{
-					p++;
-
-					char szModifiers[256] = "";
-					float fDurationSeconds = 0;
-					if( sscanf( p, "%255[^:]:%f}", szModifiers, &fDurationSeconds ) == 2 )	// not fatal if this fails due to malformed data
-					{
-						tn.type = TapNoteType_Attack;
-						tn.sAttackModifiers = szModifiers;
-		 				tn.fAttackDurationSeconds = fDurationSeconds;
-					}
-
-					// skip past the '}'
-					while( p < endLine )
-					{
-						if( *(p++) == '}' )
-							break;
-					}
-				}
-#endif
-
 				// look for optional keysound index (e.g. "[123]")
-				if( *p == '[' )
+				int iKeysoundIndex = -1;
+				if( pNote < endLine && *pNote == '[' )
 				{
-					p++;
-					int iKeysoundIndex = 0;
-					if( 1 == sscanf( p, "%d]", &iKeysoundIndex ) )	// not fatal if this fails due to malformed data
-		 				tn.iKeysoundIndex = iKeysoundIndex;
+					pNote++;
+					char *pNumberEnd;
+					const long iIndexRead = strtol( pNote, &pNumberEnd, 10 );
+					if( pNumberEnd != pNote )	// not fatal if this fails due to malformed data
+						iKeysoundIndex = int( iIndexRead );
 
 					// skip past the ']'
-					while( p < endLine )
+					while( pNote < endLine )
 					{
-						if( *(p++) == ']' )
+						if( *(pNote++) == ']' )
 							break;
 					}
 				}
 
-#if 0
-				// look for optional item name (e.g. "<potion>"),
-				// where the name in the <> is a Lua function defined elsewhere
-				// (Data/ItemTypes.lua, perhaps?) -aj
-				if( *p == '<' )
+				if( pSource != nullptr )
 				{
-					p++;
-
-					// skip past the '>'
-					while( p < endLine )
+					TapNote tn = *pSource;
+					tn.pn = pn;
+					if( iKeysoundIndex != -1 )
+						tn.iKeysoundIndex = iKeysoundIndex;
+					if( tn.type == TapNoteType_HoldHead )
 					{
-						if( *(p++) == '>' )
-							break;
+						/* Set the hold note to have infinite length. We'll clamp
+						 * it when we hit the tail. */
+						tn.iDuration = MAX_NOTE_ROW;
+						++iOpenHolds;
 					}
-				}
-#endif
 
-				/* Optimization: if we pass TAP_EMPTY, NoteData will do a search
-				 * to remove anything in this position.  We know that there's nothing
-				 * there, so avoid the search. */
-				if( tn.type != TapNoteType_Empty && ch != '3' )
-				{
-					tn.pn = pn;
-					out.SetTapNote( iTrack, iIndex, tn );
+					const TapNoteType type = tn.type;
+					NoteData::iterator it = out.AppendTapNote( iTrack, iIndex, std::move(tn) );
+					if( type != TapNoteType_AutoKeysound )
+						aLastNote[iTrack] = it;
 				}
 
 				iTrack++;
 			}
 		}
+		++m;
 	}
 
 	// Make sure we don't have any hold notes that didn't find a tail.
-	for( int t=0; t<out.GetNumTracks(); t++ )
+	for( int t=0; iOpenHolds > 0 && t<out.GetNumTracks(); t++ )
 	{
 		NoteData::iterator begin = out.begin( t );
 		NoteData::iterator lEnd = out.end( t );
@@ -274,23 +242,30 @@ static void LoadFromSMNoteDataStringWithPlayer( NoteData& out, const RString &sS
 
 void NoteDataUtil::LoadFromSMNoteDataString( NoteData &out, const RString &sSMNoteData_, bool bComposite )
 {
-	// Load note data
-	RString sSMNoteData;
-	RString::size_type iIndexCommentStart = 0;
-	RString::size_type iIndexCommentEnd = 0;
-	RString::size_type origSize = sSMNoteData_.size();
-	const char *p = sSMNoteData_.data();
-
-	sSMNoteData.reserve( origSize );
-	while( (iIndexCommentStart = sSMNoteData_.find("//", iIndexCommentEnd)) != RString::npos )
+	// Load note data.  Most charts have no comments, so only copy if they do.
+	RString sStripped;
+	const RString *pSMNoteData = &sSMNoteData_;
+	RString::size_type iIndexCommentStart = sSMNoteData_.find( "//" );
+	if( iIndexCommentStart != RString::npos )
 	{
-		sSMNoteData.append( p, iIndexCommentStart - iIndexCommentEnd );
-		p += iIndexCommentStart - iIndexCommentEnd;
-		iIndexCommentEnd = sSMNoteData_.find( "\n", iIndexCommentStart );
-		iIndexCommentEnd = (iIndexCommentEnd == RString::npos ? origSize : iIndexCommentEnd+1);
-		p += iIndexCommentEnd - iIndexCommentStart;
+		RString::size_type iIndexCommentEnd = 0;
+		RString::size_type origSize = sSMNoteData_.size();
+		const char *p = sSMNoteData_.data();
+
+		sStripped.reserve( origSize );
+		do
+		{
+			sStripped.append( p, iIndexCommentStart - iIndexCommentEnd );
+			p += iIndexCommentStart - iIndexCommentEnd;
+			iIndexCommentEnd = sSMNoteData_.find( "\n", iIndexCommentStart );
+			iIndexCommentEnd = (iIndexCommentEnd == RString::npos ? origSize : iIndexCommentEnd+1);
+			p += iIndexCommentEnd - iIndexCommentStart;
+		}
+		while( (iIndexCommentStart = sSMNoteData_.find("//", iIndexCommentEnd)) != RString::npos );
+		sStripped.append( p, origSize - iIndexCommentEnd );
+		pSMNoteData = &sStripped;
 	}
-	sSMNoteData.append( p, origSize - iIndexCommentEnd );
+	const RString &sSMNoteData = *pSMNoteData;
 
 	// Clear notes, but keep the same number of tracks.
 	int iNumTracks = out.GetNumTracks();
@@ -422,8 +397,8 @@ void NoteDataUtil::GetSMNoteDataString( const NoteData &in, RString &sRet )
 
 					if( tn.type == TapNoteType_Attack )
 					{
-						sRet.append( ssprintf("{%s:%.2f}", tn.sAttackModifiers.c_str(),
-								      tn.fAttackDurationSeconds) );
+						sRet.append( ssprintf("{%s:%.2f}", tn.GetAttackModifiers().c_str(),
+								      tn.GetAttackDurationSeconds()) );
 					}
 					// hey maybe if we have TapNoteType_Item we can do things here.
 					if( tn.iKeysoundIndex >= 0 )
@@ -1027,7 +1002,44 @@ static void DoRowEndRadarCalc(crv_state& state, RadarValues& out)
 	}
 }
 
-void NoteDataUtil::CalculateRadarValues( const NoteData &in, float fSongSeconds, RadarValues& out )
+// A measure is stream if at least this many of its rows have notes, which is
+// what themes have always called 16th stream.
+static const int STREAM_ROWS_PER_MEASURE= 16;
+
+static void FinishNoteDensity(const std::vector<int>& rows_per_measure,
+	const TimingData* timing, NoteDensity& out)
+{
+	const std::vector<int>& notes= out.m_viNotesPerMeasure;
+	out.m_fPeakNPS= 0;
+	for(std::size_t m= 0; m < notes.size(); ++m)
+	{
+		if(notes[m] == 0)
+		{ continue; }
+		const float start= timing->GetElapsedTimeFromBeat(m * 4.0f);
+		const float seconds= timing->GetElapsedTimeFromBeat((m + 1) * 4.0f) - start;
+		if(seconds > 0)
+		{ out.m_fPeakNPS= std::max(out.m_fPeakNPS, notes[m] / seconds); }
+	}
+
+	// Breaks before the first stream and after the last aren't runs.
+	out.m_viStreamRuns.clear();
+	int run= 0;
+	for(std::size_t m= 0; m < rows_per_measure.size(); ++m)
+	{
+		const bool stream= rows_per_measure[m] >= STREAM_ROWS_PER_MEASURE;
+		if(run != 0 && stream != (run > 0))
+		{
+			if(run > 0 || !out.m_viStreamRuns.empty())
+			{ out.m_viStreamRuns.push_back(run); }
+			run= 0;
+		}
+		run+= stream ? 1 : -1;
+	}
+	if(run > 0)
+	{ out.m_viStreamRuns.push_back(run); }
+}
+
+void NoteDataUtil::CalculateRadarValues( const NoteData &in, float fSongSeconds, RadarValues& out, NoteDensity *pDensityOut )
 {
 	// Anybody editing this function should also examine
 	// NoteDataWithScoring::GetActualRadarValues to make sure it handles things
@@ -1050,6 +1062,16 @@ void NoteDataUtil::CalculateRadarValues( const NoteData &in, float fSongSeconds,
 	std::size_t max_notes_in_voltage_window= 0;
 	int num_chaos_rows= 0;
 	crv_state state;
+	// Only judgable notes count toward the density.
+	const int measure_rows= BeatToNoteRow(4.0f);
+	std::vector<int> rows_per_measure;
+	if(pDensityOut != nullptr)
+	{
+		pDensityOut->Clear();
+		const std::size_t num_measures= in.GetLastRow() / measure_rows + 1;
+		pDensityOut->m_viNotesPerMeasure.resize(num_measures, 0);
+		rows_per_measure.resize(num_measures, 0);
+	}
 
 	while(!curr_note.IsAtEnd())
 	{
@@ -1104,6 +1126,13 @@ void NoteDataUtil::CalculateRadarValues( const NoteData &in, float fSongSeconds,
 					++out[RadarCategory_Notes];
 					++state.num_notes_on_curr_row;
 					++total_taps;
+					if(pDensityOut != nullptr)
+					{
+						const int measure= curr_row / measure_rows;
+						++pDensityOut->m_viNotesPerMeasure[measure];
+						if(state.num_notes_on_curr_row == 1)
+						{ ++rows_per_measure[measure]; }
+					}
 					recent_notes.push_back(
 						recent_note(curr_row, curr_note.Track()));
 					max_notes_in_voltage_window= std::max(recent_notes.size(),
@@ -1160,6 +1189,10 @@ void NoteDataUtil::CalculateRadarValues( const NoteData &in, float fSongSeconds,
 		++curr_note;
 	}
 	DoRowEndRadarCalc(state, out);
+	if(pDensityOut != nullptr)
+	{
+		FinishNoteDensity(rows_per_measure, timing, *pDensityOut);
+	}
 
 	// Walking the notes complete, now assign any values that remain. -Kyz
 	if(fSongSeconds > 0.0f)
@@ -9,6 +9,7 @@
 
 class PlayerOptions;
 struct RadarValues;
+struct NoteDensity;
 class NoteData;
 class Song;
 struct AttackArray;
@@ -57,7 +58,9 @@ namespace NoteDataUtil
 	// later.  -Kyz
 	void AutogenKickbox(const NoteData& in, NoteData& out, const TimingData& timing, StepsType out_type, int nonrandom_seed);
 
-	void CalculateRadarValues( const NoteData &in, float fSongSeconds, RadarValues& out );
+	/* If pDensityOut is set, it's filled in during the same pass.  Its peak NPS
+	 * uses the processed timing data, like the radar values. */
+	void CalculateRadarValues( const NoteData &in, float fSongSeconds, RadarValues& out, NoteDensity *pDensityOut = nullptr );
 
 	/**
 	 * @brief Remove all of the Hold notes.
@@ -1453,7 +1453,7 @@ void NoteDisplay::DrawTap(const TapNote& tn,
 	if( tn.type == TapNoteType_Attack )
 	{
 		Message msg( "SetAttack" );
-		msg.SetParam( "Modifiers", tn.sAttackModifiers );
+		msg.SetParam( "Modifiers", tn.GetAttackModifiers() );
 		pActor->HandleMessage( msg );
 	}
 
@@ -1552,8 +1552,21 @@ void NoteColumnRenderer::DrawPrimitives()
 	// optimizing it out. -Kyz
 	std::vector<std::vector<NoteData::TrackMap::const_iterator> > holds(PLAYER_INVALID+1);
 	std::vector<std::vector<NoteData::TrackMap::const_iterator> > taps(PLAYER_INVALID+1);
+	// Holds that start above the screen don't have to be just above it, so
+	// get them from the hold index instead of searching back for them.
+	static std::vector<NoteData::TrackMap::const_iterator> overlapping;
+	overlapping.clear();
+	m_field_render_args->note_data->GetHoldsOverlappingRow(m_column,
+		m_field_render_args->first_row, overlapping);
+	for(NoteData::TrackMap::const_iterator const& hold : overlapping)
+	{
+		if(hold->second.HoldResult.hns != HNS_Held)
+		{
+			holds[hold->second.pn].push_back(hold);
+		}
+	}
 	NoteData::TrackMap::const_iterator begin, end;
-	m_field_render_args->note_data->GetTapNoteRangeInclusive(m_column,
+	m_field_render_args->note_data->GetTapNoteRange(m_column,
 		m_field_render_args->first_row, m_field_render_args->last_row+1, begin, end);
 	for(; begin != end; ++begin)
 	{
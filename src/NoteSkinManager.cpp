@@ -14,6 +14,7 @@
 #include "XmlFileUtil.h"
 #include "Sprite.h"
 #include "SpecialFiles.h"
+#include "LuaBytecodeCache.h"
 
 #include <cstddef>
 #include <map>
@@ -174,25 +175,25 @@ bool NoteSkinManager::LoadNoteSkinDataRecursive( const RString &sNoteSkinName_,
 	for( std::vector<RString>::reverse_iterator dir = data_out.vsDirSearchOrder.rbegin(); dir != data_out.vsDirSearchOrder.rend(); ++dir )
 	{
 		RString sFile = *dir + "NoteSkin.lua";
-		RString sScript;
 		if( !FILEMAN->IsAFile(sFile) )
 			continue;
 
-		if( !GetFileContents(sFile, sScript) )
-			continue;
-
 		LOG->Trace( "Load script \"%s\"", sFile.c_str() );
 
 		Lua *L = LUA->Get();
 		RString Error= "Error running " + sFile + ": ";
-		refScript.PushSelf( L );
-		if( !LuaHelpers::RunScript(L, sScript, "@" + sFile, Error, 1, 1, true) )
+		RString sLoadError;
+		if( !LuaBytecodeCache::LoadFile(L, sFile, sLoadError) )
 		{
-			lua_pop( L, 1 );
+			LuaHelpers::ReportScriptError( Error + sLoadError );
 		}
 		else
 		{
-			refScript.SetFromStack( L );
+			refScript.PushSelf( L );
+			if( !LuaHelpers::RunScriptOnStack(L, Error, 1, 1, true) )
+				lua_pop( L, 1 );
+			else
+				refScript.SetFromStack( L );
 		}
 		LUA->Release( L );
 	}
@@ -4,6 +4,11 @@
 #include "LuaManager.h"
 #include "XmlFile.h"
 #include "LocalizedString.h"
+#include "RageThreads.h"
+
+#include <deque>
+#include <map>
+#include <utility>
 
 TapNote TAP_EMPTY	( TapNoteType_Empty,	TapNoteSubType_Invalid,	TapNoteSource_Original, "", 0, -1 );
 TapNote TAP_ORIGINAL_TAP	( TapNoteType_Tap,	TapNoteSubType_Invalid,	TapNoteSource_Original, "", 0, -1 );
@@ -180,6 +185,54 @@ void HoldNoteResult::LoadFromNode( const XNode* pNode )
 	FAIL_M("HoldNoteResult::LoadFromNode() is not implemented");
 }
 
+/* The attacks used by attack notes.  Entries are never removed, so an index
+ * stays valid, and a deque keeps references to them valid as it grows.
+ * Songs may be loaded on more than one thread. */
+typedef std::pair<RString, float> TapNoteAttack;
+static RageMutex g_AttacksLock( "TapNoteAttacks" );
+static std::deque<TapNoteAttack> g_Attacks;
+static std::map<TapNoteAttack, int> g_mapAttackToIndex;
+
+const RString &TapNote::GetAttackModifiers() const
+{
+	static const RString sNone;
+	if( iAttackIndex == -1 )
+		return sNone;
+	LockMut( g_AttacksLock );
+	return g_Attacks[iAttackIndex].first;
+}
+
+float TapNote::GetAttackDurationSeconds() const
+{
+	if( iAttackIndex == -1 )
+		return 0;
+	LockMut( g_AttacksLock );
+	return g_Attacks[iAttackIndex].second;
+}
+
+void TapNote::SetAttack( const RString &sModifiers, float fDurationSeconds )
+{
+	// This is what every note but an attack has, including the TAP_* constants.
+	if( sModifiers.empty() && fDurationSeconds == 0 )
+	{
+		iAttackIndex = -1;
+		return;
+	}
+
+	const TapNoteAttack attack( sModifiers, fDurationSeconds );
+	LockMut( g_AttacksLock );
+	std::map<TapNoteAttack, int>::const_iterator it = g_mapAttackToIndex.find( attack );
+	if( it != g_mapAttackToIndex.end() )
+	{
+		iAttackIndex = it->second;
+		return;
+	}
+
+	iAttackIndex = g_Attacks.size();
+	g_Attacks.push_back( attack );
+	g_mapAttackToIndex[attack] = iAttackIndex;
+}
+
 XNode* TapNote::CreateNode() const
 {
 	XNode *p = new XNode( "TapNote" );
@@ -257,8 +310,8 @@ public:
 	DEFINE_METHOD( GetTapNoteSubType, subType );
 	DEFINE_METHOD( GetTapNoteSource, source );
 	DEFINE_METHOD( GetPlayerNumber, pn );
-	DEFINE_METHOD( GetAttackModifiers, sAttackModifiers );
-	DEFINE_METHOD( GetAttackDuration, fAttackDurationSeconds );
+	DEFINE_METHOD( GetAttackModifiers, GetAttackModifiers() );
+	DEFINE_METHOD( GetAttackDuration, GetAttackDurationSeconds() );
 	DEFINE_METHOD( GetKeysoundIndex, iKeysoundIndex );
 	static int GetHoldDuration( T* p, lua_State* L )		{ lua_pushnumber(L, NoteRowToBeat(p->iDuration)); return 1; }
 	static int GetTapNoteResult( T* p, lua_State* L )		{ p->result.PushSelf(L); return 1; }
@@ -155,9 +155,8 @@ struct TapNote
 	/** @brief The Player that is supposed to hit this note. This is mainly for Routine Mode. */
 	PlayerNumber	pn;
 
-	// used only if Type == attack:
-	RString		sAttackModifiers;
-	float		fAttackDurationSeconds;
+	// used only if Type == attack: an index into the shared attack table, or -1.
+	int		iAttackIndex;
 
 	// Index into Song's vector of keysound files if nonnegative:
 	int		iKeysoundIndex;
@@ -173,16 +172,22 @@ struct TapNote
 	// Lua
 	void PushSelf( lua_State *L );
 
+	/* Hardly any notes are attacks, so rather than every note carrying a
+	 * string, attack notes refer to a table of the attacks in use. */
+	const RString &GetAttackModifiers() const;
+	float GetAttackDurationSeconds() const;
+	void SetAttack( const RString &sModifiers, float fDurationSeconds );
+
 	TapNote(): type(TapNoteType_Empty), subType(TapNoteSubType_Invalid),
-		source(TapNoteSource_Original),	result(), pn(PLAYER_INVALID),  sAttackModifiers(""),
-		fAttackDurationSeconds(0), iKeysoundIndex(-1), iDuration(0), HoldResult() {}
+		source(TapNoteSource_Original),	result(), pn(PLAYER_INVALID),
+		iAttackIndex(-1), iKeysoundIndex(-1), iDuration(0), HoldResult() {}
 	void Init()
 	{
 		type = TapNoteType_Empty;
 		subType = TapNoteSubType_Invalid;
 		source = TapNoteSource_Original;
 		pn = PLAYER_INVALID,
-		fAttackDurationSeconds = 0.f;
+		iAttackIndex = -1;
 		iKeysoundIndex = -1;
 		iDuration = 0;
 	}
@@ -194,10 +199,10 @@ struct TapNote
 		float fAttackDurationSeconds_,
 		int iKeysoundIndex_ ):
 		type(type_), subType(subType_), source(source_), result(),
-		pn(PLAYER_INVALID), sAttackModifiers(sAttackModifiers_),
-		fAttackDurationSeconds(fAttackDurationSeconds_),
+		pn(PLAYER_INVALID), iAttackIndex(-1),
 		iKeysoundIndex(iKeysoundIndex_), iDuration(0), HoldResult()
 	{
+		SetAttack( sAttackModifiers_, fAttackDurationSeconds_ );
 		if (type_ > TapNoteType_Fake )
 		{
 			LOG->Trace("Invalid tap note type %s (most likely) due to random vanish issues. Assume it doesn't need judging.", TapNoteTypeToString(type_).c_str() );
@@ -215,8 +220,7 @@ struct TapNote
 		COMPARE(type);
 		COMPARE(subType);
 		COMPARE(source);
-		COMPARE(sAttackModifiers);
-		COMPARE(fAttackDurationSeconds);
+		COMPARE(iAttackIndex);
 		COMPARE(iKeysoundIndex);
 		COMPARE(iDuration);
 		COMPARE(pn);
@@ -99,8 +99,7 @@ static void Deserialize( TapNote &o, const Json::Value &root )
 	// TODO should all of this also be within the if statement?
 	// It was not in the if statement previously, but that may have been unintentional.
 	o.subType = (TapNoteSubType)root["SubType"].asInt();
-	o.sAttackModifiers = root["AttackModifiers"].asString();
-	o.fAttackDurationSeconds = (float)root["AttackDurationSeconds"].asDouble();
+	o.SetAttack( root["AttackModifiers"].asString(), (float)root["AttackDurationSeconds"].asDouble() );
 	o.iKeysoundIndex = root["KeysoundIndex"].asInt();
 	o.iDuration = root["Duration"].asInt();
 	o.pn = (PlayerNumber)root["PlayerNumber"].asInt();
@@ -383,6 +383,30 @@ void SetRadarValues(StepsTagInfo& info)
 	}
 	info.ssc_format= true;
 }
+void SetNoteDensity(StepsTagInfo& info)
+{
+	if(info.from_cache)
+	{
+		NoteDensity density;
+		density.m_fPeakNPS= StringToFloat((*info.params)[1]);
+		std::vector<RString> notes, runs;
+		split((*info.params)[2], ",", notes, true);
+		for(RString const& value : notes)
+		{ density.m_viNotesPerMeasure.push_back(StringToInt(value)); }
+		split((*info.params)[3], ",", runs, true);
+		for(RString const& value : runs)
+		{ density.m_viStreamRuns.push_back(StringToInt(value)); }
+		info.steps->SetCachedNoteDensity(density);
+	}
+}
+void SetFingerprint(StepsTagInfo& info)
+{
+	// Only trust the cache; anything else is recalculated from the notes.
+	if(info.from_cache)
+	{
+		info.steps->SetCachedFingerprint((*info.params)[1]);
+	}
+}
 void SetCredit(StepsTagInfo& info)
 {
 	info.steps->SetCredit((*info.params)[1]);
@@ -611,6 +635,8 @@ struct ssc_parser_helper_t
 		steps_tag_handlers["METER"]= &SetMeter;
 		steps_tag_handlers["RADARVALUES"]= &SetRadarValues;
 		steps_tag_handlers["CREDIT"]= &SetCredit;
+		steps_tag_handlers["FINGERPRINT"]= &SetFingerprint;
+		steps_tag_handlers["NOTEDENSITY"]= &SetNoteDensity;
 		steps_tag_handlers["MUSIC"]= &SetStepsMusic;
 		steps_tag_handlers["BPMS"]= &SetStepsBPMs;
 		steps_tag_handlers["STOPS"]= &SetStepsStops;
@@ -428,6 +428,16 @@ static RString GetSSCNoteData( const Song &song, const Steps &in, bool bSavingCa
 	}
 	if (bSavingCache)
 	{
+		// Written even when empty, so empty charts aren't fingerprinted again.
+		lines.push_back(ssprintf("#FINGERPRINT:%s;", in.GetFingerprint().c_str()));
+		const NoteDensity &density = in.GetNoteDensity();
+		std::vector<RString> asNotes, asStreams;
+		for( int iNotes : density.m_viNotesPerMeasure )
+			asNotes.push_back( ssprintf("%d", iNotes) );
+		for( int iRun : density.m_viStreamRuns )
+			asStreams.push_back( ssprintf("%d", iRun) );
+		lines.push_back(ssprintf("#NOTEDENSITY:%.3f:%s:%s;", density.m_fPeakNPS,
+			join(",", asNotes).c_str(), join(",", asStreams).c_str()));
 		lines.push_back(ssprintf("#STEPFILENAME:%s;", in.GetFilename().c_str()));
 	}
 	else
@@ -13,6 +13,7 @@
 
 #include <cmath>
 #include <cstddef>
+#include <typeinfo>
 #include <vector>
 
 
@@ -54,6 +55,11 @@ OptionRow::~OptionRow()
 	Clear();
 }
 
+bool OptionRow::IsIdle() const
+{
+	return typeid(*this) == typeid(OptionRow) && FrameIsIdle();
+}
+
 void OptionRow::Clear()
 {
 	ActorFrame::RemoveAllChildren();
@@ -132,6 +132,8 @@ public:
 	void PushSelf( lua_State *L );
 
 protected:
+	virtual bool IsIdle() const;
+
 	const OptionRowType *m_pParentType;
 	RowType m_RowType;
 	OptionRowHandler* m_pHand;
@@ -2265,7 +2265,6 @@ void Player::Step( int col, int row, const RageTimer &tm, bool bHeld, bool bRele
 
 		const float fSecondsFromExact = std::abs( fNoteOffset );
 
-		TapNote tnDummy = TAP_ORIGINAL_TAP;
 		TapNote *pTN = nullptr;
 		NoteData::iterator iter = m_NoteData.FindTapNote( col, iRowOfOverlappingNoteOrRow );
 		DEBUG_ASSERT( iter!= m_NoteData.end(col) );
@@ -2457,8 +2456,8 @@ void Player::Step( int col, int row, const RageTimer &tm, bool bHeld, bool bRele
 			Attack attack(
 				ATTACK_LEVEL_1,
 				-1,	// now
-				pTN->fAttackDurationSeconds,
-				pTN->sAttackModifiers,
+				pTN->GetAttackDurationSeconds(),
+				pTN->GetAttackModifiers(),
 				true,
 				false
 				);
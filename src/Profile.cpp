@@ -25,15 +25,20 @@
 #include "Game.h"
 #include "CharacterManager.h"
 #include "Character.h"
+#include "StatsJournal.h"
+#include "ProfileWriter.h"
 
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 
 const RString STATS_XML            = "Stats.xml";
 const RString STATS_XML_GZ         = "Stats.xml.gz";
+/** @brief Changes made since STATS_XML was last written; see StatsJournal. */
+const RString STATS_JOURNAL        = "Stats.journal";
 /** @brief The filename for where one can edit their personal profile information. */
 const RString EDITABLE_INI         = "Editable.ini";
 /** @brief A tiny file containing the type and list priority. */
@@ -50,6 +55,7 @@ const RString SONGS_SUBDIR         = "Songs/";
 
 ThemeMetric<bool> SHOW_COIN_DATA( "Profile", "ShowCoinData" );
 static Preference<bool> g_bProfileDataCompress( "ProfileDataCompress", false );
+static Preference<int> g_iStatsJournalCompactKB( "StatsJournalCompactKB", 1024 );
 static ThemeMetric<RString> UNLOCK_AUTH_STRING( "Profile", "UnlockAuthString" );
 #define GUID_SIZE_BYTES 8
 
@@ -200,11 +206,16 @@ void Profile::InitGeneralData()
 void Profile::InitSongScores()
 {
 	m_SongHighScores.clear();
+	m_SongScoreIndex.m.clear();
+	m_ChangedStepsScores.clear();
+	m_bNeedFullStatsSave = true;
 }
 
 void Profile::InitCourseScores()
 {
 	m_CourseHighScores.clear();
+	m_ChangedTrailScores.clear();
+	m_bNeedFullStatsSave = true;
 }
 
 void Profile::InitCategoryScores()
@@ -610,6 +621,18 @@ Course *Profile::GetMostPopularCourse() const
 void Profile::AddStepsHighScore( const Song* pSong, const Steps* pSteps, HighScore hs, int &iIndexOut )
 {
 	GetStepsHighScoreList(pSong,pSteps).AddHighScore( hs, iIndexOut, IsMachine() );
+	StepsScoresChanged( pSong, pSteps );
+}
+
+void Profile::StepsScoresChanged( const Song* pSong, const Steps* pSteps )
+{
+	SongID songID;
+	songID.FromSong( pSong );
+
+	StepsID stepsID;
+	stepsID.FromSteps( pSteps );
+
+	m_ChangedStepsScores.insert( std::make_pair(songID, stepsID) );
 }
 
 const HighScoreList& Profile::GetStepsHighScoreList( const Song* pSong, const Steps* pSteps ) const
@@ -625,7 +648,7 @@ HighScoreList& Profile::GetStepsHighScoreList( const Song* pSong, const Steps* p
 	StepsID stepsID;
 	stepsID.FromSteps( pSteps );
 
-	HighScoresForASong &hsSong = m_SongHighScores[songID];	// operator[] inserts into map
+	HighScoresForASong &hsSong = GetOrAddHighScoresForASong( songID );
 	HighScoresForASteps &hsSteps = hsSong.m_StepsHighScores[stepsID];	// operator[] inserts into map
 
 	return hsSteps.hsl;
@@ -640,14 +663,14 @@ DateTime Profile::GetSongLastPlayedDateTime( const Song* pSong ) const
 {
 	SongID id;
 	id.FromSong( pSong );
-	std::map<SongID,HighScoresForASong>::const_iterator iter = m_SongHighScores.find( id );
+	const HighScoresForASong *hsSong = GetHighScoresForASong( id );
 
 	// don't call this unless has been played once
-	ASSERT( iter != m_SongHighScores.end() );
-	ASSERT( !iter->second.m_StepsHighScores.empty() );
+	ASSERT( hsSong != nullptr );
+	ASSERT( !hsSong->m_StepsHighScores.empty() );
 
 	DateTime dtLatest;	// starts out zeroed
-	for (std::pair<StepsID const, HighScoresForASteps> const &i : iter->second.m_StepsHighScores)
+	for (std::pair<StepsID const, HighScoresForASteps> const &i : hsSong->m_StepsHighScores)
 	{
 		const HighScoreList &hsl = i.second.hsl;
 		if( hsl.GetNumTimesPlayed() == 0 )
@@ -684,6 +707,7 @@ void Profile::IncrementStepsPlayCount( const Song* pSong, const Steps* pSteps )
 {
 	DateTime now = DateTime::GetNowDate();
 	GetStepsHighScoreList(pSong,pSteps).IncrementPlayCount( now );
+	StepsScoresChanged( pSong, pSteps );
 }
 
 void Profile::GetGrades( const Song* pSong, StepsType st, int iCounts[NUM_Grade] ) const
@@ -696,18 +720,16 @@ void Profile::GetGrades( const Song* pSong, StepsType st, int iCounts[NUM_Grade]
 	if( hsSong == nullptr )
 		return;
 
-	FOREACH_ENUM( Grade,g)
+	for (std::pair<StepsID const, HighScoresForASteps> const &it : hsSong->m_StepsHighScores)
 	{
-		for (std::pair<StepsID const, HighScoresForASteps> const &it : hsSong->m_StepsHighScores)
-		{
-			const StepsID &id = it.first;
-			if( !id.MatchesStepsType(st) )
-				continue;
+		const StepsID &id = it.first;
+		if( !id.MatchesStepsType(st) )
+			continue;
 
-			const HighScoresForASteps &hsSteps = it.second;
-			if( hsSteps.hsl.GetTopScore().GetGrade() == g )
-				iCounts[g]++;
-		}
+		// The list is kept sorted, so this is the best grade.
+		Grade g = it.second.hsl.GetTopScore().GetGrade();
+		if( g >= 0 && g < NUM_Grade )
+			iCounts[g]++;
 	}
 }
 
@@ -715,6 +737,18 @@ void Profile::GetGrades( const Song* pSong, StepsType st, int iCounts[NUM_Grade]
 void Profile::AddCourseHighScore( const Course* pCourse, const Trail* pTrail, HighScore hs, int &iIndexOut )
 {
 	GetCourseHighScoreList(pCourse,pTrail).AddHighScore( hs, iIndexOut, IsMachine() );
+	CourseScoresChanged( pCourse, pTrail );
+}
+
+void Profile::CourseScoresChanged( const Course* pCourse, const Trail* pTrail )
+{
+	CourseID courseID;
+	courseID.FromCourse( pCourse );
+
+	TrailID trailID;
+	trailID.FromTrail( pTrail );
+
+	m_ChangedTrailScores.insert( std::make_pair(courseID, trailID) );
 }
 
 const HighScoreList& Profile::GetCourseHighScoreList( const Course* pCourse, const Trail* pTrail ) const
@@ -786,6 +820,7 @@ void Profile::IncrementCoursePlayCount( const Course* pCourse, const Trail* pTra
 {
 	DateTime now = DateTime::GetNowDate();
 	GetCourseHighScoreList(pCourse,pTrail).IncrementPlayCount( now );
+	CourseScoresChanged( pCourse, pTrail );
 }
 
 void Profile::GetAllUsedHighScoreNames(std::set<RString>& names)
@@ -827,6 +862,7 @@ void Profile::GetAllUsedHighScoreNames(std::set<RString>& names)
 void Profile::MergeScoresFromOtherProfile(Profile* other, bool skip_totals,
 	RString const& from_dir, RString const& to_dir)
 {
+	m_bNeedFullStatsSave = true;
 	if(!skip_totals)
 	{
 #define MERGE_FIELD(field_name) field_name+= other->field_name;
@@ -1002,6 +1038,7 @@ void Profile::swap(Profile& other)
 	SWAP_ARRAY(m_iNumStagesPassedByGrade, NUM_Grade);
 	SWAP_GENERAL(m_UserTable);
 	SWAP_STR_MEMBER(m_SongHighScores);
+	SWAP_STR_MEMBER(m_SongScoreIndex.m);
 	SWAP_STR_MEMBER(m_CourseHighScores);
 	for(int st= 0; st < NUM_StepsType; ++st)
 	{
@@ -1009,6 +1046,10 @@ void Profile::swap(Profile& other)
 	}
 	SWAP_STR_MEMBER(m_vScreenshots);
 	SWAP_STR_MEMBER(m_mapDayToCaloriesBurned);
+	SWAP_STR_MEMBER(m_ChangedStepsScores);
+	SWAP_STR_MEMBER(m_ChangedTrailScores);
+	SWAP_GENERAL(m_iJournalSequence);
+	SWAP_GENERAL(m_bNeedFullStatsSave);
 #undef SWAP_STR_MEMBER
 #undef SWAP_GENERAL
 #undef SWAP_ARRAY
@@ -1232,6 +1273,10 @@ void Profile::LoadSongsFromDir(RString const& dir, ProfileSlot prof_slot)
 
 ProfileLoadResult Profile::LoadStatsFromDir(RString dir, bool require_signature)
 {
+	// Don't read Stats.xml while it's being rewritten.
+	StatsJournal::WaitForCompaction( dir );
+	ProfileWriter::Wait( dir );
+
 	dir= dir + PROFILEMAN->GetStatsPrefix();
 	// Check for the existance of stats.xml
 	RString fn = dir + STATS_XML;
@@ -1305,12 +1350,20 @@ ProfileLoadResult Profile::LoadStatsFromDir(RString dir, bool require_signature)
 	}
 
 	LOG->Trace("Loading %s", fn.c_str());
-	XNode xml;
-	if(!XmlFileUtil::LoadFromFileShowErrors(xml, *pFile.get()))
-		return ProfileLoadResult_FailedTampered;
+	m_iJournalSequence = 0;
+	ProfileLoadResult ret = LoadStatsXmlFromFile(*pFile.get());
 	LOG->Trace("Done.");
 
-	return LoadStatsXmlFromNode(&xml);
+	// The journal isn't signed, so it's only used for unsigned profiles.
+	if(ret == ProfileLoadResult_Success && !require_signature)
+	{
+		LoadStatsJournalFromDir(dir);
+		m_ChangedStepsScores.clear();
+		m_ChangedTrailScores.clear();
+		m_bNeedFullStatsSave = false;
+	}
+
+	return ret;
 }
 
 void Profile::LoadTypeFromDir(RString dir)
@@ -1359,6 +1412,9 @@ ProfileLoadResult Profile::LoadStatsXmlFromNode( const XNode *xml, bool bIgnoreE
 		return ProfileLoadResult_FailedTampered;
 	}
 
+	// Journal records don't have this.
+	xml->GetAttrValue( "JournalSequence", m_iJournalSequence );
+
 	// These are loaded from Editable, so we usually want to ignore them here.
 	RString sName = m_sDisplayName;
 	RString sCharacterID = m_sCharacterID;
@@ -1391,7 +1447,82 @@ ProfileLoadResult Profile::LoadStatsXmlFromNode( const XNode *xml, bool bIgnoreE
 	return ProfileLoadResult_Success;
 }
 
-bool Profile::SaveAllToDir( RString sDir, bool bSignData ) const
+namespace
+{
+/* Years of scores make a machine's Stats.xml huge, and nearly all of it is
+ * SongScores.  Load each <Song> as soon as it's been read, and keep only the
+ * other sections as a tree, for LoadStatsXmlFromNode. */
+class StatsXmlVisitor: public XmlFileUtil::XmlVisitor
+{
+public:
+	explicit StatsXmlVisitor( Profile *pProfile ): m_pProfile(pProfile), m_iDepth(0) { }
+
+	XmlFileUtil::XmlElementAction StartElement( const RString &sName, const XmlFileUtil::XmlAttributes &attrs )
+	{
+		switch( m_iDepth )
+		{
+		case 0:
+			// LoadStatsXmlFromNode checks the root's name.
+			m_pStats.reset( new XNode(sName) );
+			for( const std::pair<RString,RString> &attr : attrs )
+				m_pStats->AppendAttr( attr.first, attr.second );
+			if( sName != "Stats" )
+				return XmlFileUtil::XmlSkip;
+			break;
+		case 1:
+			if( sName != "SongScores" )
+				return XmlFileUtil::XmlCapture;
+			// Loaded as it's read; leave it empty for LoadStatsXmlFromNode.
+			m_pStats->AppendChild( sName );
+			break;
+		default:
+			return sName == "Song"? XmlFileUtil::XmlCapture: XmlFileUtil::XmlSkip;
+		}
+
+		++m_iDepth;
+		return XmlFileUtil::XmlDescend;
+	}
+
+	void EndElement( const RString &sName, const RString &sText )
+	{
+		--m_iDepth;
+	}
+
+	void Captured( XNode *pNode )
+	{
+		if( m_iDepth == 1 )
+		{
+			m_pStats->AppendChild( pNode );
+			return;
+		}
+
+		m_pProfile->LoadSongScoresFromSongNode( pNode );
+		delete pNode;
+	}
+
+	const XNode *GetStats() const { return m_pStats.get(); }
+
+private:
+	Profile *m_pProfile;
+	int m_iDepth;
+	std::unique_ptr<XNode> m_pStats;
+};
+}
+
+ProfileLoadResult Profile::LoadStatsXmlFromFile( RageFileBasic &f, bool bIgnoreEditable )
+{
+	StatsXmlVisitor visitor( this );
+	if( !XmlFileUtil::LoadStreamShowErrors(f, visitor) )
+	{
+		// Don't keep the scores read before the error.
+		InitSongScores();
+		return ProfileLoadResult_FailedTampered;
+	}
+
+	return LoadStatsXmlFromNode( visitor.GetStats(), bIgnoreEditable );
+}
+
+bool Profile::SaveAllToDir( RString sDir, bool bSignData, bool bJournal, bool bInBackground ) const
 {
 	m_sLastPlayedMachineGuid = PROFILEMAN->GetMachineProfile()->m_sGuid;
 	m_LastPlayedDate = DateTime::GetNowDate();
@@ -1400,7 +1531,16 @@ bool Profile::SaveAllToDir( RString sDir, bool bSignData ) const
 	// Save editable.ini
 	SaveEditableDataToDir( sDir );
 
-	bool bSaved = SaveStatsXmlToDir( sDir, bSignData );
+	bool bSaved = false;
+	if( bJournal && !bSignData && !m_bNeedFullStatsSave )
+		bSaved = SaveStatsJournalToDir( sDir );
+	if( !bSaved )
+		bSaved = SaveStatsXmlToDir( sDir, bSignData, bInBackground );
+	if( bJournal && bSaved )
+	{
+		m_bNeedFullStatsSave = false;
+		ForgetSavedScoreChanges();
+	}
 
 	SaveStatsWebPageToDir( sDir );
 
@@ -1439,6 +1579,8 @@ bool Profile::SaveAllToDir( RString sDir, bool bSignData ) const
 XNode *Profile::SaveStatsXmlCreateNode() const
 {
 	XNode *xml = new XNode( "Stats" );
+	if( m_iJournalSequence != 0 )
+		xml->AppendAttr( "JournalSequence", m_iJournalSequence );
 
 	xml->AppendChild( SaveGeneralDataCreateNode() );
 	xml->AppendChild( SaveSongScoresCreateNode() );
@@ -1452,51 +1594,59 @@ XNode *Profile::SaveStatsXmlCreateNode() const
 	return xml;
 }
 
-bool Profile::SaveStatsXmlToDir( RString sDir, bool bSignData ) const
+/* sDir includes the stats prefix.  This doesn't touch the profile, so it can
+ * be run from the journal's compaction thread and from ProfileWriter. */
+static bool WriteStatsXml( const XNode *xml, const RString &sDir, bool bCompress, int iMode, RString &sErrorOut )
 {
-	LOG->Trace( "SaveStatsXmlToDir: %s", sDir.c_str() );
-	std::unique_ptr<XNode> xml( SaveStatsXmlCreateNode() );
+	RString fn = sDir + (bCompress? STATS_XML_GZ:STATS_XML);
 
-	sDir= sDir + PROFILEMAN->GetStatsPrefix();
-	// Save stats.xml
-	RString fn = sDir + (g_bProfileDataCompress? STATS_XML_GZ:STATS_XML);
+	RageFile f;
+	if( !f.Open(fn, iMode) )
+	{
+		sErrorOut = ssprintf( "Couldn't open %s for writing: %s", fn.c_str(), f.GetError().c_str() );
+		return false;
+	}
 
+	if( bCompress )
 	{
-		RString sError;
-		RageFile f;
-		if( !f.Open(fn, RageFile::WRITE) )
-		{
-			LuaHelpers::ReportScriptErrorFmt( "Couldn't open %s for writing: %s", fn.c_str(), f.GetError().c_str() );
+		RageFileObjGzip gzip( &f );
+		gzip.Start();
+		if( !XmlFileUtil::SaveToFile( xml, gzip, "", false ) )
 			return false;
-		}
 
-		if( g_bProfileDataCompress )
-		{
-			RageFileObjGzip gzip( &f );
-			gzip.Start();
-			if( !XmlFileUtil::SaveToFile( xml.get(), gzip, "", false ) )
-				return false;
-
-			if( gzip.Finish() == -1 )
-				return false;
+		if( gzip.Finish() == -1 )
+			return false;
 
-			/* After successfully saving STATS_XML_GZ, remove any stray STATS_XML. */
-			if( FILEMAN->IsAFile(sDir + STATS_XML) )
-				FILEMAN->Remove( sDir + STATS_XML );
-		}
-		else
-		{
-			if( !XmlFileUtil::SaveToFile( xml.get(), f, "", false ) )
-				return false;
+		/* After successfully saving STATS_XML_GZ, remove any stray STATS_XML. */
+		if( FILEMAN->IsAFile(sDir + STATS_XML) )
+			FILEMAN->Remove( sDir + STATS_XML );
+	}
+	else
+	{
+		if( !XmlFileUtil::SaveToFile( xml, f, "", false ) )
+			return false;
 
-			/* After successfully saving STATS_XML, remove any stray STATS_XML_GZ. */
-			if( FILEMAN->IsAFile(sDir + STATS_XML_GZ) )
-				FILEMAN->Remove( sDir + STATS_XML_GZ );
-		}
+		/* After successfully saving STATS_XML, remove any stray STATS_XML_GZ. */
+		if( FILEMAN->IsAFile(sDir + STATS_XML_GZ) )
+			FILEMAN->Remove( sDir + STATS_XML_GZ );
 	}
 
+	return true;
+}
+
+/* Write Stats.xml, remove the journal it replaces and sign it.  Like
+ * WriteStatsXml, this can be run from any thread. */
+static bool WriteAndSignStatsXml( const XNode *xml, const RString &sDir, bool bCompress, unsigned iJournalSequence, bool bSignData, RString &sErrorOut )
+{
+	if( !WriteStatsXml(xml, sDir, bCompress, RageFile::WRITE, sErrorOut) )
+		return false;
+
+	// Everything in the journal is in Stats.xml now.
+	StatsJournal::Remove( sDir + STATS_JOURNAL, iJournalSequence );
+
 	if( bSignData )
 	{
+		RString fn = sDir + (bCompress? STATS_XML_GZ:STATS_XML);
 		RString sStatsXmlSigFile = fn+SIGNATURE_APPEND;
 		CryptManager::SignFileToFile(fn, sStatsXmlSigFile);
 
@@ -1508,6 +1658,187 @@ bool Profile::SaveStatsXmlToDir( RString sDir, bool bSignData ) const
 	return true;
 }
 
+bool Profile::SaveStatsXmlToDir( RString sDir, bool bSignData, bool bInBackground ) const
+{
+	LOG->Trace( "SaveStatsXmlToDir: %s", sDir.c_str() );
+
+	std::shared_ptr<XNode> xml( SaveStatsXmlCreateNode() );
+
+	sDir= sDir + PROFILEMAN->GetStatsPrefix();
+	// Don't race a compaction that's writing the same file.
+	StatsJournal::WaitForCompaction( sDir );
+	const bool bCompress = g_bProfileDataCompress;
+	const unsigned iSequence = m_iJournalSequence;
+
+	if( bInBackground )
+	{
+		/* The tree is a snapshot of the profile, so it can go on changing while
+		 * the tree is written. */
+		ProfileWriter::Start( sDir, [xml, sDir, bCompress, iSequence, bSignData]()
+		{
+			RString sError;
+			if( !WriteAndSignStatsXml(xml.get(), sDir, bCompress, iSequence, bSignData, sError) )
+				LOG->Warn( "Couldn't save stats to %s: %s", sDir.c_str(), sError.c_str() );
+		} );
+		return true;
+	}
+
+	// Land after any background save of the same profile.
+	ProfileWriter::Wait( sDir );
+
+	RString sError;
+	if( !WriteAndSignStatsXml(xml.get(), sDir, bCompress, iSequence, bSignData, sError) )
+	{
+		if( !sError.empty() )
+			LuaHelpers::ReportScriptError( sError );
+		return false;
+	}
+
+	return true;
+}
+
+XNode *Profile::SaveStatsJournalCreateNode() const
+{
+	/* The song and course scores are most of a profile; only the ones that
+	 * have changed are recorded.  Everything else is small, and recorded
+	 * whole, so that a record can be loaded like Stats.xml. */
+	XNode *xml = new XNode( "Stats" );
+	xml->AppendChild( SaveGeneralDataCreateNode() );
+
+	XNode *pSongScores = xml->AppendChild( "SongScores" );
+	XNode *pSongNode = nullptr;
+	const SongID *pLastSongID = nullptr;
+	for( const std::pair<SongID,StepsID> &changed : m_ChangedStepsScores )
+	{
+		const HighScoresForASong *hsSong = GetHighScoresForASong( changed.first );
+		if( hsSong == nullptr )
+			continue;
+		std::map<StepsID,HighScoresForASteps>::const_iterator it = hsSong->m_StepsHighScores.find( changed.second );
+		if( it == hsSong->m_StepsHighScores.end() )
+			continue;
+
+		// The set is sorted, so each song's steps are together.
+		if( pLastSongID == nullptr || *pLastSongID < changed.first )
+		{
+			pSongNode = pSongScores->AppendChild( changed.first.CreateNode() );
+			pLastSongID = &changed.first;
+		}
+		XNode *pStepsNode = pSongNode->AppendChild( changed.second.CreateNode() );
+		pStepsNode->AppendChild( it->second.hsl.CreateNode() );
+	}
+
+	XNode *pCourseScores = xml->AppendChild( "CourseScores" );
+	XNode *pCourseNode = nullptr;
+	const CourseID *pLastCourseID = nullptr;
+	for( const std::pair<CourseID,TrailID> &changed : m_ChangedTrailScores )
+	{
+		const HighScoresForACourse *hsCourse = GetHighScoresForACourse( changed.first );
+		if( hsCourse == nullptr )
+			continue;
+		std::map<TrailID,HighScoresForATrail>::const_iterator it = hsCourse->m_TrailHighScores.find( changed.second );
+		if( it == hsCourse->m_TrailHighScores.end() )
+			continue;
+
+		if( pLastCourseID == nullptr || *pLastCourseID < changed.first )
+		{
+			pCourseNode = pCourseScores->AppendChild( changed.first.CreateNode() );
+			pLastCourseID = &changed.first;
+		}
+		XNode *pTrailNode = pCourseNode->AppendChild( changed.second.CreateNode() );
+		pTrailNode->AppendChild( it->second.hsl.CreateNode() );
+	}
+
+	xml->AppendChild( SaveCategoryScoresCreateNode() );
+	xml->AppendChild( SaveScreenshotDataCreateNode() );
+	xml->AppendChild( SaveCalorieDataCreateNode() );
+
+	return xml;
+}
+
+bool Profile::SaveStatsJournalToDir( RString sDir ) const
+{
+	LOG->Trace( "SaveStatsJournalToDir: %s", sDir.c_str() );
+
+	sDir= sDir + PROFILEMAN->GetStatsPrefix();
+	const RString sJournal = sDir + STATS_JOURNAL;
+
+	std::unique_ptr<XNode> xml( SaveStatsJournalCreateNode() );
+	if( !StatsJournal::Append(sJournal, m_iJournalSequence+1, xml.get()) )
+		return false;
+	++m_iJournalSequence;
+
+	if( StatsJournal::GetSize(sJournal) < g_iStatsJournalCompactKB*1024 || StatsJournal::IsCompacting() )
+		return true;
+
+	/* Compact the journal into Stats.xml.  The tree has to be built here, while
+	 * nothing's changing the profile, but writing it out is most of the work,
+	 * and that's done in the background.  Records appended in the meantime
+	 * keep the journal from being removed. */
+	LOG->Trace( "Compacting %s", sJournal.c_str() );
+	// A background save of Stats.xml mustn't land after the compaction.
+	ProfileWriter::Wait( sDir );
+	std::shared_ptr<XNode> pStats( SaveStatsXmlCreateNode() );
+	const unsigned iSequence = m_iJournalSequence;
+	const bool bCompress = g_bProfileDataCompress;
+	StatsJournal::StartCompaction( sDir, [pStats, sDir, sJournal, iSequence, bCompress]()
+	{
+		RString sError;
+		if( !WriteStatsXml(pStats.get(), sDir, bCompress, RageFile::WRITE|RageFile::SLOW_FLUSH, sError) )
+		{
+			LOG->Warn( "Couldn't compact %s: %s", sJournal.c_str(), sError.c_str() );
+			return;
+		}
+		StatsJournal::Remove( sJournal, iSequence );
+	} );
+	return true;
+}
+
+void Profile::LoadStatsJournalFromDir( RString sDir )
+{
+	StatsJournal::Replay( sDir + STATS_JOURNAL, m_iJournalSequence, [this]( unsigned iSequence, const XNode *pStats )
+	{
+		// Records hold all of the screenshot data, not just what's new.
+		InitScreenshotData();
+		LoadStatsXmlFromNode( pStats );
+		m_iJournalSequence = iSequence;
+	} );
+}
+
+/* A score still waiting for its name will change again when the name is
+ * entered, so it has to be saved again then. */
+static bool HasScoreToFillIn( const HighScoreList &hsl )
+{
+	for( const HighScore &hs : hsl.vHighScores )
+		if( IsRankingToFillIn(hs.GetName()) )
+			return true;
+	return false;
+}
+
+void Profile::ForgetSavedScoreChanges() const
+{
+	for( std::set<std::pair<SongID,StepsID> >::iterator it = m_ChangedStepsScores.begin(); it != m_ChangedStepsScores.end(); )
+	{
+		const HighScoresForASong *hsSong = GetHighScoresForASong( it->first );
+		std::map<StepsID,HighScoresForASteps>::const_iterator steps;
+		if( hsSong != nullptr && (steps = hsSong->m_StepsHighScores.find(it->second)) != hsSong->m_StepsHighScores.end() &&
+			HasScoreToFillIn(steps->second.hsl) )
+			++it;
+		else
+			m_ChangedStepsScores.erase( it++ );
+	}
+
+	for( std::set<std::pair<CourseID,TrailID> >::iterator it = m_ChangedTrailScores.begin(); it != m_ChangedTrailScores.end(); )
+	{
+		const HighScoresForACourse *hsCourse = GetHighScoresForACourse( it->first );
+		std::map<TrailID,HighScoresForATrail>::const_iterator trail;
+		if( hsCourse != nullptr && (trail = hsCourse->m_TrailHighScores.find(it->second)) != hsCourse->m_TrailHighScores.end() &&
+			HasScoreToFillIn(trail->second.hsl) )
+			++it;
+		else
+			m_ChangedTrailScores.erase( it++ );
+	}
+}
+
 void Profile::SaveTypeToDir(RString dir) const
 {
 	IniFile ini;
@@ -2041,30 +2372,35 @@ void Profile::LoadSongScoresFromNode( const XNode* pSongScores )
 		if( pSong->GetName() != "Song" )
 			continue;
 
-		SongID songID;
-		songID.LoadFromNode( pSong );
-		// Allow invalid songs so that scores aren't deleted for people that use
-		// AdditionalSongsFolders and change it frequently. -Kyz
-		//if( !songID.IsValid() )
-		//	continue;
+		LoadSongScoresFromSongNode( pSong );
+	}
+}
 
-		FOREACH_CONST_Child( pSong, pSteps )
-		{
-			if( pSteps->GetName() != "Steps" )
-				continue;
+void Profile::LoadSongScoresFromSongNode( const XNode* pSong )
+{
+	SongID songID;
+	songID.LoadFromNode( pSong );
+	// Allow invalid songs so that scores aren't deleted for people that use
+	// AdditionalSongsFolders and change it frequently. -Kyz
+	//if( !songID.IsValid() )
+	//	return;
 
-			StepsID stepsID;
-			stepsID.LoadFromNode( pSteps );
-			if( !stepsID.IsValid() )
-				WARN_AND_CONTINUE;
+	FOREACH_CONST_Child( pSong, pSteps )
+	{
+		if( pSteps->GetName() != "Steps" )
+			continue;
 
-			const XNode *pHighScoreListNode = pSteps->GetChild("HighScoreList");
-			if( pHighScoreListNode == nullptr )
-				WARN_AND_CONTINUE;
+		StepsID stepsID;
+		stepsID.LoadFromNode( pSteps );
+		if( !stepsID.IsValid() )
+			WARN_AND_CONTINUE;
 
-			HighScoreList &hsl = m_SongHighScores[songID].m_StepsHighScores[stepsID].hsl;
-			hsl.LoadFromNode( pHighScoreListNode );
-		}
+		const XNode *pHighScoreListNode = pSteps->GetChild("HighScoreList");
+		if( pHighScoreListNode == nullptr )
+			WARN_AND_CONTINUE;
+
+		HighScoreList &hsl = GetOrAddHighScoresForASong( songID ).m_StepsHighScores[stepsID].hsl;
+		hsl.LoadFromNode( pHighScoreListNode );
 	}
 }
 
@@ -2429,13 +2765,30 @@ void Profile::SaveCourseRecentScore( const Course* pCourse, const Trail* pTrail,
 */
 const Profile::HighScoresForASong *Profile::GetHighScoresForASong( const SongID& songID ) const
 {
+	std::unordered_map<SongID, HighScoresForASong *, SongID::Hash>::const_iterator indexed = m_SongScoreIndex.m.find( songID );
+	if( indexed != m_SongScoreIndex.m.end() )
+		return indexed->second;
+
 	std::map<SongID, HighScoresForASong>::const_iterator it;
 	it = m_SongHighScores.find( songID );
 	if( it == m_SongHighScores.end() )
 		return nullptr;
+	// Songs that aren't in the map yet aren't indexed, since they may be added.
+	m_SongScoreIndex.m[songID] = const_cast<HighScoresForASong *>( &it->second );
 	return &it->second;
 }
 
+Profile::HighScoresForASong &Profile::GetOrAddHighScoresForASong( const SongID& songID )
+{
+	std::unordered_map<SongID, HighScoresForASong *, SongID::Hash>::const_iterator indexed = m_SongScoreIndex.m.find( songID );
+	if( indexed != m_SongScoreIndex.m.end() )
+		return *indexed->second;
+
+	HighScoresForASong &hsSong = m_SongHighScores[songID];	// operator[] inserts into map
+	m_SongScoreIndex.m[songID] = &hsSong;
+	return hsSong;
+}
+
 const Profile::HighScoresForACourse *Profile::GetHighScoresForACourse( const CourseID& courseID ) const
 {
 	std::map<CourseID, HighScoresForACourse>::const_iterator it;
@@ -2495,23 +2848,30 @@ XNode* Profile::SaveCoinDataCreateNode() const
 
 void Profile::MoveBackupToDir( RString sFromDir, RString sToDir )
 {
-	if( FILEMAN->IsAFile(sFromDir + STATS_XML) &&
-		FILEMAN->IsAFile(sFromDir+STATS_XML+SIGNATURE_APPEND) )
-	{
-		FILEMAN->Move( sFromDir+STATS_XML,					sToDir+STATS_XML );
-		FILEMAN->Move( sFromDir+STATS_XML+SIGNATURE_APPEND,	sToDir+STATS_XML+SIGNATURE_APPEND );
-	}
-	else if( FILEMAN->IsAFile(sFromDir + STATS_XML_GZ) &&
-		FILEMAN->IsAFile(sFromDir+STATS_XML_GZ+SIGNATURE_APPEND) )
-	{
-		FILEMAN->Move( sFromDir+STATS_XML_GZ,					sToDir+STATS_XML );
-		FILEMAN->Move( sFromDir+STATS_XML_GZ+SIGNATURE_APPEND,	sToDir+STATS_XML+SIGNATURE_APPEND );
-	}
-
+	/* Each file is moved on the thread that writes its replacement: Editable.ini
+	 * now, and the stats in a job queued ahead of the save that rewrites them,
+	 * so nothing waits for saves of other profiles. */
 	if( FILEMAN->IsAFile(sFromDir + EDITABLE_INI) )
 		FILEMAN->Move( sFromDir+EDITABLE_INI,				sToDir+EDITABLE_INI );
-	if( FILEMAN->IsAFile(sFromDir + DONT_SHARE_SIG) )
-		FILEMAN->Move( sFromDir+DONT_SHARE_SIG,				sToDir+DONT_SHARE_SIG );
+
+	ProfileWriter::Start( sFromDir, [sFromDir, sToDir]()
+	{
+		if( FILEMAN->IsAFile(sFromDir + STATS_XML) &&
+			FILEMAN->IsAFile(sFromDir+STATS_XML+SIGNATURE_APPEND) )
+		{
+			FILEMAN->Move( sFromDir+STATS_XML,					sToDir+STATS_XML );
+			FILEMAN->Move( sFromDir+STATS_XML+SIGNATURE_APPEND,	sToDir+STATS_XML+SIGNATURE_APPEND );
+		}
+		else if( FILEMAN->IsAFile(sFromDir + STATS_XML_GZ) &&
+			FILEMAN->IsAFile(sFromDir+STATS_XML_GZ+SIGNATURE_APPEND) )
+		{
+			FILEMAN->Move( sFromDir+STATS_XML_GZ,					sToDir+STATS_XML );
+			FILEMAN->Move( sFromDir+STATS_XML_GZ+SIGNATURE_APPEND,	sToDir+STATS_XML+SIGNATURE_APPEND );
+		}
+
+		if( FILEMAN->IsAFile(sFromDir + DONT_SHARE_SIG) )
+			FILEMAN->Move( sFromDir+DONT_SHARE_SIG,				sToDir+DONT_SHARE_SIG );
+	} );
 }
 
 RString Profile::MakeUniqueFileNameNoExtension( RString sDir, RString sFileNameBeginning )
@@ -16,10 +16,12 @@
 #include <deque>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 
 class XNode;
+class RageFileBasic;
 struct lua_State;
 class Character;
 
@@ -115,7 +117,8 @@ public:
 		m_LastPlayedDate(),m_iNumSongsPlayedByStyle(),
 		m_iNumTotalSongsPlayed(0), m_UserTable(), m_SongHighScores(),
 		m_CourseHighScores(), m_vScreenshots(),
-		m_mapDayToCaloriesBurned()
+		m_mapDayToCaloriesBurned(), m_iJournalSequence(0),
+		m_bNeedFullStatsSave(true)
 	{
 		m_lastSong.Unset();
 		m_lastCourse.Unset();
@@ -406,12 +409,18 @@ public:
 	void LoadSongsFromDir(RString const& dir, ProfileSlot prof_slot);
 	void LoadTypeFromDir(RString dir);
 	void LoadCustomFunction(RString sDir, PlayerNumber pn);
-	bool SaveAllToDir( RString sDir, bool bSignData ) const;
+	/* If bJournal, only record what's changed since the last save to sDir in
+	 * the stats journal, instead of rewriting Stats.xml; see StatsJournal.
+	 * If bInBackground, Stats.xml is written and signed by ProfileWriter, and
+	 * true only means the save was started. */
+	bool SaveAllToDir( RString sDir, bool bSignData, bool bJournal = false, bool bInBackground = false ) const;
 
 	ProfileLoadResult LoadEditableDataFromDir( RString sDir );
 	ProfileLoadResult LoadStatsXmlFromNode( const XNode* pNode, bool bIgnoreEditable = true );
+	ProfileLoadResult LoadStatsXmlFromFile( RageFileBasic &f, bool bIgnoreEditable = true );
 	void LoadGeneralDataFromNode( const XNode* pNode );
 	void LoadSongScoresFromNode( const XNode* pNode );
+	void LoadSongScoresFromSongNode( const XNode* pSong );
 	void LoadCourseScoresFromNode( const XNode* pNode );
 	void LoadCategoryScoresFromNode( const XNode* pNode );
 	void LoadScreenshotDataFromNode( const XNode* pNode );
@@ -419,8 +428,11 @@ public:
 
 	void SaveTypeToDir(RString dir) const;
 	void SaveEditableDataToDir( RString sDir ) const;
-	bool SaveStatsXmlToDir( RString sDir, bool bSignData ) const;
+	bool SaveStatsXmlToDir( RString sDir, bool bSignData, bool bInBackground = false ) const;
+	bool SaveStatsJournalToDir( RString sDir ) const;
+	void LoadStatsJournalFromDir( RString sDir );
 	XNode* SaveStatsXmlCreateNode() const;
+	XNode* SaveStatsJournalCreateNode() const;
 	XNode* SaveGeneralDataCreateNode() const;
 	XNode* SaveSongScoresCreateNode() const;
 	XNode* SaveCourseScoresCreateNode() const;
@@ -442,7 +454,36 @@ public:
 
 private:
 	const HighScoresForASong *GetHighScoresForASong( const SongID& songID ) const;
+	HighScoresForASong &GetOrAddHighScoresForASong( const SongID& songID );
 	const HighScoresForACourse *GetHighScoresForACourse( const CourseID& courseID ) const;
+
+	void StepsScoresChanged( const Song* pSong, const Steps* pSteps );
+	void CourseScoresChanged( const Course* pCourse, const Trail* pTrail );
+	void ForgetSavedScoreChanges() const;
+
+	// Scores changed since the last save, for the stats journal.
+	mutable std::set<std::pair<SongID,StepsID> > m_ChangedStepsScores;
+	mutable std::set<std::pair<CourseID,TrailID> > m_ChangedTrailScores;
+	// The last journal record saved or loaded.
+	mutable unsigned m_iJournalSequence;
+	// Set when scores change in ways the journal can't record, like being
+	// cleared or merged.
+	mutable bool m_bNeedFullStatsSave;
+
+	/* m_SongHighScores, hashed by song.  Finding a song in the map compares
+	 * song directories all the way down, and sorting the wheel by grade looks
+	 * up every song.  Entries are added as songs are looked up, and point
+	 * into m_SongHighScores, whose nodes never move; nothing is ever erased
+	 * from it except by clearing it all. */
+	struct SongScoreIndex
+	{
+		SongScoreIndex() { }
+		// The entries belong to one profile's map, so copies start out empty.
+		SongScoreIndex( const SongScoreIndex & ) { }
+		SongScoreIndex &operator=( const SongScoreIndex & ) { m.clear(); return *this; }
+		std::unordered_map<SongID, HighScoresForASong *, SongID::Hash> m;
+	};
+	mutable SongScoreIndex m_SongScoreIndex;
 };
 
 
@@ -23,6 +23,8 @@
 #include "HighScore.h"
 #include "Character.h"
 #include "CharacterManager.h"
+#include "StatsJournal.h"
+#include "ProfileWriter.h"
 
 #include <cstddef>
 #include <vector>
@@ -53,6 +55,8 @@ const RString LAST_GOOD_SUBDIR	=	"LastGood/";
 // Directories to search for a profile if m_sMemoryCardProfileSubdir doesn't
 // exist, separated by ";":
 static Preference<RString> g_sMemoryCardProfileImportSubdirs( "MemoryCardProfileImportSubdirs", "StepMania 5.1;StepMania 5;In The Groove 2" );
+static Preference<bool> g_bMachineStatsJournal( "MachineStatsJournal", true );
+static Preference<bool> g_bBackgroundProfileSave( "BackgroundProfileSave", true );
 
 static RString LocalProfileIDToDir( const RString &sProfileID ) { return USER_PROFILES_DIR + sProfileID + "/"; }
 static RString LocalProfileDirToID( const RString &sDir ) { return Basename( sDir ); }
@@ -97,6 +101,8 @@ ProfileManager::~ProfileManager()
 	// Unregister with Lua.
 	LUA->UnsetGlobal( "PROFILEMAN" );
 
+	ProfileWriter::Shutdown();
+	StatsJournal::Shutdown();
 	SAFE_DELETE( m_pMachineProfile );
 	FOREACH_PlayerNumber(pn)
 		SAFE_DELETE( m_pMemoryCardProfile[pn] );
@@ -369,7 +375,7 @@ bool ProfileManager::SaveProfile( PlayerNumber pn ) const
 		Profile::MoveBackupToDir( m_sProfileDir[pn], sBackupDir );
 	}
 
-	bool b = GetProfile(pn)->SaveAllToDir( m_sProfileDir[pn], PREFSMAN->m_bSignProfileData );
+	bool b = GetProfile(pn)->SaveAllToDir( m_sProfileDir[pn], PREFSMAN->m_bSignProfileData, false, g_bBackgroundProfileSave );
 
 	return b;
 }
@@ -379,7 +385,7 @@ bool ProfileManager::SaveLocalProfile( RString sProfileID )
 	const Profile *pProfile = GetLocalProfile( sProfileID );
 	ASSERT( pProfile != nullptr );
 	RString sDir = LocalProfileIDToDir( sProfileID );
-	bool b = pProfile->SaveAllToDir( sDir, PREFSMAN->m_bSignProfileData );
+	bool b = pProfile->SaveAllToDir( sDir, PREFSMAN->m_bSignProfileData, false, g_bBackgroundProfileSave );
 	return b;
 }
 
@@ -791,6 +797,9 @@ bool ProfileManager::DeleteLocalProfile( RString sProfileID )
 	ASSERT( pProfile != nullptr );
 	RString sProfileDir = LocalProfileIDToDir( sProfileID );
 
+	// Don't delete it out from under a save.
+	ProfileWriter::Wait( sProfileDir );
+
 	// flush directory cache in an attempt to get this working
 	FILEMAN->FlushDirCache( sProfileDir );
 
@@ -830,7 +839,9 @@ void ProfileManager::SaveMachineProfile() const
 	// are saved, so that the Player's profiles show the right machine name.
 	const_cast<ProfileManager *> (this)->m_pMachineProfile->m_sDisplayName = PREFSMAN->m_sMachineName;
 
-	m_pMachineProfile->SaveAllToDir( MACHINE_PROFILE_DIR, false ); /* don't sign machine profiles */
+	/* don't sign machine profiles; journal their scores instead of rewriting
+	 * all of them after every song */
+	m_pMachineProfile->SaveAllToDir( MACHINE_PROFILE_DIR, false, g_bMachineStatsJournal, g_bBackgroundProfileSave );
 }
 
 void ProfileManager::LoadMachineProfile()
@@ -0,0 +1,120 @@
+#include "global.h"
+#include "ProfileWriter.h"
+#include "RageUtil.h"
+#include "RageUtil_ThreadPool.h"
+
+#include <chrono>
+#include <deque>
+#include <future>
+#include <vector>
+
+static RageThreadPool *g_pWriterThread = nullptr;
+
+struct PendingJob
+{
+	RString sDir;
+	std::future<void> done;
+};
+
+/* Jobs that haven't been seen to finish, oldest first.  They run in order on
+ * one thread, so when a job is done, every job before it is too. */
+static std::deque<PendingJob> g_Jobs;
+
+struct IdleCallback
+{
+	RString sDir;
+	std::function<void()> callback;
+};
+static std::vector<IdleCallback> g_vIdleCallbacks;
+
+/* A job writing a profile's directory touches everything inside it, so a
+ * memory card's mount point is busy while a profile on it is being saved. */
+static bool SameTree( const RString &sDir1, const RString &sDir2 )
+{
+	return BeginsWith( sDir1, sDir2 ) || BeginsWith( sDir2, sDir1 );
+}
+
+static void PruneFinishedJobs()
+{
+	while( !g_Jobs.empty() && g_Jobs.front().done.wait_for(std::chrono::seconds(0)) == std::future_status::ready )
+		g_Jobs.pop_front();
+}
+
+void ProfileWriter::Start( const RString &sDir, const std::function<void()> &job )
+{
+	if( g_pWriterThread == nullptr )
+		g_pWriterThread = new RageThreadPool( "ProfileWriter", 1 );
+	PendingJob pending;
+	pending.sDir = sDir;
+	pending.done = g_pWriterThread->Submit( job );
+	g_Jobs.push_back( std::move(pending) );
+}
+
+bool ProfileWriter::IsBusy()
+{
+	PruneFinishedJobs();
+	return !g_Jobs.empty();
+}
+
+bool ProfileWriter::IsBusy( const RString &sDir )
+{
+	PruneFinishedJobs();
+	for( const PendingJob &job : g_Jobs )
+	{
+		if( SameTree(job.sDir, sDir) )
+			return true;
+	}
+	return false;
+}
+
+void ProfileWriter::Wait( const RString &sDir )
+{
+	// Waiting for the last job for sDir waits for the ones before it, too.
+	for( auto it = g_Jobs.rbegin(); it != g_Jobs.rend(); ++it )
+	{
+		if( SameTree(it->sDir, sDir) )
+		{
+			it->done.wait();
+			break;
+		}
+	}
+	PruneFinishedJobs();
+}
+
+void ProfileWriter::WhenIdle( const RString &sDir, const std::function<void()> &callback )
+{
+	IdleCallback idle;
+	idle.sDir = sDir;
+	idle.callback = callback;
+	g_vIdleCallbacks.push_back( idle );
+}
+
+void ProfileWriter::Update()
+{
+	if( g_vIdleCallbacks.empty() )
+		return;
+
+	/* A callback may start another save, or add another callback. */
+	std::vector<IdleCallback> vCallbacks;
+	vCallbacks.swap( g_vIdleCallbacks );
+	for( IdleCallback &idle : vCallbacks )
+	{
+		if( IsBusy(idle.sDir) )
+			g_vIdleCallbacks.push_back( idle );
+		else
+			idle.callback();
+	}
+}
+
+void ProfileWriter::Shutdown()
+{
+	if( !g_Jobs.empty() )
+		g_Jobs.back().done.wait();
+	g_Jobs.clear();
+
+	std::vector<IdleCallback> vCallbacks;
+	vCallbacks.swap( g_vIdleCallbacks );
+	for( const IdleCallback &idle : vCallbacks )
+		idle.callback();
+	SAFE_DELETE( g_pWriterThread );
+}
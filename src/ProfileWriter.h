@@ -0,0 +1,45 @@
+/* ProfileWriter - writes saved profiles to disk on a worker thread. */
+
+#ifndef PROFILE_WRITER_H
+#define PROFILE_WRITER_H
+
+#include <functional>
+
+/* Saving a profile means writing, compressing and signing all of its scores,
+ * which can take long enough to be noticed.  Only building the tree has to be
+ * done on the main thread, while nothing's changing the profile; the tree is
+ * handed to a job that does the rest here.
+ *
+ * Jobs run one at a time, in the order they were started, so a later save of
+ * a profile always lands after an earlier one.  Each job is started for the
+ * profile directory it writes to.  Anything that reads, moves or unmounts a
+ * directory must Wait for it first; jobs writing other profiles don't hold
+ * it up.  Only call these from the main thread. */
+namespace ProfileWriter
+{
+	void Start( const RString &sDir, const std::function<void()> &job );
+
+	/* Whether any job hasn't finished yet. */
+	bool IsBusy();
+
+	/* Whether a job writing to sDir, or a directory inside or containing it,
+	 * hasn't finished yet. */
+	bool IsBusy( const RString &sDir );
+
+	/* Wait for every job started so far for sDir to finish. */
+	void Wait( const RString &sDir );
+
+	/* Run callback on the main thread, from Update, once no jobs are left
+	 * for sDir; for cleaning up after a save, such as unmounting its memory
+	 * card, without waiting for it. */
+	void WhenIdle( const RString &sDir, const std::function<void()> &callback );
+
+	/* Run the WhenIdle callbacks whose directories are idle.  Called every
+	 * frame. */
+	void Update();
+
+	/* Wait for every job, and run the remaining callbacks. */
+	void Shutdown();
+}
+
+#endif
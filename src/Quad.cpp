@@ -3,6 +3,8 @@
 #include "ActorUtil.h"
 #include "RageTextureManager.h"
 
+#include <typeinfo>
+
 REGISTER_ACTOR_CLASS( Quad );
 
 Quad::Quad()
@@ -16,6 +18,11 @@ void Quad::LoadFromNode( const XNode* pNode )
 	Actor::LoadFromNode( pNode );
 }
 
+bool Quad::IsIdle() const
+{
+	return typeid(*this) == typeid(Quad) && SpriteIsIdle();
+}
+
 /*
  * (c) 2005 Glenn Maynard
  * All rights reserved.
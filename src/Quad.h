@@ -16,6 +16,9 @@ public:
 	void LoadFromNode( const XNode* pNode );
 	/** @brief Copy the quad. */
 	virtual Quad *Copy() const;
+
+protected:
+	virtual bool IsIdle() const override;
 };
 
 #endif
@@ -4,6 +4,8 @@
 #include "GameConstantsAndTypes.h"
 #include "ThemeMetric.h"
 
+#include <vector>
+
 /** @brief Unknown radar values are given a default value. */
 #define RADAR_VAL_UNKNOWN -1
 
@@ -76,6 +78,32 @@ public:
 	void PushSelf( lua_State *L );
 };
 
+/** @brief Cached statistics on how a chart's notes are spread out, so themes
+ * can graph them without walking the NoteData. */
+struct NoteDensity
+{
+	/** @brief The number of notes in each four beat measure. */
+	std::vector<int> m_viNotesPerMeasure;
+	/** @brief The most notes per second in any one measure. */
+	float m_fPeakNPS;
+	/**
+	 * @brief The chart's stream breakdown, in measures.
+	 *
+	 * A positive value is a run of measures with a note on at least 16 rows,
+	 * and a negative value is the run of other measures that separates two
+	 * of them. */
+	std::vector<int> m_viStreamRuns;
+
+	NoteDensity(): m_fPeakNPS(0) { }
+	void Clear()
+	{
+		m_viNotesPerMeasure.clear();
+		m_fPeakNPS = 0;
+		m_viStreamRuns.clear();
+	}
+	bool IsEmpty() const { return m_viNotesPerMeasure.empty(); }
+};
+
 
 #endif
 
@@ -10,6 +10,7 @@
 #include "RageSurfaceUtils_Zoom.h"
 #include "RageSurfaceUtils_Dither.h"
 #include "RageSurface_Load.h"
+#include "RageTextureCache.h"
 #include "arch/Dialog/Dialog.h"
 #include "StepMania.h"
 
@@ -47,6 +48,12 @@ RageBitmapTexture::RageBitmapTexture( RageTextureID name ) :
 	Create();
 }
 
+RageBitmapTexture::RageBitmapTexture( RageTextureID name, RageSurface *pImage ) :
+	RageTexture( name ), m_uTexHandle(0)
+{
+	Create( pImage );
+}
+
 RageBitmapTexture::~RageBitmapTexture()
 {
 	Destroy();
@@ -68,16 +75,42 @@ void RageBitmapTexture::Reload()
  * Dither forces dithering when loading 16-bit textures.
  * Stretch forces the loaded image to fill the texture completely.
  */
-void RageBitmapTexture::Create()
+void RageBitmapTexture::Create( RageSurface *pDecoded )
 {
 	RageTextureID actualID = GetID();
 
 	ASSERT( actualID.filename != "" );
 
+	/* If the converted texture is cached, skip decoding and conversion entirely.
+	 * The frame dimension warning below is skipped too; it was already given
+	 * when the cache entry was written, and any change to the file misses. */
+	const bool bCacheable = RageTextureCache::IsCacheable( actualID );
+	RageTextureCache::CachedTexture cached;
+	if( bCacheable && RageTextureCache::Load(actualID, cached) )
+	{
+		m_iSourceWidth = cached.iSourceWidth;
+		m_iSourceHeight = cached.iSourceHeight;
+		m_iImageWidth = cached.iImageWidth;
+		m_iImageHeight = cached.iImageHeight;
+		m_iTextureWidth = cached.pImage->w;
+		m_iTextureHeight = cached.pImage->h;
+
+		m_uTexHandle = DISPLAY->CreateTexture( cached.pixfmt, cached.pImage, cached.bMipMaps );
+		delete cached.pImage;
+		delete pDecoded;
+
+		CreateFrameRects();
+		return;
+	}
+
 	/* Load the image into a RageSurface. */
 	RString error;
 	RageSurface *pImg = nullptr;
-	if(actualID.filename == TEXTUREMAN->GetScreenTextureID().filename)
+	if( pDecoded != nullptr )
+	{
+		pImg = pDecoded;
+	}
+	else if(actualID.filename == TEXTUREMAN->GetScreenTextureID().filename)
 	{
 		pImg= TEXTUREMAN->GetScreenSurface();
 	}
@@ -270,6 +303,18 @@ void RageBitmapTexture::Create()
 	RageSurfaceUtils::ConvertSurface( pImg, m_iTextureWidth, m_iTextureHeight,
 		pImg->fmt.BitsPerPixel, pImg->fmt.Mask[0], pImg->fmt.Mask[1], pImg->fmt.Mask[2], pImg->fmt.Mask[3] );
 
+	if( bCacheable )
+	{
+		cached.pImage = pImg;
+		cached.pixfmt = pixfmt;
+		cached.bMipMaps = actualID.bMipMaps;
+		cached.iSourceWidth = m_iSourceWidth;
+		cached.iSourceHeight = m_iSourceHeight;
+		cached.iImageWidth = m_iImageWidth;
+		cached.iImageHeight = m_iImageHeight;
+		RageTextureCache::Save( GetID(), cached );
+	}
+
 	m_uTexHandle = DISPLAY->CreateTexture( pixfmt, pImg, actualID.bMipMaps );
 
 	CreateFrameRects();
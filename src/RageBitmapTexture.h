@@ -7,10 +7,14 @@
 
 #include <cstddef>
 
+struct RageSurface;
 class RageBitmapTexture : public RageTexture
 {
 public:
 	RageBitmapTexture( RageTextureID name );
+	/* Create the texture from pImage, already decoded from name's file,
+	 * instead of decoding it again.  Takes ownership of pImage. */
+	RageBitmapTexture( RageTextureID name, RageSurface *pImage );
 	virtual ~RageBitmapTexture();
 	/* only called by RageTextureManager::InvalidateTextures */
 	virtual void Invalidate() { m_uTexHandle = 0; /* don't Destroy() */}
@@ -18,7 +22,7 @@ public:
 	virtual std::uintptr_t GetTexHandle() const { return m_uTexHandle; };	// accessed by RageDisplay
 
 private:
-	void Create();	// called by constructor and Reload
+	void Create( RageSurface *pDecoded = nullptr );	// called by constructor and Reload
 	void Destroy();
 	std::uintptr_t m_uTexHandle;	// treat as unsigned in OpenGL, IDirect3DTexture9* for D3D
 };
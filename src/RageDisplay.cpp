@@ -4,6 +4,7 @@
 #include "RageLog.h"
 #include "RageMath.h"
 #include "RageUtil.h"
+#include "RageUtil_SlabAllocator.h"
 #include "RageFile.h"
 #include "RageSurface_Save_BMP.h"
 #include "RageSurface_Save_JPEG.h"
@@ -36,6 +37,11 @@ static int g_iFramesRenderedSinceLastCheck,
 	   g_iNumChecksSinceLastReset;
 static RageTimer g_LastFrameEndedAt( RageZeroTimer );
 
+/* Slab allocations per frame, and how many of them went to the heap, over the
+ * last check.  Steady-state gameplay should go to the heap almost never. */
+static float g_fSlabAllocsPerFrame, g_fHeapAllocsPerFrame;
+static std::uint64_t g_iSlabAllocsAtLastCheck, g_iHeapAllocsAtLastCheck;
+
 struct Centering
 {
 	Centering( int iTranslateX = 0, int iTranslateY = 0, int iAddWidth = 0, int iAddHeight = 0 ):
@@ -143,6 +149,14 @@ void RageDisplay::ProcessStatsOnFlip()
 		g_iCFPS = g_iFramesRenderedSinceLastReset / g_iNumChecksSinceLastReset;
 		g_iCFPS = std::lrint( g_iCFPS / fActualTime );
 		g_iVPF = g_iVertsRenderedSinceLastCheck / g_iFramesRenderedSinceLastCheck;
+
+		const std::uint64_t iSlabAllocs = RageSlabAllocator::GetTotalAllocations();
+		const std::uint64_t iHeapAllocs = RageSlabAllocator::GetTotalHeapAllocations();
+		g_fSlabAllocsPerFrame = float(iSlabAllocs - g_iSlabAllocsAtLastCheck) / g_iFramesRenderedSinceLastCheck;
+		g_fHeapAllocsPerFrame = float(iHeapAllocs - g_iHeapAllocsAtLastCheck) / g_iFramesRenderedSinceLastCheck;
+		g_iSlabAllocsAtLastCheck = iSlabAllocs;
+		g_iHeapAllocsAtLastCheck = iHeapAllocs;
+
 		g_iFramesRenderedSinceLastCheck = g_iVertsRenderedSinceLastCheck = 0;
 		if( LOG_FPS )
 		{
@@ -170,6 +184,7 @@ RString RageDisplay::GetStats() const
 		s = "-- FPS\n-- av FPS\n-- VPF";
 
 	s = ssprintf( "%i FPS\n%i av FPS\n%i VPF", GetFPS(), GetCumFPS(), GetVPF() );
+	s += ssprintf( "\n%.1f APF (%.1f heap)", g_fSlabAllocsPerFrame, g_fHeapAllocsPerFrame );
 
 //	#if defined(_WINDOWS)
 	s += "\n"+this->GetApiDescription();
@@ -488,6 +503,13 @@ const RageMatrix* RageDisplay::GetTextureTop() const
 	return g_TextureStack.GetTop();
 }
 
+void RageDisplay::GetWorldAndViewProjection( RageMatrix &matWorldOut, RageMatrix &matViewProjOut ) const
+{
+	matWorldOut = *GetWorldTop();
+	RageMatrixMultiply( &matViewProjOut, GetCentering(), GetProjectionTop() );
+	RageMatrixMultiply( &matViewProjOut, &matViewProjOut, GetViewTop() );
+}
+
 void RageDisplay::PushMatrix()
 {
 	g_WorldStack.Push();
@@ -412,6 +412,9 @@ public:
 	void PostMultMatrix( const RageMatrix &f );
 	void PreMultMatrix( const RageMatrix &f );
 	void LoadIdentity();
+	/* The current world matrix, and everything after it: view, projection and
+	 * centering.  Used to test geometry against the screen without drawing it. */
+	void GetWorldAndViewProjection( RageMatrix &matWorldOut, RageMatrix &matViewProjOut ) const;
 
 	// Texture matrix functions
 	void TexturePushMatrix();
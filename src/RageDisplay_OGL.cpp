@@ -410,6 +410,7 @@ static GLhandleARB g_hHardMixShader = 0;
 static GLhandleARB g_hOverlayShader = 0;
 static GLhandleARB g_hScreenShader = 0;
 static GLhandleARB g_hYUYV422Shader = 0;
+static GLhandleARB g_hNV12Shader = 0;
 static GLhandleARB g_gShellShader = 0;
 static GLhandleARB g_gCelShader = 0;
 static GLhandleARB g_gDistanceFieldShader = 0;
@@ -438,6 +439,7 @@ void InitShaders()
 	g_hOverlayShader		= LoadShader( GL_FRAGMENT_SHADER_ARB, "Data/Shaders/GLSL/Overlay.frag", asDefines );
 	g_hScreenShader		= LoadShader( GL_FRAGMENT_SHADER_ARB, "Data/Shaders/GLSL/Screen.frag", asDefines );
 	g_hYUYV422Shader		= LoadShader( GL_FRAGMENT_SHADER_ARB, "Data/Shaders/GLSL/YUYV422.frag", asDefines );
+	g_hNV12Shader		= LoadShader( GL_FRAGMENT_SHADER_ARB, "Data/Shaders/GLSL/NV12.frag", asDefines );
 
 	// Bind attributes.
 	if (g_bTextureMatrixShader)
@@ -1812,6 +1814,9 @@ void RageDisplay_Legacy::SetEffectMode( EffectMode effect )
 		case EffectMode_YUYV422:
 			hShader = g_hYUYV422Shader;
 			break;
+		case EffectMode_NV12:
+			hShader = g_hNV12Shader;
+			break;
 		case EffectMode_DistanceField:
 			hShader = g_gDistanceFieldShader;
 		default:
@@ -1827,7 +1832,7 @@ void RageDisplay_Legacy::SetEffectMode( EffectMode effect )
 	glUniform1iARB( iTexture1, 0 );
 	glUniform1iARB( iTexture2, 1 );
 
-	if (effect == EffectMode_YUYV422)
+	if (effect == EffectMode_YUYV422 || effect == EffectMode_NV12)
 	{
 		GLint iTextureWidthUniform = glGetUniformLocationARB( hShader, "TextureWidth" );
 		GLint iWidth;
@@ -1860,6 +1865,8 @@ bool RageDisplay_Legacy::IsEffectModeSupported( EffectMode effect )
 			return g_hScreenShader != 0;
 		case EffectMode_YUYV422:
 			return g_hYUYV422Shader != 0;
+		case EffectMode_NV12:
+			return g_hNV12Shader != 0;
 		case EffectMode_DistanceField:
 			return g_gDistanceFieldShader != 0;
 		default:
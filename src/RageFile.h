@@ -28,7 +28,11 @@ public:
 
 		/* Flush the file to disk on close.  Combined with not streaming, this results
 		 * in very safe writes, but is slow. */
-		SLOW_FLUSH	= 0x8
+		SLOW_FLUSH	= 0x8,
+
+		/* Write to the end of the existing file, creating it if needed.  Like
+		 * STREAMED, this writes directly to the destination file. */
+		APPEND		= 0x10
 	};
 
 	RageFile();
@@ -70,13 +70,14 @@ static RageFileObjDirect *MakeFileObjDirect( RString sPath, int iMode, int &iErr
 	else
 	{
 		RString sOut;
-		if( iMode & RageFile::STREAMED )
+		if( iMode & (RageFile::STREAMED|RageFile::APPEND) )
 			sOut = sPath;
 		else
 			sOut = MakeTempFilename(sPath);
 
 		/* Open a temporary file for writing. */
-		iFD = DoOpen( sOut, O_BINARY|O_WRONLY|O_CREAT|O_TRUNC, 0666 );
+		const int iFlags = (iMode & RageFile::APPEND)? O_APPEND: O_TRUNC;
+		iFD = DoOpen( sOut, O_BINARY|O_WRONLY|O_CREAT|iFlags, 0666 );
 	}
 
 	if( iFD == -1 )
@@ -331,7 +332,7 @@ RageFileObjDirect::~RageFileObjDirect()
 		}
 	}
 
-	if( !(m_iMode & RageFile::WRITE) || (m_iMode & RageFile::STREAMED) )
+	if( !(m_iMode & RageFile::WRITE) || (m_iMode & (RageFile::STREAMED|RageFile::APPEND)) )
 		return;
 
 	/* We now have path written to MakeTempFilename(m_sPath).
@@ -1,6 +1,7 @@
 #include "global.h"
 #include "ActorUtil.h"
 #include "RageSurface_Load.h"
+#include "RageSurface.h"
 #include "RageSurface_Load_PNG.h"
 #include "RageSurface_Load_JPEG.h"
 #include "RageSurface_Load_GIF.h"
@@ -8,11 +9,15 @@
 #include "RageUtil.h"
 #include "RageFile.h"
 #include "RageLog.h"
+#include "RageThreads.h"
+#include "RageUtil_ThreadPool.h"
 
+#include <deque>
+#include <memory>
 #include <set>
+#include <utility>
 #include <vector>
 
-
 static RageSurface *TryOpenFile( RString sPath, bool bHeaderOnly, RString &error, RString format, bool &bKeepTrying )
 {
 	RageSurface *ret = nullptr;
@@ -122,6 +127,75 @@ RageSurface *RageSurfaceUtils::LoadFile( const RString &sPath, RString &error, b
 	return nullptr;
 }
 
+static RageSurfaceUtils::LoadResult DecodeFile( const RString &sPath, const RageSurfaceUtils::ProcessFunc &Process )
+{
+	RageSurfaceUtils::LoadResult res;
+	res.pSurface = RageSurfaceUtils::LoadFile( sPath, res.sError );
+	if( res.pSurface == nullptr )
+		return res;
+
+	res.iSourceWidth = res.pSurface->w;
+	res.iSourceHeight = res.pSurface->h;
+	if( Process )
+		Process( res.pSurface );
+	return res;
+}
+
+std::vector<std::future<RageSurfaceUtils::LoadResult>> RageSurfaceUtils::LoadFiles( RageThreadPool &pool,
+	const std::vector<RString> &asPaths, ProcessFunc Process )
+{
+	std::vector<std::future<LoadResult>> ret;
+	ret.reserve( asPaths.size() );
+	for( const RString &sPath : asPaths )
+		ret.push_back( pool.Submit( [sPath, Process]() { return DecodeFile( sPath, Process ); } ) );
+	return ret;
+}
+
+/* Decodes that have finished and are waiting to be consumed.  Shared with the
+ * jobs, so none of them touch anything on the caller's stack. */
+struct FinishedDecodes
+{
+	FinishedDecodes(): Event( "LoadFilesWindowed" ) { }
+	RageEvent Event;
+	std::deque<std::pair<int, RageSurfaceUtils::LoadResult>> Results;
+};
+
+void RageSurfaceUtils::LoadFilesWindowed( RageThreadPool &pool, const std::vector<RString> &asPaths,
+	int iMaxInFlight, const ConsumeFunc &Consume, ProcessFunc Process )
+{
+	ASSERT( iMaxInFlight > 0 );
+	std::shared_ptr<FinishedDecodes> pFinished = std::make_shared<FinishedDecodes>();
+
+	const int iNumPaths = asPaths.size();
+	int iSubmitted = 0, iConsumed = 0;
+	while( iConsumed < iNumPaths )
+	{
+		for( ; iSubmitted < iNumPaths && iSubmitted - iConsumed < iMaxInFlight; ++iSubmitted )
+		{
+			const int iIndex = iSubmitted;
+			const RString sPath = asPaths[iIndex];
+			pool.Submit( [pFinished, iIndex, sPath, Process]()
+			{
+				LoadResult res = DecodeFile( sPath, Process );
+				pFinished->Event.Lock();
+				pFinished->Results.push_back( std::make_pair(iIndex, res) );
+				pFinished->Event.Signal();
+				pFinished->Event.Unlock();
+			} );
+		}
+
+		pFinished->Event.Lock();
+		while( pFinished->Results.empty() )
+			pFinished->Event.Wait();
+		std::pair<int, LoadResult> result = pFinished->Results.front();
+		pFinished->Results.pop_front();
+		pFinished->Event.Unlock();
+
+		Consume( result.first, result.second );
+		++iConsumed;
+	}
+}
+
 /*
  * (c) 2004 Glenn Maynard
  * All rights reserved.
@@ -1,7 +1,12 @@
 #ifndef RAGE_SURFACE_LOAD_H
 #define RAGE_SURFACE_LOAD_H
 
+#include <functional>
+#include <future>
+#include <vector>
+
 struct RageSurface;
+class RageThreadPool;
 /** @brief Utility functions for the RageSurfaces. */
 namespace RageSurfaceUtils
 {
@@ -15,6 +20,31 @@ namespace RageSurfaceUtils
 	/* If bHeaderOnly is true, the loader is only required to return a surface
 	 * with the width and height set (but may return a complete surface). */
 	RageSurface *LoadFile( const RString &sPath, RString &error, bool bHeaderOnly=false );
+
+	struct LoadResult
+	{
+		LoadResult(): pSurface(nullptr), iSourceWidth(0), iSourceHeight(0) { }
+		RageSurface *pSurface;
+		/* The size of the decoded file, before Process was applied. */
+		int iSourceWidth, iSourceHeight;
+		RString sError;
+	};
+
+	/* Decode a batch of files concurrently on pool.  Futures are returned in
+	 * the same order as asPaths; the caller owns the surfaces.  If Process is
+	 * set, it's called on the worker thread with each successfully loaded
+	 * surface, and may replace it. */
+	typedef std::function<void(RageSurface *&pSurface)> ProcessFunc;
+	std::vector<std::future<LoadResult>> LoadFiles( RageThreadPool &pool,
+		const std::vector<RString> &asPaths, ProcessFunc Process = ProcessFunc() );
+
+	/* Decode asPaths on pool, keeping at most iMaxInFlight files decoding or
+	 * decoded and not yet consumed, so memory doesn't grow with the number of
+	 * files.  Consume is called on this thread with each file's index in
+	 * asPaths and its result, in the order they finish; it owns the surface. */
+	typedef std::function<void(int iIndex, LoadResult &res)> ConsumeFunc;
+	void LoadFilesWindowed( RageThreadPool &pool, const std::vector<RString> &asPaths,
+		int iMaxInFlight, const ConsumeFunc &Consume, ProcessFunc Process = ProcessFunc() );
 }
 
 #endif
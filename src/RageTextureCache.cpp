@@ -0,0 +1,199 @@
+#include "global.h"
+#include "RageTextureCache.h"
+#include "RageTextureID.h"
+#include "RageSurface.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageLog.h"
+#include "RageUtil.h"
+#include "Preference.h"
+#include "SpecialFiles.h"
+#include "StepMania.h"
+
+#include <cstdint>
+#include <cstring>
+
+static Preference<bool> g_bTextureCache( "TextureCache", true );
+
+/* Bump this whenever the conversion in RageBitmapTexture::Create changes. */
+static const std::uint32_t TEXTURE_CACHE_VERSION = 1;
+static const std::uint32_t TEXTURE_CACHE_MAGIC = 0x31435452; // "RTC1"
+
+#define TEXTURE_CACHE_DIR (SpecialFiles::CACHE_DIR + "Textures/")
+
+struct CacheHeader
+{
+	std::uint32_t magic, version;
+	std::uint32_t iFileHash;
+	std::uint32_t iKeyLength;
+	std::int32_t pixfmt, bMipMaps;
+	std::int32_t iSourceWidth, iSourceHeight;
+	std::int32_t iImageWidth, iImageHeight;
+	std::int32_t width, height, pitch, bpp;
+	std::uint32_t Rmask, Gmask, Bmask, Amask;
+	std::int32_t ncolors;
+};
+
+/* Everything other than the file contents that affects the converted result. */
+static RString GetCacheKey( const RageTextureID &ID )
+{
+	return ssprintf( "%s|%i|%i|%i|%i|%i|%i|%i|%i|%s|%i|%i|%i",
+		ID.filename.c_str(), ID.iMaxSize, ID.bMipMaps, ID.iAlphaBits,
+		ID.iGrayscaleBits, ID.iColorDepth, ID.bDither, ID.bStretch,
+		ID.bHotPinkColorKey, ID.AdditionalTextureHints.c_str(),
+		DISPLAY->GetMaxTextureSize(), DISPLAY->SupportsTextureFormat(RagePixelFormat_PAL),
+		StepMania::GetHighResolutionTextures() );
+}
+
+/* Texture paths may or may not have a leading slash. */
+static RString GetRelativePath( const RString &sPath )
+{
+	if( BeginsWith(sPath, "/") )
+		return sPath.substr( 1 );
+	return sPath;
+}
+
+static RString GetCachePath( const RageTextureID &ID, const RString &sKey )
+{
+	/* Mirror the source directory, so FlushDirectory can remove a whole theme. */
+	return ssprintf( "%s%s-%08x.tex", TEXTURE_CACHE_DIR.c_str(),
+		GetRelativePath(ID.filename).c_str(), GetHashForString(sKey) );
+}
+
+bool RageTextureCache::IsCacheable( const RageTextureID &ID )
+{
+	if( !g_bTextureCache )
+		return false;
+
+	const RString sPath = GetRelativePath( ID.filename );
+	return BeginsWith( sPath, SpecialFiles::THEMES_DIR ) || BeginsWith( sPath, SpecialFiles::NOTESKINS_DIR );
+}
+
+bool RageTextureCache::Load( const RageTextureID &ID, CachedTexture &out )
+{
+	const RString sKey = GetCacheKey( ID );
+	const RString sCachePath = GetCachePath( ID, sKey );
+
+	RageFile f;
+	if( !f.Open(sCachePath) )
+		return false;
+
+	CacheHeader h;
+	if( f.Read(&h, sizeof(h)) != sizeof(h) )
+		return false;
+	if( h.magic != TEXTURE_CACHE_MAGIC || h.version != TEXTURE_CACHE_VERSION )
+		return false;
+
+	/* The source file changed since it was cached. */
+	if( h.iFileHash != GetHashForFile(ID.filename) )
+		return false;
+
+	RString sStoredKey;
+	if( h.iKeyLength != sKey.size() || f.Read(sStoredKey, h.iKeyLength) != (int) h.iKeyLength || sStoredKey != sKey )
+		return false;
+
+	const RagePixelFormat pixfmt = (RagePixelFormat) h.pixfmt;
+	if( pixfmt < 0 || pixfmt >= NUM_RagePixelFormat || !DISPLAY->SupportsTextureFormat(pixfmt) )
+		return false;
+
+	RageSurfacePalette palette;
+	if( h.bpp == 8 )
+	{
+		if( h.ncolors < 0 || h.ncolors > 256 )
+			return false;
+		palette.ncolors = h.ncolors;
+		const int iSize = h.ncolors * sizeof(RageSurfaceColor);
+		if( f.Read(palette.colors, iSize) != iSize )
+			return false;
+	}
+
+	RageSurface *pImage = CreateSurface( h.width, h.height, h.bpp, h.Rmask, h.Gmask, h.Bmask, h.Amask );
+	if( pImage->pitch != h.pitch )
+	{
+		delete pImage;
+		return false;
+	}
+
+	/* The pixel data is the bulk of the file; read it straight into place. */
+	const int iPixelBytes = h.height * h.pitch;
+	if( f.Read(pImage->pixels, iPixelBytes) != iPixelBytes )
+	{
+		LOG->Trace( "Texture cache file \"%s\" is truncated", sCachePath.c_str() );
+		delete pImage;
+		return false;
+	}
+
+	if( h.bpp == 8 )
+		*pImage->fmt.palette = palette;
+
+	out.pImage = pImage;
+	out.pixfmt = pixfmt;
+	out.bMipMaps = h.bMipMaps != 0;
+	out.iSourceWidth = h.iSourceWidth;
+	out.iSourceHeight = h.iSourceHeight;
+	out.iImageWidth = h.iImageWidth;
+	out.iImageHeight = h.iImageHeight;
+	return true;
+}
+
+void RageTextureCache::Save( const RageTextureID &ID, const CachedTexture &tex )
+{
+	const RString sKey = GetCacheKey( ID );
+	const RString sCachePath = GetCachePath( ID, sKey );
+	const RageSurface *pImage = tex.pImage;
+
+	CacheHeader h;
+	memset( &h, 0, sizeof(h) );
+	h.magic = TEXTURE_CACHE_MAGIC;
+	h.version = TEXTURE_CACHE_VERSION;
+	h.iFileHash = GetHashForFile( ID.filename );
+	h.iKeyLength = sKey.size();
+	h.pixfmt = tex.pixfmt;
+	h.bMipMaps = tex.bMipMaps;
+	h.iSourceWidth = tex.iSourceWidth;
+	h.iSourceHeight = tex.iSourceHeight;
+	h.iImageWidth = tex.iImageWidth;
+	h.iImageHeight = tex.iImageHeight;
+	h.width = pImage->w;
+	h.height = pImage->h;
+	h.pitch = pImage->pitch;
+	h.bpp = pImage->fmt.BitsPerPixel;
+	h.Rmask = pImage->fmt.Mask[0];
+	h.Gmask = pImage->fmt.Mask[1];
+	h.Bmask = pImage->fmt.Mask[2];
+	h.Amask = pImage->fmt.Mask[3];
+	if( h.bpp == 8 )
+		h.ncolors = pImage->fmt.palette->ncolors;
+
+	RageFile f;
+	if( !f.Open(sCachePath, RageFile::WRITE) )
+	{
+		LOG->Trace( "Couldn't write texture cache file \"%s\": %s", sCachePath.c_str(), f.GetError().c_str() );
+		return;
+	}
+
+	f.Write( &h, sizeof(h) );
+	f.Write( sKey );
+	if( h.bpp == 8 )
+		f.Write( pImage->fmt.palette->colors, h.ncolors * sizeof(RageSurfaceColor) );
+	f.Write( pImage->pixels, pImage->h * pImage->pitch );
+
+	if( f.Flush() == -1 )
+	{
+		f.Close();
+		FILEMAN->Remove( sCachePath );
+	}
+}
+
+void RageTextureCache::FlushDirectory( const RString &sDir )
+{
+	RString sCacheDir = TEXTURE_CACHE_DIR + GetRelativePath( sDir );
+	if( sCacheDir.Right(1) != "/" )
+		sCacheDir += "/";
+	if( !DoesFileExist(sCacheDir) )
+		return;
+
+	LOG->Trace( "Flushing texture cache for \"%s\"", sDir.c_str() );
+	DeleteRecursive( sCacheDir );
+	FILEMAN->FlushDirCache( TEXTURE_CACHE_DIR );
+}
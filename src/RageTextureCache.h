@@ -0,0 +1,41 @@
+/* RageTextureCache - a disk cache of bitmap textures that are already converted to their display format. */
+
+#ifndef RAGE_TEXTURE_CACHE_H
+#define RAGE_TEXTURE_CACHE_H
+
+#include "RageDisplay.h"
+
+struct RageSurface;
+struct RageTextureID;
+
+/* Decoding, resizing and dithering theme graphics is most of the cost of
+ * loading them.  RageBitmapTexture stores the final, texture-sized surface
+ * here, keyed by the source file's path, size and modification time, the
+ * RageTextureID loading parameters and the display capabilities that
+ * influenced the conversion.  A hit is a raw read straight into a surface. */
+namespace RageTextureCache
+{
+	struct CachedTexture
+	{
+		CachedTexture(): pImage(nullptr), pixfmt(RagePixelFormat_Invalid), bMipMaps(false),
+			iSourceWidth(0), iSourceHeight(0), iImageWidth(0), iImageHeight(0) { }
+
+		/* The converted surface, at texture size.  Owned by the caller after Load. */
+		RageSurface *pImage;
+		RagePixelFormat pixfmt;
+		bool bMipMaps;
+		int iSourceWidth, iSourceHeight;
+		int iImageWidth, iImageHeight;
+	};
+
+	/* Only graphics that rarely change (themes and noteskins) are cached. */
+	bool IsCacheable( const RageTextureID &ID );
+
+	bool Load( const RageTextureID &ID, CachedTexture &out );
+	void Save( const RageTextureID &ID, const CachedTexture &tex );
+
+	/* Delete every cache entry for textures loaded from under sDir. */
+	void FlushDirectory( const RString &sDir );
+}
+
+#endif
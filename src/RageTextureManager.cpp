@@ -140,7 +140,7 @@ private:
 };
 
 // Load and unload textures from disk.
-RageTexture* RageTextureManager::LoadTextureInternal( RageTextureID ID )
+RageTexture* RageTextureManager::LoadTextureInternal( RageTextureID ID, RageSurface *pDecoded )
 {
 	CHECKPOINT_M( ssprintf( "RageTextureManager::LoadTexture(%s).", ID.filename.c_str() ) );
 
@@ -152,6 +152,7 @@ RageTexture* RageTextureManager::LoadTextureInternal( RageTextureID ID )
 	if( p != m_mapPathToTexture.end() )
 	{
 		/* Found the texture.  Just increase the refcount and return it. */
+		delete pDecoded;
 		RageTexture* pTexture = p->second;
 		pTexture->m_iRefCount++;
 		return pTexture;
@@ -160,7 +161,11 @@ RageTexture* RageTextureManager::LoadTextureInternal( RageTextureID ID )
 	// The texture is not already loaded.  Load it.
 
 	RageTexture* pTexture;
-	if( ID.filename == g_sDefaultTextureName )
+	if( pDecoded != nullptr )
+	{
+		pTexture = new RageBitmapTexture( ID, pDecoded );
+	}
+	else if( ID.filename == g_sDefaultTextureName )
 	{
 		pTexture = new RageTexture_Default;
 	}
@@ -188,6 +193,14 @@ RageTexture* RageTextureManager::LoadTexture( RageTextureID ID )
 	return pTexture;
 }
 
+RageTexture* RageTextureManager::LoadTexture( RageTextureID ID, RageSurface *pDecoded )
+{
+	RageTexture* pTexture = LoadTextureInternal( ID, pDecoded );
+	if( pTexture )
+		pTexture->m_bWasUsed = true;
+	return pTexture;
+}
+
 RageTexture* RageTextureManager::CopyTexture( RageTexture *pCopy )
 {
 	++pCopy->m_iRefCount;
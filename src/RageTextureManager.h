@@ -53,6 +53,9 @@ public:
 	void Update( float fDeltaTime );
 
 	RageTexture* LoadTexture( RageTextureID ID );
+	/* Load a bitmap texture from pDecoded, already decoded from ID's file,
+	 * if it isn't loaded yet.  Takes ownership of pDecoded either way. */
+	RageTexture* LoadTexture( RageTextureID ID, RageSurface *pDecoded );
 	RageTexture* CopyTexture( RageTexture *pCopy ); // returns a ref to the same texture, not a deep copy
 	bool IsTextureRegistered( RageTextureID ID ) const;
 	void RegisterTexture( RageTextureID ID, RageTexture *p );
@@ -91,7 +94,7 @@ private:
 	void DeleteTexture( RageTexture *t );
 	enum GCType { screen_changed, delayed_delete };
 	void GarbageCollect( GCType type );
-	RageTexture* LoadTextureInternal( RageTextureID ID );
+	RageTexture* LoadTextureInternal( RageTextureID ID, RageSurface *pDecoded = nullptr );
 
 	RageTextureManagerPrefs m_Prefs;
 	int m_iNoWarnAboutOddDimensions;
@@ -33,6 +33,14 @@ void RageTexturePreloader::Load( const RageTextureID &ID )
 	m_apTextures.push_back( pTexture );
 }
 
+void RageTexturePreloader::Load( const RageTextureID &ID, RageSurface *pDecoded )
+{
+	ASSERT( TEXTUREMAN != nullptr );
+
+	RageTexture *pTexture = TEXTUREMAN->LoadTexture( ID, pDecoded );
+	m_apTextures.push_back( pTexture );
+}
+
 void RageTexturePreloader::UnloadAll()
 {
 	if( TEXTUREMAN == nullptr )
@@ -6,6 +6,7 @@
 
 class RageTexture;
 struct RageTextureID;
+struct RageSurface;
 /** @brief Load the textures in advance for using them later. */
 class RageTexturePreloader
 {
@@ -16,6 +17,8 @@ public:
 	RageTexturePreloader &operator=( const RageTexturePreloader &rhs );
 	~RageTexturePreloader();
 	void Load( const RageTextureID &ID );
+	/* Load from a surface already decoded from ID's file; takes ownership of it. */
+	void Load( const RageTextureID &ID, RageSurface *pDecoded );
 	void UnloadAll();
 	void Swap( RageTexturePreloader &rhs ) { swap( m_apTextures, rhs.m_apTextures ); }
 
@@ -187,7 +187,9 @@ static const char *EffectModeNames[] =
 
 	"YUYV422",
 	/* Draws a graphic from a signed distance field. */
-	"DistanceField"
+	"DistanceField",
+	/* Movie frames with a luma texture and an interleaved chroma texture. */
+	"NV12"
 };
 XToString( EffectMode );
 LuaXType( EffectMode );
@@ -55,6 +55,7 @@ enum EffectMode
 	EffectMode_Screen,
 	EffectMode_YUYV422,
 	EffectMode_DistanceField,
+	EffectMode_NV12,
 	NUM_EffectMode,
 	EffectMode_Invalid
 };
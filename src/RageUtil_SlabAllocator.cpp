@@ -0,0 +1,132 @@
+#include "global.h"
+#include "RageUtil_SlabAllocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+static std::atomic<std::uint64_t> g_iTotalAllocations( 0 );
+static std::atomic<std::uint64_t> g_iTotalHeapAllocations( 0 );
+
+/* Every allocator ever created.  Like the allocators, this is never
+ * destroyed. */
+struct AllocatorList
+{
+	AllocatorList(): lock( "RageSlabAllocator list" ) { }
+	RageMutex lock;
+	std::vector<RageSlabAllocator *> vpAllocators;
+};
+
+static AllocatorList &GetAllocatorList()
+{
+	static AllocatorList *pList = new AllocatorList;
+	return *pList;
+}
+
+RageSlabAllocator::RageSlabAllocator( const char *szName, std::size_t iBlockSize, std::size_t iBlocksPerSlab ):
+	m_Lock( RString("RageSlabAllocator ") + szName )
+{
+	/* Every block must be able to hold a free list link, and be aligned like
+	 * anything that ::operator new returns. */
+	const std::size_t iAlign = alignof(std::max_align_t);
+	iBlockSize = std::max( iBlockSize, sizeof(FreeBlock) );
+	iBlockSize = (iBlockSize + iAlign - 1) / iAlign * iAlign;
+
+	m_szName = szName;
+	m_iBlockSize = iBlockSize;
+	m_iBlocksPerSlab = std::max( iBlocksPerSlab, (std::size_t) 1 );
+	m_pFree = nullptr;
+	m_iLive = m_iPeak = m_iSlabs = 0;
+	m_iAllocations = m_iHeapAllocations = 0;
+
+	AllocatorList &list = GetAllocatorList();
+	LockMut( list.lock );
+	list.vpAllocators.push_back( this );
+}
+
+void RageSlabAllocator::AddSlab()
+{
+	char *pSlab = static_cast<char *>( ::operator new(m_iBlockSize * m_iBlocksPerSlab) );
+	for( std::size_t i = m_iBlocksPerSlab; i-- > 0; )
+	{
+		FreeBlock *pBlock = reinterpret_cast<FreeBlock *>( pSlab + i*m_iBlockSize );
+		pBlock->pNext = m_pFree;
+		m_pFree = pBlock;
+	}
+	++m_iSlabs;
+	++m_iHeapAllocations;
+	++g_iTotalHeapAllocations;
+}
+
+void *RageSlabAllocator::Allocate( std::size_t iSize )
+{
+	++g_iTotalAllocations;
+	if( iSize > m_iBlockSize )
+	{
+		++g_iTotalHeapAllocations;
+		LockMut( m_Lock );
+		++m_iAllocations;
+		++m_iHeapAllocations;
+		return ::operator new( iSize );
+	}
+
+	LockMut( m_Lock );
+	if( m_pFree == nullptr )
+		AddSlab();
+	FreeBlock *pBlock = m_pFree;
+	m_pFree = pBlock->pNext;
+
+	++m_iAllocations;
+	++m_iLive;
+	m_iPeak = std::max( m_iPeak, m_iLive );
+	return pBlock;
+}
+
+void RageSlabAllocator::Free( void *p, std::size_t iSize )
+{
+	if( p == nullptr )
+		return;
+	if( iSize > m_iBlockSize )
+	{
+		::operator delete( p );
+		return;
+	}
+
+	LockMut( m_Lock );
+	FreeBlock *pBlock = static_cast<FreeBlock *>( p );
+	pBlock->pNext = m_pFree;
+	m_pFree = pBlock;
+	--m_iLive;
+}
+
+RageSlabAllocator::Stats RageSlabAllocator::GetStats() const
+{
+	LockMut( m_Lock );
+	Stats ret;
+	ret.szName = m_szName;
+	ret.iBlockSize = m_iBlockSize;
+	ret.iLive = m_iLive;
+	ret.iPeak = m_iPeak;
+	ret.iSlabs = m_iSlabs;
+	ret.iAllocations = m_iAllocations;
+	ret.iHeapAllocations = m_iHeapAllocations;
+	return ret;
+}
+
+void RageSlabAllocator::GetAllStats( std::vector<Stats> &vOut )
+{
+	AllocatorList &list = GetAllocatorList();
+	LockMut( list.lock );
+	for( const RageSlabAllocator *pAllocator : list.vpAllocators )
+		vOut.push_back( pAllocator->GetStats() );
+}
+
+std::uint64_t RageSlabAllocator::GetTotalAllocations()
+{
+	return g_iTotalAllocations.load( std::memory_order_relaxed );
+}
+
+std::uint64_t RageSlabAllocator::GetTotalHeapAllocations()
+{
+	return g_iTotalHeapAllocations.load( std::memory_order_relaxed );
+}
@@ -0,0 +1,63 @@
+/* RageSlabAllocator - fixed-size blocks for small objects that come and go often. */
+
+#ifndef RAGE_UTIL_SLAB_ALLOCATOR_H
+#define RAGE_UTIL_SLAB_ALLOCATOR_H
+
+#include "RageThreads.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Blocks are carved out of slabs of iBlocksPerSlab, and freed blocks go on a
+ * free list for reuse, so once the free list is warm, allocating is a pop and
+ * freeing is a push.  Slabs are never given back.  Requests larger than the
+ * block size go to the heap.
+ *
+ * Allocators are never destroyed, since objects may be freed during static
+ * destruction; create them with new, once. */
+class RageSlabAllocator
+{
+public:
+	RageSlabAllocator( const char *szName, std::size_t iBlockSize, std::size_t iBlocksPerSlab = 256 );
+
+	void *Allocate( std::size_t iSize );
+	void Free( void *p, std::size_t iSize );
+
+	struct Stats
+	{
+		const char *szName;
+		std::size_t iBlockSize;
+		int iLive, iPeak, iSlabs;
+		std::uint64_t iAllocations;
+		/* Allocations that had to go to the heap: new slabs, and blocks too
+		 * large for this allocator. */
+		std::uint64_t iHeapAllocations;
+	};
+	Stats GetStats() const;
+
+	/* Stats for every allocator, and totals across all of them.  The totals
+	 * don't lock anything, so they're cheap enough to poll every frame. */
+	static void GetAllStats( std::vector<Stats> &vOut );
+	static std::uint64_t GetTotalAllocations();
+	static std::uint64_t GetTotalHeapAllocations();
+
+private:
+	RageSlabAllocator( const RageSlabAllocator & ) = delete;
+	RageSlabAllocator &operator=( const RageSlabAllocator & ) = delete;
+
+	void AddSlab();
+
+	struct FreeBlock { FreeBlock *pNext; };
+
+	const char *m_szName;
+	std::size_t m_iBlockSize;
+	std::size_t m_iBlocksPerSlab;
+
+	mutable RageMutex m_Lock;
+	FreeBlock *m_pFree;
+	int m_iLive, m_iPeak, m_iSlabs;
+	std::uint64_t m_iAllocations, m_iHeapAllocations;
+};
+
+#endif
@@ -0,0 +1,76 @@
+#include "global.h"
+#include "RageUtil_ThreadPool.h"
+#include "RageUtil.h"
+
+#include <thread>
+
+RageThreadPool::RageThreadPool( const RString &sName, int iNumThreads ):
+	m_JobsEvent( "\"" + sName + "\" thread pool event" )
+{
+	m_bShutdown = false;
+
+	if( iNumThreads <= 0 )
+		iNumThreads = GetDefaultThreadCount();
+
+	for( int i = 0; i < iNumThreads; ++i )
+	{
+		RageThread *pThread = new RageThread;
+		pThread->SetName( ssprintf("Thread pool (%s) #%i", sName.c_str(), i) );
+		pThread->Create( StartWorkerMain, this );
+		m_vpThreads.push_back( pThread );
+	}
+}
+
+RageThreadPool::~RageThreadPool()
+{
+	m_JobsEvent.Lock();
+	m_bShutdown = true;
+	m_JobsEvent.Broadcast();
+	m_JobsEvent.Unlock();
+
+	for( RageThread *pThread : m_vpThreads )
+	{
+		pThread->Wait();
+		delete pThread;
+	}
+	m_vpThreads.clear();
+}
+
+int RageThreadPool::GetDefaultThreadCount()
+{
+	/* hardware_concurrency may return 0 if it can't tell. */
+	int iCores = (int) std::thread::hardware_concurrency();
+	return std::max( iCores, 1 );
+}
+
+void RageThreadPool::Enqueue( std::function<void()> job )
+{
+	m_JobsEvent.Lock();
+	ASSERT( !m_bShutdown );
+	m_Jobs.push_back( std::move(job) );
+	m_JobsEvent.Signal();
+	m_JobsEvent.Unlock();
+}
+
+void RageThreadPool::WorkerMain()
+{
+	for(;;)
+	{
+		m_JobsEvent.Lock();
+		while( m_Jobs.empty() && !m_bShutdown )
+			m_JobsEvent.Wait();
+
+		/* Drain the queue before honoring a shutdown. */
+		if( m_Jobs.empty() )
+		{
+			m_JobsEvent.Unlock();
+			break;
+		}
+
+		std::function<void()> job = std::move( m_Jobs.front() );
+		m_Jobs.pop_front();
+		m_JobsEvent.Unlock();
+
+		job();
+	}
+}
@@ -0,0 +1,57 @@
+/* RageThreadPool - a fixed set of worker threads that run queued jobs. */
+
+#ifndef RAGE_UTIL_THREAD_POOL_H
+#define RAGE_UTIL_THREAD_POOL_H
+
+#include "RageThreads.h"
+
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <utility>
+#include <vector>
+
+class RageThreadPool
+{
+public:
+	/* If iNumThreads is 0, one thread is started per hardware thread. */
+	RageThreadPool( const RString &sName, int iNumThreads = 0 );
+
+	/* Jobs that are still queued are run to completion before the threads
+	 * are stopped, so outstanding futures are always satisfied. */
+	~RageThreadPool();
+
+	/* Queue a job.  The returned future becomes ready when the job has run on
+	 * one of the pool's threads; exceptions thrown by the job are rethrown by
+	 * future::get(). */
+	template<typename F>
+	auto Submit( F &&job ) -> std::future<decltype(job())>
+	{
+		typedef decltype(job()) Result;
+		auto pTask = std::make_shared<std::packaged_task<Result()>>( std::forward<F>(job) );
+		std::future<Result> ret = pTask->get_future();
+		Enqueue( [pTask]() { (*pTask)(); } );
+		return ret;
+	}
+
+	int GetNumThreads() const { return (int) m_vpThreads.size(); }
+
+	static int GetDefaultThreadCount();
+
+private:
+	static int StartWorkerMain( void *pThis ) { ((RageThreadPool *) (pThis))->WorkerMain(); return 0; }
+	void WorkerMain();
+	void Enqueue( std::function<void()> job );
+
+	std::vector<RageThread *> m_vpThreads;
+	std::deque<std::function<void()>> m_Jobs;
+	RageEvent m_JobsEvent;
+	bool m_bShutdown;
+
+	// Swallow up warnings. If they must be used, define them.
+	RageThreadPool& operator=(const RageThreadPool& rhs);
+	RageThreadPool(const RageThreadPool& rhs);
+};
+
+#endif
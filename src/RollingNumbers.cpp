@@ -61,7 +61,7 @@ void RollingNumbers::DrawPrimitives()
 	float original_crop_left= m_pTempState->crop.left;
 	float original_crop_right= m_pTempState->crop.right;
 
-	RString s = this->GetText();
+	const RString &s = this->GetText();
 	int i;
 	// find the first non-zero non-comma character, or the last character
 	for( i=0; i<(int)(s.length()-1); i++ )
@@ -580,6 +580,7 @@ static LocalizedString TOGGLE_ERRORS( "ScreenDebugOverlay", "Toggle Errors" );
 static LocalizedString SHOW_RECENT_ERRORS("ScreenDebugOverlay", "Show Recent Errors");
 static LocalizedString CLEAR_ERRORS( "ScreenDebugOverlay", "Clear Errors" );
 static LocalizedString CONVERT_XML( "ScreenDebugOverlay", "Convert XML" );
+static LocalizedString LUA_PROFILER( "ScreenDebugOverlay", "Lua Profiler" );
 static LocalizedString RELOAD_PREFS( "ScreenDebugOverlay", "Reload Prefs" );
 static LocalizedString RELOAD_THEME_AND_TEXTURES( "ScreenDebugOverlay", "Reload Theme and Textures" );
 static LocalizedString WRITE_PROFILES	( "ScreenDebugOverlay", "Write Profiles" );
@@ -1156,6 +1157,24 @@ class DebugLineConvertXML : public IDebugLine
 	}
 };
 
+class DebugLineLuaProfiler : public IDebugLine
+{
+	virtual RString GetDisplayTitle() { return LUA_PROFILER.GetValue(); }
+	virtual bool IsEnabled() { return LUA->IsProfiling(); }
+	virtual RString GetPageName() const { return "Theme"; }
+	virtual void DoAndLog( RString &sMessageOut )
+	{
+		RString sReport;
+		if( LUA->IsProfiling() )
+			sReport = LUA->StopProfiling();
+		else
+			LUA->StartProfiling();
+		IDebugLine::DoAndLog( sMessageOut );
+		if( !sReport.empty() )
+			sMessageOut += " (" + sReport + ")";
+	}
+};
+
 class DebugLineWriteProfiles : public IDebugLine
 {
 	virtual RString GetDisplayTitle() { return WRITE_PROFILES.GetValue(); }
@@ -1356,6 +1375,7 @@ DECLARE_ONE( DebugLineToggleErrors );
 DECLARE_ONE( DebugLineShowRecentErrors );
 DECLARE_ONE( DebugLineClearErrors );
 DECLARE_ONE( DebugLineConvertXML );
+DECLARE_ONE( DebugLineLuaProfiler );
 DECLARE_ONE( DebugLineWriteProfiles );
 DECLARE_ONE( DebugLineWritePreferences );
 DECLARE_ONE(DebugLineReloadPreferences);
@@ -71,6 +71,7 @@
 #include "Screen.h"
 #include "ScreenDimensions.h"
 #include "ActorUtil.h"
+#include "ActorPrefetcher.h"
 #include "InputEventPlus.h"
 
 #include <vector>
@@ -80,6 +81,7 @@ ScreenManager*	SCREENMAN = nullptr;	// global and accessible from anywhere in ou
 
 static Preference<bool> g_bDelayedScreenLoad( "DelayedScreenLoad", false );
 //static Preference<bool> g_bPruneFonts( "PruneFonts", true );
+static Preference<bool> g_bLogFontMemory( "LogFontMemory", false );
 
 // Screen registration
 static std::map<RString,CreateScreenFn>	*g_pmapRegistrees = nullptr;
@@ -257,6 +259,7 @@ ScreenManager::~ScreenManager()
 	LOG->Trace( "ScreenManager::~ScreenManager()" );
 	LOG->UnmapLog( "ScreenManager::TopScreen" );
 
+	ActorPrefetcher::Shutdown();
 	SAFE_DELETE( g_pSharedBGA );
 	for( unsigned i=0; i<g_ScreenStack.size(); i++ )
 	{
@@ -479,6 +482,13 @@ void ScreenManager::Update( float fDeltaTime )
 	if( bFirstUpdate )
 		SOUND->Flush();
 
+	if( !m_sDelayedConcurrentPrepare.empty() )
+	{
+		RString sScreenName = m_sDelayedConcurrentPrepare;
+		m_sDelayedConcurrentPrepare = "";
+		PrefetchScreenScripts( sScreenName );
+	}
+
 	/* If we're currently inside a background screen load, and m_sDelayedScreen
 	 * is set, then the screen called SetNewScreen before we finished preparing.
 	 * Postpone it until we're finished loading. */
@@ -639,6 +649,33 @@ void ScreenManager::PrepareScreen( const RString &sScreenName )
 	*/
 
 	//TEXTUREMAN->DiagnosticOutput();
+	if( g_bLogFontMemory )
+		FONT->DiagnosticOutput();
+}
+
+void ScreenManager::PrefetchScreen( const RString &sScreenName )
+{
+	ASSERT( sScreenName != "" );
+	m_sDelayedConcurrentPrepare = sScreenName;
+}
+
+/* Resolve the paths of everything ScreenWithMenuElements and the shared
+ * background load, and hand them to ActorPrefetcher.  Finding the paths needs
+ * THEME, so it's done here; the workers only read and compile. */
+void ScreenManager::PrefetchScreenScripts( const RString &sScreenName )
+{
+	if( !IsScreenNameValid(sScreenName) || ScreenIsPrepped(sScreenName) )
+		return;
+
+	static const char *szElements[] = { "background", "underlay", "overlay", "decorations", "in", "out", "cancel" };
+	std::vector<RString> vsPaths;
+	for( const char *szElement : szElements )
+	{
+		RString sPath = THEME->GetPathB( sScreenName, szElement, true );
+		if( !sPath.empty() )
+			vsPaths.push_back( sPath );
+	}
+	ActorPrefetcher::Prefetch( vsPaths );
 }
 
 void ScreenManager::GroupScreen( const RString &sScreenName )
@@ -730,6 +767,10 @@ void ScreenManager::LoadDelayedScreen()
 		return;
 	}
 
+	/* If the screen wasn't prefetched while the last one tweened out, start
+	 * now; the workers can get ahead while the old screens are cleaned up. */
+	PrefetchScreenScripts( sScreenName );
+
 	// Pop the top screen, if any.
 	ScreenMessage SM = PopTopScreenInternal();
 
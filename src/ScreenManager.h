@@ -35,6 +35,8 @@ public:
 	 * will be very quick.
 	 * @param sScreenName the Screen to prepare. */
 	void PrepareScreen( const RString &sScreenName );
+	// Start compiling a screen's scripts in the background, ahead of loading it.
+	void PrefetchScreen( const RString &sScreenName );
 	void GroupScreen( const RString &sScreenName );
 	void PersistantScreen( const RString &sScreenName );
 	void PopTopScreen( ScreenMessage SM );
@@ -102,6 +104,7 @@ private:
 
 	Screen *MakeNewScreen( const RString &sName );
 	void LoadDelayedScreen();
+	void PrefetchScreenScripts( const RString &sScreenName );
 	bool ActivatePreparedScreenAndBackground( const RString &sScreenName );
 	ScreenMessage PopTopScreenInternal( bool bSendLoseFocus = true );
 
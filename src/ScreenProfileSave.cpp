@@ -1,6 +1,7 @@
 #include "global.h"
 #include "ScreenProfileSave.h"
 #include "GameState.h"
+#include "ProfileWriter.h"
 #include "ScreenManager.h"
 
 REGISTER_SCREEN_CLASS( ScreenProfileSave );
@@ -20,9 +21,15 @@ void ScreenProfileSave::Continue()
 	GAMESTATE->SavePlayerProfiles();
 	SCREENMAN->ZeroNextUpdate();
 
+	/* The profiles are written in the background; don't wait for them. */
 	StartTransitioningScreen( SM_GoToNextScreen );
 }
 
+bool ScreenProfileSave::IsSaving() const
+{
+	return ProfileWriter::IsBusy();
+}
+
 // lua start
 #include "LuaBinding.h"
 
@@ -37,6 +44,11 @@ public:
 		LUA->UnyieldLua();
 		COMMON_RETURN_SELF;
 	}
+	static int IsSaving( T* p, lua_State *L )
+	{
+		lua_pushboolean( L, p->IsSaving() );
+		return 1;
+	}
 	static int HaveProfileToSave( T* p, lua_State *L )
 	{
 		LuaHelpers::Push( L, GAMESTATE->HaveProfileToSave() );
@@ -46,6 +58,7 @@ public:
 	LunaScreenProfileSave()
 	{
   		ADD_METHOD( Continue );
+  		ADD_METHOD( IsSaving );
   		ADD_METHOD( HaveProfileToSave );
 	}
 };
@@ -9,6 +9,8 @@ public:
 	virtual void BeginScreen();
 	virtual bool Input( const InputEventPlus &input );
 	void Continue();
+	/* Whether saved profiles are still being written in the background. */
+	bool IsSaving() const;
 
 	virtual void PushSelf( lua_State *L );
 };
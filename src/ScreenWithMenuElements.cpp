@@ -273,6 +273,14 @@ void ScreenWithMenuElements::StartTransitioningScreen( ScreenMessage smSendWhenD
 {
 	TweenOffScreen();
 
+	/* Let the next screen's scripts compile while this one tweens out, unless
+	 * finding out which screen that is would run a branch early. */
+	RString sNextScreen = m_sNextScreen;
+	if( sNextScreen.empty() && THEME->IsMetricConstant(THEME->GetMetricHandle(m_sName, "NextScreen")) )
+		sNextScreen = GetNextScreenName();
+	if( !sNextScreen.empty() )
+		SCREENMAN->PrefetchScreen( sNextScreen );
+
 	m_Out.StartTransitioning( smSendWhenDone );
 	if( WAIT_FOR_CHILDREN_BEFORE_TWEENING_OUT )
 	{
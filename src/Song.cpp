@@ -51,7 +51,7 @@
  * @brief The internal version of the cache for StepMania.
  *
  * Increment this value to invalidate the current cache. */
-const int FILE_CACHE_VERSION = 227;
+const int FILE_CACHE_VERSION = 229;
 
 /** @brief How long does a song sample last by default? */
 const float DEFAULT_MUSIC_SAMPLE_LENGTH = 12.f;
@@ -1155,6 +1155,10 @@ void Song::ReCalculateRadarValuesAndLastSecond(bool fromCache, bool duringCache)
 		NoteData tempNoteData;
 		pSteps->GetNoteData( tempNoteData );
 
+		// Autogen fingerprints are calculated from their own notes when asked for.
+		if( !pSteps->IsAutogen() )
+			pSteps->CalculateFingerprint( tempNoteData );
+
 		// calculate lastSecond
 
 		/* 1. If it's autogen, then first/last beat will come from the parent.
@@ -1185,7 +1189,9 @@ void Song::ReCalculateRadarValuesAndLastSecond(bool fromCache, bool duringCache)
 		{
 			NoteData dummy;
 			dummy.SetNumTracks(tempNoteData.GetNumTracks());
+			const RString sFingerprint = pSteps->GetFingerprint();
 			pSteps->SetNoteData(dummy);
+			pSteps->SetCachedFingerprint(sFingerprint);
 		}
 	}
 
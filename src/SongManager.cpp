@@ -24,6 +24,9 @@
 #include "RageFile.h"
 #include "RageFileManager.h"
 #include "RageLog.h"
+#include "RageSurface_Load.h"
+#include "RageTextureManager.h"
+#include "RageUtil_ThreadPool.h"
 #include "Song.h"
 #include "SongCacheIndex.h"
 #include "SongUtil.h"
@@ -39,6 +42,7 @@
 #include "SpecialFiles.h"
 
 #include <cstddef>
+#include <set>
 #include <tuple>
 #include <vector>
 
@@ -119,6 +123,7 @@ static LocalizedString RELOADING ( "SongManager", "Reloading..." );
 static LocalizedString UNLOADING_SONGS ( "SongManager", "Unloading songs..." );
 static LocalizedString UNLOADING_COURSES ( "SongManager", "Unloading courses..." );
 static LocalizedString SANITY_CHECKING_GROUPS("SongManager", "Sanity checking groups...");
+static LocalizedString LOADING_IMAGES ( "SongManager", "Loading images..." );
 
 void SongManager::Reload( bool bAllowFastLoad, LoadingWindow *ld )
 {
@@ -236,10 +241,19 @@ void SongManager::InitSongsFromDisk( LoadingWindow *ld, bool onlyAdditions )
 	// an entry. -Kyz
 	SONGINDEX->delay_save_cache = true;
 	IMAGECACHE->delay_save_cache = true;
+	// Queue up song and group images so they can be decoded concurrently once
+	// all of the songs have been found.
+	IMAGECACHE->BeginBatch();
 	LoadSongDir( SpecialFiles::SONGS_DIR, ld, onlyAdditions );
 	LoadEnabledSongsFromPref();
 	SONGINDEX->SaveCacheIndex();
 	SONGINDEX->delay_save_cache = false;
+	if( ld )
+	{
+		ld->SetIndeterminate( true );
+		ld->SetText( LOADING_IMAGES.GetValue() );
+	}
+	IMAGECACHE->FinishBatch();
 	IMAGECACHE->WriteToDisk();
 	IMAGECACHE->delay_save_cache = false;
 
@@ -520,14 +534,14 @@ void SongManager::PreloadSongImages()
 	 * that we don't need to. */
 	RageTexturePreloader preload;
 
+	std::vector<RageTextureID> vIDs;
 	const std::vector<Song*> &songs = GetAllSongs();
 	for( unsigned i = 0; i < songs.size(); ++i )
 	{
 		if( !songs[i]->HasBanner() )
 			continue;
 
-		const RageTextureID ID = Sprite::SongBannerTexture( songs[i]->GetBannerPath() );
-		preload.Load( ID );
+		vIDs.push_back( Sprite::SongBannerTexture( songs[i]->GetBannerPath() ) );
 	}
 
 	std::vector<Course*> courses;
@@ -537,10 +551,40 @@ void SongManager::PreloadSongImages()
 		if( !courses[i]->HasBanner() )
 			continue;
 
-		const RageTextureID ID = Sprite::SongBannerTexture( courses[i]->GetBannerPath() );
-		preload.Load( ID );
+		vIDs.push_back( Sprite::SongBannerTexture( courses[i]->GetBannerPath() ) );
+	}
+
+	/* Decode the banners that aren't already loaded on a thread pool, and hand
+	 * each one to the texture loader as it finishes.  Texture creation itself
+	 * has to stay on this thread. */
+	std::vector<RageTextureID> vDecodeIDs;
+	std::vector<RString> vsDecodePaths;
+	std::set<RageTextureID> setDecoding;
+	for( const RageTextureID &ID : vIDs )
+	{
+		if( TEXTUREMAN->IsTextureRegistered(ID) )
+		{
+			preload.Load( ID );
+			continue;
+		}
+		// A song and a course can share a banner; decode it once.
+		if( !setDecoding.insert(ID).second )
+			continue;
+		vDecodeIDs.push_back( ID );
+		vsDecodePaths.push_back( ID.filename );
 	}
 
+	RageThreadPool pool( "PreloadSongImages" );
+	RageSurfaceUtils::LoadFilesWindowed( pool, vsDecodePaths, pool.GetNumThreads() * 2,
+		[&]( int iIndex, RageSurfaceUtils::LoadResult &res )
+	{
+		/* If it didn't decode, the texture load tries again and warns. */
+		if( res.pSurface != nullptr )
+			preload.Load( vDecodeIDs[iIndex], res.pSurface );
+		else
+			preload.Load( vDecodeIDs[iIndex] );
+	} );
+
 	preload.Swap( m_TexturePreload );
 }
 
@@ -514,14 +514,16 @@ void SongUtil::SortSongPointerArrayByGrades( std::vector<Song*> &vpSongsInOut, b
 	std::vector<val> vals;
 	vals.reserve( vpSongsInOut.size() );
 
+	const Profile *pProfile = PROFILEMAN->GetMachineProfile();
+	ASSERT( pProfile != nullptr );
+	const StepsType st = GAMESTATE->GetCurrentStyle(GAMESTATE->GetMasterPlayerNumber())->m_StepsType;
+
 	for( unsigned i = 0; i < vpSongsInOut.size(); ++i )
 	{
 		Song *pSong = vpSongsInOut[i];
 
 		int iCounts[NUM_Grade];
-		const Profile *pProfile = PROFILEMAN->GetMachineProfile();
-		ASSERT( pProfile != nullptr );
-		pProfile->GetGrades( pSong, GAMESTATE->GetCurrentStyle(GAMESTATE->GetMasterPlayerNumber())->m_StepsType, iCounts );
+		pProfile->GetGrades( pSong, st, iCounts );
 
 		RString foo;
 		foo.reserve(256);
@@ -544,14 +546,16 @@ void SongUtil::SortSongPointerArrayByProfileGrades( std::vector<Song*> &vpSongsI
 	std::vector<val> vals;
 	vals.reserve( vpSongsInOut.size() );
 
+	const Profile *pProfile = PROFILEMAN->GetProfile(pn);
+	ASSERT( pProfile != nullptr );
+	const StepsType st = GAMESTATE->GetCurrentStyle(pn)->m_StepsType;
+
 	for( unsigned i = 0; i < vpSongsInOut.size(); ++i )
 	{
 		Song *pSong = vpSongsInOut[i];
 
 		int iCounts[NUM_Grade];
-		const Profile *pProfile = PROFILEMAN->GetProfile(pn);
-		ASSERT( pProfile != nullptr );
-		pProfile->GetGrades( pSong, GAMESTATE->GetCurrentStyle(pn)->m_StepsType, iCounts );
+		pProfile->GetGrades( pSong, st, iCounts );
 
 		RString foo;
 		foo.reserve(256);
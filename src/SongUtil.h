@@ -6,7 +6,10 @@
 #include "GameConstantsAndTypes.h"
 #include "Difficulty.h"
 
+#include <cstddef>
+#include <functional>
 #include <set>
+#include <string>
 #include <vector>
 
 
@@ -227,6 +230,11 @@ public:
 	{
 		return sDir == other.sDir;
 	}
+	/** @brief Hash a SongID consistently with operator==, for unordered containers. */
+	struct Hash
+	{
+		std::size_t operator()( const SongID &id ) const { return std::hash<std::string>()( id.sDir ); }
+	};
 
 	XNode* CreateNode() const;
 	void LoadFromNode( const XNode* pNode );
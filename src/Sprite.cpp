@@ -18,6 +18,7 @@
 #include <cfloat>
 #include <cmath>
 #include <cstddef>
+#include <typeinfo>
 #include <vector>
 
 REGISTER_ACTOR_CLASS( Sprite );
@@ -278,6 +279,7 @@ void Sprite::LoadFromNode( const XNode* pNode )
 		if( !aStates.empty() )
 		{
 			m_States = aStates;
+			MarkUpdateDirty();
 			Sprite::m_size.x = aStates[0].rect.GetWidth() / m_pTexture->GetSourceToTexCoordsRatioX();
 			Sprite::m_size.y = aStates[0].rect.GetHeight() / m_pTexture->GetSourceToTexCoordsRatioY();
 		}
@@ -336,6 +338,7 @@ void Sprite::SetTexture( RageTexture *pTexture )
 	{
 		UnloadTexture();
 		m_pTexture = pTexture;
+		MarkUpdateDirty();
 	}
 
 	ASSERT( m_pTexture->GetTextureWidth() >= 0 );
@@ -392,6 +395,7 @@ void Sprite::LoadStatesFromTexture()
 {
 	// Assume the frames of this animation play in sequential order with 0.1 second delay.
 	m_States.clear();
+	MarkUpdateDirty();
 
 	if( m_pTexture == nullptr )
 	{
@@ -436,6 +440,30 @@ void Sprite::UpdateAnimationState()
 	}
 }
 
+bool Sprite::SpriteIsIdle() const
+{
+	if( !ActorIsIdle() )
+		return false;
+	if( !m_bIsAnimating || m_pTexture == nullptr )
+		return true;
+	return m_States.size() <= 1 && !(m_DecodeMovie && m_pTexture->IsAMovie()) &&
+		m_fTexCoordVelocityX == 0 && m_fTexCoordVelocityY == 0;
+}
+
+bool Sprite::GetDrawBounds( RectF &rect ) const
+{
+	// Custom coordinates can put the vertices anywhere.
+	if( m_bUsingCustomPosCoords )
+		return false;
+	rect = RectF( -m_size.x/2.0f, -m_size.y/2.0f, +m_size.x/2.0f, +m_size.y/2.0f );
+	return true;
+}
+
+bool Sprite::IsIdle() const
+{
+	return typeid(*this) == typeid(Sprite) && SpriteIsIdle();
+}
+
 /* We treat frame animation and movie animation slightly differently.
  *
  * Sprite animation is always tied directly to the effect timer. If you pause
@@ -960,6 +988,7 @@ void Sprite::SetTexCoordVelocity(float fVelX, float fVelY)
 {
 	m_fTexCoordVelocityX = fVelX;
 	m_fTexCoordVelocityY = fVelY;
+	MarkUpdateDirty();
 }
 
 void Sprite::ScaleToClipped( float fWidth, float fHeight )
@@ -1300,6 +1329,7 @@ public:
 	static int SetDecodeMovie(T* p, lua_State *L)
 	{
 		p->m_DecodeMovie= BArg(1);
+		p->MarkUpdateDirty();
 		COMMON_RETURN_SELF;
 	}
 	static int LoadFromCached( T* p, lua_State *L )
@@ -37,6 +37,7 @@ public:
 
 	virtual bool EarlyAbortDraw() const override;
 	virtual void DrawPrimitives() override;
+	virtual bool GetDrawBounds( RectF &rect ) const override;
 	virtual void Update( float fDeltaTime ) override;
 
 	void UpdateAnimationState();	// take m_fSecondsIntoState, and move to a new state
@@ -63,7 +64,7 @@ public:
 	virtual void RecalcAnimationLengthSeconds();
 	virtual void SetSecondsIntoAnimation( float fSeconds ) override;
 	void SetStateProperties(const std::vector<State>& new_states)
-	{ m_States= new_states; RecalcAnimationLengthSeconds(); SetState(0); }
+	{ m_States= new_states; RecalcAnimationLengthSeconds(); SetState(0); MarkUpdateDirty(); }
 
 	RString	GetTexturePath() const;
 
@@ -105,6 +106,10 @@ public:
 protected:
 	void LoadFromTexture( RageTextureID ID );
 
+	virtual bool IsIdle() const override;
+	/* Idle, and not animating, playing a movie or scrolling its texture. */
+	bool SpriteIsIdle() const;
+
 private:
 	void LoadStatesFromTexture();
 
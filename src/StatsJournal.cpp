@@ -0,0 +1,183 @@
+#include "global.h"
+#include "StatsJournal.h"
+#include "RageFile.h"
+#include "RageFileManager.h"
+#include "RageLog.h"
+#include "RageThreads.h"
+#include "RageUtil.h"
+#include "RageUtil_ThreadPool.h"
+#include "XmlFile.h"
+#include "XmlFileUtil.h"
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <map>
+
+static const std::uint32_t JOURNAL_RECORD_MAGIC = 0x314a5453; // "STJ1"
+
+struct RecordHeader
+{
+	std::uint32_t magic;
+	std::uint32_t iSequence;
+	std::uint32_t iSize;
+	std::uint32_t iCRC;	// of the record's XML
+};
+
+struct JournalState
+{
+	JournalState(): iLastSequence(0), iSize(0) { }
+	unsigned iLastSequence;
+	int iSize;
+};
+
+/* Held while a journal file is written or removed, and to access
+ * g_mapJournals, which is keyed by path. */
+static RageMutex g_JournalLock( "StatsJournal" );
+static std::map<RString, JournalState> g_mapJournals;
+
+/* Only touched from the main thread. */
+static RageThreadPool *g_pCompactionThread = nullptr;
+static std::future<void> g_Compaction;
+static RString g_sCompactionDir;
+
+bool StatsJournal::Append( const RString &sPath, unsigned iSequence, const XNode *pStats )
+{
+	RString sXml = XmlFileUtil::GetXML( pStats );
+
+	RecordHeader h;
+	h.magic = JOURNAL_RECORD_MAGIC;
+	h.iSequence = iSequence;
+	h.iSize = sXml.size();
+	h.iCRC = 0;
+	CRC32( h.iCRC, sXml.data(), sXml.size() );
+
+	LockMut( g_JournalLock );
+	RageFile f;
+	if( !f.Open(sPath, RageFile::WRITE|RageFile::APPEND|RageFile::SLOW_FLUSH) )
+	{
+		LOG->Warn( "Couldn't open %s for writing: %s", sPath.c_str(), f.GetError().c_str() );
+		return false;
+	}
+
+	if( f.Write(&h, sizeof(h)) == -1 || f.Write(sXml) == -1 || f.Flush() == -1 )
+	{
+		LOG->Warn( "Couldn't write %s: %s", sPath.c_str(), f.GetError().c_str() );
+		return false;
+	}
+
+	// Closing syncs it to disk.
+	f.Close();
+
+	JournalState &state = g_mapJournals[sPath];
+	state.iLastSequence = iSequence;
+	state.iSize += sizeof(h) + sXml.size();
+	return true;
+}
+
+void StatsJournal::Replay( const RString &sPath, unsigned iAfterSequence, const std::function<void(unsigned, const XNode *)> &fn )
+{
+	LockMut( g_JournalLock );
+	JournalState &state = g_mapJournals[sPath];
+	state = JournalState();
+
+	RString sData;
+	if( !IsAFile(sPath) || !GetFileContents(sPath, sData) )
+		return;
+
+	std::size_t iPos = 0;
+	int iRecords = 0;
+	while( iPos + sizeof(RecordHeader) <= sData.size() )
+	{
+		RecordHeader h;
+		memcpy( &h, sData.data() + iPos, sizeof(h) );
+		if( h.magic != JOURNAL_RECORD_MAGIC || h.iSize > sData.size() - iPos - sizeof(h) )
+			break;
+
+		const char *pXml = sData.data() + iPos + sizeof(h);
+		unsigned iCRC = 0;
+		CRC32( iCRC, pXml, h.iSize );
+		if( iCRC != h.iCRC )
+			break;
+
+		iPos += sizeof(h) + h.iSize;
+		state.iLastSequence = h.iSequence;
+		if( h.iSequence <= iAfterSequence )
+			continue;
+
+		XNode xml;
+		RString sError;
+		XmlFileUtil::Load( &xml, RString(pXml, h.iSize), sError );
+		if( !sError.empty() )
+		{
+			LOG->Warn( "%s: record %u: %s", sPath.c_str(), h.iSequence, sError.c_str() );
+			continue;
+		}
+
+		fn( h.iSequence, &xml );
+		++iRecords;
+	}
+	state.iSize = iPos;
+
+	LOG->Trace( "Applied %i records from %s", iRecords, sPath.c_str() );
+
+	/* Appending after a damaged record would leave the new ones unreadable,
+	 * so cut it off. */
+	if( iPos < sData.size() )
+	{
+		LOG->Warn( "%s: discarding %i damaged bytes", sPath.c_str(), int(sData.size() - iPos) );
+		RageFile f;
+		if( !f.Open(sPath, RageFile::WRITE|RageFile::SLOW_FLUSH) ||
+			f.Write(sData.data(), iPos) == -1 || f.Flush() == -1 )
+			LOG->Warn( "Couldn't rewrite %s: %s", sPath.c_str(), f.GetError().c_str() );
+	}
+}
+
+int StatsJournal::GetSize( const RString &sPath )
+{
+	LockMut( g_JournalLock );
+	std::map<RString, JournalState>::const_iterator it = g_mapJournals.find( sPath );
+	return it == g_mapJournals.end()? 0: it->second.iSize;
+}
+
+void StatsJournal::Remove( const RString &sPath, unsigned iSequence )
+{
+	LockMut( g_JournalLock );
+	JournalState &state = g_mapJournals[sPath];
+	if( state.iLastSequence > iSequence )
+		return;
+
+	if( FILEMAN->IsAFile(sPath) )
+		FILEMAN->Remove( sPath );
+	state.iSize = 0;
+}
+
+bool StatsJournal::IsCompacting()
+{
+	return g_Compaction.valid() && g_Compaction.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+}
+
+void StatsJournal::StartCompaction( const RString &sDir, const std::function<void()> &job )
+{
+	ASSERT( !IsCompacting() );
+	if( g_pCompactionThread == nullptr )
+		g_pCompactionThread = new RageThreadPool( "StatsJournal", 1 );
+	g_sCompactionDir = sDir;
+	g_Compaction = g_pCompactionThread->Submit( job );
+}
+
+void StatsJournal::WaitForCompaction( const RString &sDir )
+{
+	if( !IsCompacting() )
+		return;
+	if( !BeginsWith(g_sCompactionDir, sDir) && !BeginsWith(sDir, g_sCompactionDir) )
+		return;
+	g_Compaction.wait();
+}
+
+void StatsJournal::Shutdown()
+{
+	if( g_Compaction.valid() )
+		g_Compaction.wait();
+	SAFE_DELETE( g_pCompactionThread );
+}
@@ -0,0 +1,49 @@
+/* StatsJournal - an append-only log of profile changes, kept beside Stats.xml. */
+
+#ifndef STATS_JOURNAL_H
+#define STATS_JOURNAL_H
+
+#include <functional>
+
+class XNode;
+
+/* Rewriting a machine's whole Stats.xml after every song takes longer the
+ * more scores it holds.  Instead, each save appends a record of just what's
+ * changed to the journal, and syncs it to disk.  Once the journal has grown
+ * large, Stats.xml is rewritten in the background and the journal is thrown
+ * away.
+ *
+ * Records are numbered.  Stats.xml remembers the last record it includes, so
+ * records from a journal that wasn't removed are never applied twice. */
+namespace StatsJournal
+{
+	/* Append pStats, a <Stats> tree, to the journal at sPath as record
+	 * iSequence, and sync it to disk.  Returns false on error. */
+	bool Append( const RString &sPath, unsigned iSequence, const XNode *pStats );
+
+	/* Call fn with each record in the journal at sPath after iAfterSequence,
+	 * in order.  A damaged record at the end, from a write that was cut off,
+	 * is discarded. */
+	void Replay( const RString &sPath, unsigned iAfterSequence, const std::function<void(unsigned, const XNode *)> &fn );
+
+	/* The size of the journal at sPath, as far as it's been read or written. */
+	int GetSize( const RString &sPath );
+
+	/* Remove the journal at sPath, unless records after iSequence have been
+	 * appended to it.  Safe to call from any thread. */
+	void Remove( const RString &sPath, unsigned iSequence );
+
+	/* Run job, which rewrites the Stats.xml in sDir, on the compaction
+	 * thread.  Only one compaction runs at a time. */
+	bool IsCompacting();
+	void StartCompaction( const RString &sDir, const std::function<void()> &job );
+
+	/* Wait for a compaction of sDir (or a directory inside it) to finish,
+	 * before its Stats.xml is read or written on this thread.  Compactions of
+	 * other profiles aren't waited for. */
+	void WaitForCompaction( const RString &sDir );
+
+	void Shutdown();
+}
+
+#endif
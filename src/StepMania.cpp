@@ -67,6 +67,7 @@
 #include "SpecialFiles.h"
 #include "Profile.h"
 #include "ActorUtil.h"
+#include "RageUtil_SlabAllocator.h"
 #include "ver.h"
 
 #include <cmath>
@@ -278,6 +279,18 @@ void StepMania::ResetPreferences()
 	ApplyGraphicOptions();
 }
 
+static void LogSlabAllocatorStats()
+{
+	std::vector<RageSlabAllocator::Stats> vStats;
+	RageSlabAllocator::GetAllStats( vStats );
+	for( const RageSlabAllocator::Stats &s : vStats )
+	{
+		LOG->Info( "Slab allocator \"%s\": %i-byte blocks, %i slabs, peak %i live, %llu allocations, %llu from the heap",
+			s.szName, (int) s.iBlockSize, s.iSlabs, s.iPeak,
+			(unsigned long long) s.iAllocations, (unsigned long long) s.iHeapAllocations );
+	}
+}
+
 /* Shutdown all global singletons. Note that this may be called partway through
  * initialization, due to an object failing to initialize, in which case some of
  * these may still be nullptr. */
@@ -330,6 +343,8 @@ void ShutdownGame()
 	SAFE_DELETE( TEXTUREMAN );
 	SAFE_DELETE( DISPLAY );
 	Dialog::Shutdown();
+	if( LOG )
+		LogSlabAllocatorStats();
 	SAFE_DELETE( LOG );
 	SAFE_DELETE( FILEMAN );
 	SAFE_DELETE( LUA );
@@ -31,6 +31,7 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <map>
 #include <vector>
 
 /* register DisplayBPM with StringConversion */
@@ -55,6 +56,8 @@ Steps::Steps(Song *song): m_StepsType(StepsType_Invalid), m_pSong(song),
 	m_sDescription(""), m_sChartStyle(""),
 	m_Difficulty(Difficulty_Invalid), m_iMeter(0),
 	m_bAreCachedRadarValuesJustLoaded(false),
+	m_bIsCachedNoteDensityJustLoaded(false),
+	m_bFingerprintCalculated(false),
 	m_sCredit(""), displayBPMType(DISPLAY_BPM_ACTUAL),
 	specifiedBPMMin(0), specifiedBPMMax(0) {}
 
@@ -184,6 +187,8 @@ void Steps::SetNoteData( const NoteData& noteDataNew )
 
 	m_sNoteDataCompressed = RString();
 	m_iHash = 0;
+	m_sFingerprint = RString();
+	m_bFingerprintCalculated = false;
 }
 
 void Steps::GetNoteData( NoteData& noteDataOut ) const
@@ -215,6 +220,8 @@ void Steps::SetSMNoteData( const RString &notes_comp_ )
 
 	m_sNoteDataCompressed = notes_comp_;
 	m_iHash = 0;
+	m_sFingerprint = RString();
+	m_bFingerprintCalculated = false;
 }
 
 /* XXX: this function should pull data from m_sFilename, like Decompress() */
@@ -301,11 +308,13 @@ void Steps::CalculateRadarValues( float fMusicLengthSeconds )
 	if( parent != nullptr )
 		return;
 
-	if( m_bAreCachedRadarValuesJustLoaded )
-	{
-		m_bAreCachedRadarValuesJustLoaded = false;
+	// The density is calculated in the same pass, so both have to be cached
+	// to skip it.
+	const bool bCached = m_bAreCachedRadarValuesJustLoaded && m_bIsCachedNoteDensityJustLoaded;
+	m_bAreCachedRadarValuesJustLoaded = false;
+	m_bIsCachedNoteDensityJustLoaded = false;
+	if( bCached )
 		return;
-	}
 
 	// Do write radar values, and leave it up to the reading app whether they want to trust
 	// the cached values without recalculating them.
@@ -320,6 +329,7 @@ void Steps::CalculateRadarValues( float fMusicLengthSeconds )
 
 	FOREACH_PlayerNumber( pn )
 		m_CachedRadarValues[pn].Zero();
+	m_NoteDensity.Clear();
 
 	GAMESTATE->SetProcessedTimingData(this->GetTimingData());
 	if( tempNoteData.IsComposite() )
@@ -328,7 +338,8 @@ void Steps::CalculateRadarValues( float fMusicLengthSeconds )
 
 		NoteDataUtil::SplitCompositeNoteData( tempNoteData, vParts );
 		for( std::size_t pn = 0; pn < std::min(vParts.size(), std::size_t(NUM_PLAYERS)); ++pn )
-			NoteDataUtil::CalculateRadarValues( vParts[pn], fMusicLengthSeconds, m_CachedRadarValues[pn] );
+			NoteDataUtil::CalculateRadarValues( vParts[pn], fMusicLengthSeconds, m_CachedRadarValues[pn],
+				pn == 0? &m_NoteDensity:nullptr );
 	}
 	else if (GAMEMAN->GetStepsTypeInfo(this->m_StepsType).m_StepsTypeCategory == StepsTypeCategory_Couple)
 	{
@@ -338,7 +349,8 @@ void Steps::CalculateRadarValues( float fMusicLengthSeconds )
 		p1.SetNumTracks(tracks);
 		NoteDataUtil::CalculateRadarValues(p1,
 										   fMusicLengthSeconds,
-										   m_CachedRadarValues[PLAYER_1]);
+										   m_CachedRadarValues[PLAYER_1],
+										   &m_NoteDensity);
 		// at this point, p2 is tempNoteData.
 		NoteDataUtil::ShiftTracks(tempNoteData, tracks);
 		tempNoteData.SetNumTracks(tracks);
@@ -348,7 +360,7 @@ void Steps::CalculateRadarValues( float fMusicLengthSeconds )
 	}
 	else
 	{
-		NoteDataUtil::CalculateRadarValues( tempNoteData, fMusicLengthSeconds, m_CachedRadarValues[0] );
+		NoteDataUtil::CalculateRadarValues( tempNoteData, fMusicLengthSeconds, m_CachedRadarValues[0], &m_NoteDensity );
 		std::fill_n( m_CachedRadarValues + 1, NUM_PLAYERS-1, m_CachedRadarValues[0] );
 	}
 	GAMESTATE->SetProcessedTimingData(nullptr);
@@ -631,6 +643,13 @@ void Steps::SetCachedRadarValues( const RadarValues v[NUM_PLAYERS] )
 	m_bAreCachedRadarValuesJustLoaded = true;
 }
 
+void Steps::SetCachedNoteDensity( const NoteDensity &density )
+{
+	DeAutogen();
+	m_NoteDensity = density;
+	m_bIsCachedNoteDensityJustLoaded = true;
+}
+
 RString Steps::GenerateChartKey()
 {
 	ChartKey = this->GenerateChartKey(*m_pNoteData, this->GetTimingData());
@@ -701,6 +720,97 @@ RString Steps::GenerateChartKey(NoteData &nd, TimingData *td)
 	return o;
 }
 
+static char GetFingerprintChar( const TapNote &tn )
+{
+	switch( tn.type )
+	{
+	case TapNoteType_Tap:		return '1';
+	case TapNoteType_HoldHead:	return tn.subType == TapNoteSubType_Roll? '4':'2';
+	case TapNoteType_HoldTail:	return '3';
+	case TapNoteType_Mine:		return 'M';
+	case TapNoteType_Attack:	return 'A';
+	case TapNoteType_Lift:		return 'L';
+	case TapNoteType_Fake:		return 'F';
+	/* Keysounds aren't played, and are often the only difference between
+	 * copies of a chart. */
+	default:			return '\0';
+	}
+}
+
+/* The canonical form is one line per row that has a note or the end of a
+ * hold, keyed by the row rather than its measure, followed by the timing
+ * segments that change what the player hits or when.  The offset and the
+ * scroll and speed gimmicks are left out, so a resynced chart is the same. */
+static RString GetFingerprintText( const NoteData &nd, const TimingData &td, StepsType st )
+{
+	const int iNumTracks = nd.GetNumTracks();
+	std::map<int, RString> mapRows;
+	for( int t = 0; t < iNumTracks; ++t )
+	{
+		for( NoteData::const_iterator it = nd.begin(t); it != nd.end(t); ++it )
+		{
+			const char c = GetFingerprintChar( it->second );
+			if( c == '\0' )
+				continue;
+
+			RString &sRow = mapRows[it->first];
+			if( sRow.empty() )
+				sRow.assign( iNumTracks, '0' );
+			sRow[t] = c;
+
+			if( it->second.type == TapNoteType_HoldHead )
+			{
+				RString &sTail = mapRows[it->first + it->second.iDuration];
+				if( sTail.empty() )
+					sTail.assign( iNumTracks, '0' );
+				sTail[t] = '3';
+			}
+		}
+	}
+
+	RString sText = GAMEMAN->GetStepsTypeInfo( st ).szName;
+	sText += "\n";
+	for( const std::pair<const int, RString> &row : mapRows )
+		sText += ssprintf( "%d:%s\n", row.first, row.second.c_str() );
+
+	for( const TimingSegment *seg : td.GetTimingSegments(SEGMENT_BPM) )
+		sText += ssprintf( "B%d=%.3f\n", seg->GetRow(), ToBPM(seg)->GetBPM() );
+	for( const TimingSegment *seg : td.GetTimingSegments(SEGMENT_STOP) )
+		sText += ssprintf( "S%d=%.3f\n", seg->GetRow(), ToStop(seg)->GetPause() );
+	for( const TimingSegment *seg : td.GetTimingSegments(SEGMENT_DELAY) )
+		sText += ssprintf( "D%d=%.3f\n", seg->GetRow(), ToDelay(seg)->GetPause() );
+	for( const TimingSegment *seg : td.GetTimingSegments(SEGMENT_WARP) )
+		sText += ssprintf( "W%d=%d\n", seg->GetRow(), ToWarp(seg)->GetLengthRows() );
+	for( const TimingSegment *seg : td.GetTimingSegments(SEGMENT_FAKE) )
+		sText += ssprintf( "F%d=%d\n", seg->GetRow(), ToFake(seg)->GetLengthRows() );
+	return sText;
+}
+
+static RString MakeFingerprint( const NoteData &nd, const TimingData &td, StepsType st )
+{
+	if( nd.IsEmpty() )
+		return RString();
+	return BinaryToHex( CryptManager::GetSHA1ForString(GetFingerprintText(nd, td, st)) );
+}
+
+void Steps::CalculateFingerprint( const NoteData &nd )
+{
+	m_sFingerprint = MakeFingerprint( nd, *GetTimingData(), m_StepsType );
+	m_bFingerprintCalculated = true;
+}
+
+const RString &Steps::GetFingerprint() const
+{
+	if( !m_bFingerprintCalculated )
+	{
+		NoteData nd;
+		GetNoteData( nd );
+		m_sFingerprint = MakeFingerprint( nd, *GetTimingData(), m_StepsType );
+		m_bFingerprintCalculated = true;
+	}
+	return m_sFingerprint;
+}
+
 
 // lua start
 #include "LuaBinding.h"
@@ -740,12 +850,28 @@ public:
 		rv.PushSelf(L);
 		return 1;
 	}
+	static int GetNotesPerMeasure( T* p, lua_State *L )
+	{
+		LuaHelpers::CreateTableFromArray( p->GetNoteDensity().m_viNotesPerMeasure, L );
+		return 1;
+	}
+	static int GetPeakNPS( T* p, lua_State *L )
+	{
+		lua_pushnumber( L, p->GetNoteDensity().m_fPeakNPS );
+		return 1;
+	}
+	static int GetStreamBreakdown( T* p, lua_State *L )
+	{
+		LuaHelpers::CreateTableFromArray( p->GetNoteDensity().m_viStreamRuns, L );
+		return 1;
+	}
 	static int GetTimingData( T* p, lua_State *L )
 	{
 		p->GetTimingData()->PushSelf(L);
 		return 1;
 	}
 	static int GetHash( T* p, lua_State *L ) { lua_pushnumber( L, p->GetHash() ); return 1; }
+	static int GetFingerprint( T* p, lua_State *L ) { lua_pushstring( L, p->GetFingerprint() ); return 1; }
 	// untested
 	/*
 	static int GetSMNoteData( T* p, lua_State *L )
@@ -807,10 +933,14 @@ public:
 		ADD_METHOD( GetDifficulty );
 		ADD_METHOD( GetFilename );
 		ADD_METHOD( GetHash );
+		ADD_METHOD( GetFingerprint );
 		ADD_METHOD( GetMeter );
 		ADD_METHOD( HasSignificantTimingChanges );
 		ADD_METHOD( HasAttacks );
 		ADD_METHOD( GetRadarValues );
+		ADD_METHOD( GetNotesPerMeasure );
+		ADD_METHOD( GetPeakNPS );
+		ADD_METHOD( GetStreamBreakdown );
 		ADD_METHOD( GetTimingData );
 		ADD_METHOD( GetChartName );
 		//ADD_METHOD( GetSMNoteData );
@@ -102,6 +102,13 @@ public:
 	 */
 	int GetMeter() const				{ return Real()->m_iMeter; }
 	const RadarValues& GetRadarValues( PlayerNumber pn ) const { return Real()->m_CachedRadarValues[pn]; }
+	/**
+	 * @brief Retrieve how the notes are spread over the chart.
+	 *
+	 * This is calculated with the radar values; for charts with a part for
+	 * each player, it covers only the first player's part.
+	 * @return the note density. */
+	const NoteDensity& GetNoteDensity() const { return Real()->m_NoteDensity; }
 	/**
 	 * @brief Retrieve the author credit used for this edit.
 	 * @return the author credit used for this edit.
@@ -134,11 +141,24 @@ public:
 	RString GetChartKey();
 	void SetChartKey(const RString &k) { ChartKey = k; }
 
+	/**
+	 * @brief Retrieve a fingerprint identifying this chart.
+	 *
+	 * This is the hex SHA-1 of a canonical form of the notes and of the timing
+	 * that affects play, so it doesn't change with how the simfile was written:
+	 * quantization, empty measures and keysounds don't matter.  It's calculated
+	 * while the song is loaded and kept in the song cache.
+	 * @return the fingerprint, or an empty string if there's no note data. */
+	const RString &GetFingerprint() const;
+	void CalculateFingerprint( const NoteData &nd );
+	void SetCachedFingerprint( const RString &sFingerprint ) { m_sFingerprint = sFingerprint; m_bFingerprintCalculated = true; }
+
 	void ChangeFilenamesForCustomSong();
 
 	void SetLoadedFromProfile( ProfileSlot slot )	{ m_LoadedFromProfile = slot; }
 	void SetMeter( int meter );
 	void SetCachedRadarValues( const RadarValues v[NUM_PLAYERS] );
+	void SetCachedNoteDensity( const NoteDensity &density );
 	float PredictMeter() const;
 
 	unsigned GetHash() const;
@@ -253,6 +273,13 @@ private:
 	/** @brief The radar values used for each player. */
 	RadarValues			m_CachedRadarValues[NUM_PLAYERS];
 	bool                m_bAreCachedRadarValuesJustLoaded;
+	/** @brief The note density, calculated along with the radar values. */
+	NoteDensity			m_NoteDensity;
+	bool				m_bIsCachedNoteDensityJustLoaded;
+	/** @brief The chart's fingerprint; empty for a chart with no notes. */
+	mutable RString			m_sFingerprint;
+	/** @brief Whether m_sFingerprint has been calculated or loaded. */
+	mutable bool			m_bFingerprintCalculated;
 	/** @brief The name of the person who created the Steps. */
 	RString				m_sCredit;
 	/** @brief The name of the chart. */
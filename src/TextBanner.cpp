@@ -5,6 +5,8 @@
 #include "ThemeManager.h"
 #include "XmlFile.h"
 
+#include <typeinfo>
+
 REGISTER_ACTOR_CLASS( TextBanner );
 
 void TextBanner::LoadFromNode( const XNode* pNode )
@@ -83,6 +85,11 @@ void TextBanner::SetFromSong( const Song *pSong )
 			m_sArtistPrependString + pSong->GetDisplayArtist(),	m_sArtistPrependString + pSong->GetTranslitArtist() );
 }
 
+bool TextBanner::IsIdle() const
+{
+	return typeid(*this) == typeid(TextBanner) && FrameIsIdle();
+}
+
 // lua start
 #include "LuaBinding.h"
 
@@ -25,6 +25,9 @@ public:
 	// Lua
 	void PushSelf( lua_State *L );
 
+protected:
+	virtual bool IsIdle() const;
+
 private:
 	bool m_bInitted;
 	BitmapText	m_textTitle, m_textSubTitle, m_textArtist;
@@ -10,11 +10,13 @@
 #include "arch/ArchHooks/ArchHooks.h"
 #include "arch/Dialog/Dialog.h"
 #include "RageFile.h"
+#include "RageTextureCache.h"
 #if !defined(SMPACKAGE)
 #include "ScreenManager.h"
 #include "ProfileManager.h"
 #include "Profile.h"
 #include "ActorUtil.h"
+#include "MessageManager.h"
 #endif
 #include "GameLoop.h" // For ChangeTheme
 #include "ThemeMetric.h"
@@ -28,7 +30,10 @@
 #include "XmlFileUtil.h"
 
 #include <cstddef>
+#include <cstdlib>
 #include <deque>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 
@@ -53,15 +58,51 @@ struct Theme
 };
 // When looking for a metric or an element, search these from head to tail.
 static std::deque<Theme> g_vThemes;
+/* A metric's value after group fallbacks, ready to push.  Constant values
+ * are pushed directly; anything else is compiled once, and the compiled chunk
+ * is run each time, so metrics that depend on game state still change. */
+struct CompiledMetric
+{
+	enum Type
+	{
+		Number,
+		Boolean,
+		String,
+		Chunk,
+		Uncompiled	// didn't compile; evaluate it from source to report the error
+	};
+
+	RString sName;	// "Group::Name"
+	RString sValue;
+	Type type;
+	bool bCommand;
+	double fNumber;
+	LuaReference chunk;
+};
+
 class LoadedThemeData
 {
 public:
+	LoadedThemeData(): iGeneration(0) { }
 	IniFile iniMetrics;
 	IniFile iniStrings;
+
+	/* Filled in as metrics are looked up, and thrown away on reload, since
+	 * fallbacks and values may use functions from theme scripts that aren't
+	 * loaded yet when the metrics are. */
+	std::deque<CompiledMetric> vMetrics;
+	std::unordered_map<std::string, int> mapNameToMetric;
+	std::unordered_map<std::string, RString> mapGroupFallback;
+	int iGeneration;
+
 	void ClearAll()
 	{
 		iniMetrics.Clear();
 		iniStrings.Clear();
+		vMetrics.clear();
+		mapNameToMetric.clear();
+		mapGroupFallback.clear();
+		++iGeneration;
 	}
 };
 LoadedThemeData *g_pLoadedThemeData = nullptr;
@@ -435,12 +476,25 @@ void ThemeManager::SwitchThemeAndLanguage( const RString &sThemeName_, const RSt
 		return;
 
 	m_bPseudoLocalize = bPseudoLocalize;
+	RageTimer tLoad;
 
 	// Load theme metrics. If only the language is changing, this is all
 	// we need to reload.
 	bool bThemeChanging = (sThemeName != m_sCurThemeName);
+	const RString sOldThemeName = m_sCurThemeName;
 	LoadThemeMetrics( sThemeName, sLanguage );
 
+	/* Converted textures of the theme we're leaving are no longer useful,
+	 * unless the new theme falls back on it. */
+	if( bThemeChanging && !sOldThemeName.empty() )
+	{
+		bool bStillUsed = false;
+		for (Theme const &theme : g_vThemes)
+			bStillUsed |= theme.sThemeName == sOldThemeName;
+		if( !bStillUsed )
+			RageTextureCache::FlushDirectory( GetThemeDirFromName(sOldThemeName) );
+	}
+
 	// Clear the theme path cache. This caches language-specific graphic paths,
 	// so do this even if only the language is changing.
 	ClearThemePathCache();
@@ -451,6 +505,10 @@ void ThemeManager::SwitchThemeAndLanguage( const RString &sThemeName_, const RSt
 		if( SCREENMAN != nullptr )
 			SCREENMAN->ThemeChanged();
 
+		// Deferred delivery is set up by the theme's scripts.
+		if( MESSAGEMAN != nullptr )
+			MESSAGEMAN->ClearDeferred();
+
 #endif
 
 		/* Lua globals can use metrics which are cached, and vice versa.  Update Lua
@@ -470,6 +528,9 @@ void ThemeManager::SwitchThemeAndLanguage( const RString &sThemeName_, const RSt
 	LocalizedString::RegisterLocalizer( LocalizedStringImplThemeMetric::Create );
 
 	ReloadSubscribers();
+
+	LOG->Trace( "Theme \"%s\" loaded in %f, %i metrics compiled",
+		m_sCurThemeName.c_str(), tLoad.GetDeltaTime(), (int) g_pLoadedThemeData->vMetrics.size() );
 }
 
 void ThemeManager::ReloadSubscribers()
@@ -907,12 +968,11 @@ RString ThemeManager::GetMetricsIniPath( const RString &sThemeName )
 
 bool ThemeManager::HasMetric( const RString &sMetricsGroup, const RString &sValueName )
 {
-	RString sThrowAway;
 	if(sMetricsGroup == "" || sValueName == "")
 	{
 		return false;
 	}
-	return GetMetricRawRecursive( g_pLoadedThemeData->iniMetrics, sMetricsGroup, sValueName, sThrowAway );
+	return IsMetricHandleValid( GetMetricHandle(sMetricsGroup, sValueName) );
 }
 
 bool ThemeManager::HasString( const RString &sMetricsGroup, const RString &sValueName )
@@ -935,8 +995,10 @@ void ThemeManager::ReloadMetrics()
 	//UpdateLuaGlobals();
 
 	// force a reload of the metrics cache
+	RageTimer tLoad;
 	LoadThemeMetrics( m_sCurThemeName, m_sCurLanguage );
 	ReloadSubscribers();
+	LOG->Trace( "Metrics reloaded in %f, %i compiled", tLoad.GetDeltaTime(), (int) g_pLoadedThemeData->vMetrics.size() );
 
 	ClearThemePathCache();
 }
@@ -946,17 +1008,22 @@ RString ThemeManager::GetMetricsGroupFallback( const RString &sMetricsGroup )
 {
 	ASSERT( g_pLoadedThemeData != nullptr );
 
+	std::unordered_map<std::string, RString>::const_iterator it = g_pLoadedThemeData->mapGroupFallback.find( sMetricsGroup );
+	if( it != g_pLoadedThemeData->mapGroupFallback.end() )
+		return it->second;
+
 	// always look in iniMetrics for "Fallback"
 	RString sFallback;
-	if( !GetMetricRawRecursive(g_pLoadedThemeData->iniMetrics,sMetricsGroup,"Fallback",sFallback) )
-		return RString();
-
-	Lua *L = LUA->Get();
-	LuaHelpers::RunExpression( L, sFallback );
 	RString sRet;
-	LuaHelpers::Pop( L, sRet );
-	LUA->Release( L );
+	if( GetMetricRawRecursive(g_pLoadedThemeData->iniMetrics,sMetricsGroup,"Fallback",sFallback) )
+	{
+		Lua *L = LUA->Get();
+		LuaHelpers::RunExpression( L, sFallback );
+		LuaHelpers::Pop( L, sRet );
+		LUA->Release( L );
+	}
 
+	g_pLoadedThemeData->mapGroupFallback[sMetricsGroup] = sRet;
 	return sRet;
 }
 
@@ -1096,6 +1163,157 @@ LuaReference ThemeManager::GetMetricR( const RString &sMetricsGroup, const RStri
 	return ref;
 }
 
+/* Whether Lua would read s as nothing but a number. */
+static bool IsNumberLiteral( const RString &s, double &fOut )
+{
+	if( s.empty() || s.find_first_not_of("0123456789.-+eExXabcdefABCDEF") != RString::npos )
+		return false;
+	if( s.find_first_of("0123456789") == RString::npos )
+		return false;
+
+	char *pEnd;
+	fOut = strtod( s.c_str(), &pEnd );
+	return pEnd == s.c_str() + s.size();
+}
+
+static bool IsStringLiteral( const RString &s )
+{
+	if( s.size() < 2 || (s[0] != '"' && s[0] != '\'') || s[s.size()-1] != s[0] )
+		return false;
+	return s.find_first_of( RString(1, s[0]) + "\\\n", 1 ) == s.size()-1;
+}
+
+static void CompileMetric( Lua *L, CompiledMetric &m )
+{
+	RString sError;
+	if( m.bCommand )
+	{
+		if( LuaHelpers::LoadScript(L, LuaHelpers::GetCommandListScript(m.sValue, false), m.sName, sError) )
+		{
+			m.chunk.SetFromStack( L );
+			m.type = CompiledMetric::Chunk;
+		}
+		return;
+	}
+
+	// Remove unary +, eg. "+50"; Lua doesn't support that.
+	if( m.sValue.size() >= 1 && m.sValue[0] == '+' )
+		m.sValue.erase( 0, 1 );
+
+	if( IsNumberLiteral(m.sValue, m.fNumber) )
+		m.type = CompiledMetric::Number;
+	else if( m.sValue == "true" || m.sValue == "false" )
+		m.type = CompiledMetric::Boolean;
+	else if( IsStringLiteral(m.sValue) )
+		m.type = CompiledMetric::String;
+	else if( LuaHelpers::LoadScript(L, "return " + m.sValue, m.sName, sError) )
+	{
+		m.chunk.SetFromStack( L );
+		m.type = CompiledMetric::Chunk;
+	}
+}
+
+ThemeManager::MetricHandle ThemeManager::GetMetricHandle( const RString &sMetricsGroup, const RString &sValueName )
+{
+	MetricHandle h;
+	if( sMetricsGroup.empty() || sValueName.empty() )
+		return h;
+
+	const RString sName = sMetricsGroup + "::" + sValueName;
+	std::unordered_map<std::string, int>::const_iterator it = g_pLoadedThemeData->mapNameToMetric.find( sName );
+	if( it == g_pLoadedThemeData->mapNameToMetric.end() )
+	{
+		RString sValue;
+		if( !GetMetricRawRecursive(g_pLoadedThemeData->iniMetrics, sMetricsGroup, sValueName, sValue) )
+			return h;
+
+		CompiledMetric m;
+		m.sName = sName;
+		m.sValue = sValue;
+		m.type = CompiledMetric::Uncompiled;
+		m.bCommand = EndsWith( sValueName, "Command" );
+		m.fNumber = 0;
+
+		Lua *L = LUA->Get();
+		CompileMetric( L, m );
+		LUA->Release( L );
+
+		const int iIndex = g_pLoadedThemeData->vMetrics.size();
+		g_pLoadedThemeData->vMetrics.push_back( m );
+		it = g_pLoadedThemeData->mapNameToMetric.insert( std::make_pair(std::string(sName), iIndex) ).first;
+	}
+
+	h.iIndex = it->second;
+	h.iGeneration = g_pLoadedThemeData->iGeneration;
+	return h;
+}
+
+bool ThemeManager::IsMetricHandleValid( const MetricHandle &h ) const
+{
+	return h.iIndex != -1 && g_pLoadedThemeData != nullptr && h.iGeneration == g_pLoadedThemeData->iGeneration;
+}
+
+bool ThemeManager::IsMetricConstant( const MetricHandle &h ) const
+{
+	if( !IsMetricHandleValid(h) )
+		return false;
+
+	switch( g_pLoadedThemeData->vMetrics[h.iIndex].type )
+	{
+	case CompiledMetric::Number:
+	case CompiledMetric::Boolean:
+	case CompiledMetric::String:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void ThemeManager::PushMetric( Lua *L, const MetricHandle &h )
+{
+	if( !IsMetricHandleValid(h) )
+	{
+		lua_pushnil( L );
+		return;
+	}
+
+	const CompiledMetric &m = g_pLoadedThemeData->vMetrics[h.iIndex];
+	switch( m.type )
+	{
+	case CompiledMetric::Number:
+		lua_pushnumber( L, m.fNumber );
+		break;
+	case CompiledMetric::Boolean:
+		lua_pushboolean( L, m.sValue == "true" );
+		break;
+	case CompiledMetric::String:
+		lua_pushlstring( L, m.sValue.data()+1, m.sValue.size()-2 );
+		break;
+	case CompiledMetric::Chunk:
+	{
+		m.chunk.PushSelf( L );
+		if( m.bCommand )
+		{
+			RString sError;
+			if( !LuaHelpers::RunScriptOnStack(L, sError, 0, 1) )
+				LOG->Warn( "Compiling \"%s\": %s", m.sValue.c_str(), sError.c_str() );
+		}
+		else
+		{
+			RString sError = ssprintf( "Lua runtime error parsing \"%s\": ", m.sName.c_str() );
+			LuaHelpers::RunScriptOnStack( L, sError, 0, 1, true );
+		}
+		break;
+	}
+	case CompiledMetric::Uncompiled:
+		if( m.bCommand )
+			LuaHelpers::ParseCommandList( L, m.sValue, m.sName, false );
+		else
+			LuaHelpers::RunExpression( L, m.sValue, m.sName );
+		break;
+	}
+}
+
 void ThemeManager::PushMetric( Lua *L, const RString &sMetricsGroup, const RString &sValueName )
 {
 	if(sMetricsGroup == "" || sValueName == "")
@@ -1104,6 +1322,15 @@ void ThemeManager::PushMetric( Lua *L, const RString &sMetricsGroup, const RStri
 		lua_pushnil(L);
 		return;
 	}
+
+	const MetricHandle h = GetMetricHandle( sMetricsGroup, sValueName );
+	if( IsMetricHandleValid(h) )
+	{
+		PushMetric( L, h );
+		return;
+	}
+
+	// The metric is missing; this reports it.
 	RString sValue = GetMetricRaw( g_pLoadedThemeData->iniMetrics, sMetricsGroup, sValueName );
 
 	RString sName = ssprintf( "%s::%s", sMetricsGroup.c_str(), sValueName.c_str() );
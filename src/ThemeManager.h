@@ -90,6 +90,23 @@ public:
 
 	void	GetMetric( const RString &sMetricsGroup, const RString &sValueName, LuaReference &valueOut );
 
+	/* A metric resolved through its group fallbacks and compiled, so it can be
+	 * pushed again without looking it up.  Handles are invalidated when metrics
+	 * are reloaded. */
+	struct MetricHandle
+	{
+		MetricHandle(): iIndex(-1), iGeneration(0) { }
+		int iIndex;
+		int iGeneration;
+	};
+	/* Returns an invalid handle if the metric doesn't exist. */
+	MetricHandle GetMetricHandle( const RString &sMetricsGroup, const RString &sValueName );
+	bool	IsMetricHandleValid( const MetricHandle &h ) const;
+	void	PushMetric( Lua *L, const MetricHandle &h );
+	/* Whether the metric is a plain number, boolean or string, so reading it
+	 * runs no theme code. */
+	bool	IsMetricConstant( const MetricHandle &h ) const;
+
 	// Languages
 	bool	HasString( const RString &sMetricsGroup, const RString &sValueName );
 	RString	GetString( const RString &sMetricsGroup, const RString &sValueName );
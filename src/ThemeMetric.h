@@ -48,6 +48,8 @@ protected:
 	LuaReference	m_Value;
 	mutable T	m_currentValue;
 	bool		m_bCallEachTime;
+	/** @brief the compiled metric, once it's been looked up. */
+	ThemeManager::MetricHandle	m_Handle;
 
 public:
 	/* Initializing with no group and name is allowed; if you do this, you must
@@ -66,7 +68,8 @@ public:
 		IThemeMetric( cpy ),
 		m_sGroup( cpy.m_sGroup ),
 		m_sName( cpy.m_sName ),
-		m_Value( cpy.m_Value )
+		m_Value( cpy.m_Value ),
+		m_Handle( cpy.m_Handle )
 		// do we transfer the current value or bCallEachTime?
 	{
 		ThemeManager::Subscribe( this );
@@ -84,12 +87,14 @@ public:
 	{
 		m_sGroup = sGroup;
 		m_sName = sName;
+		m_Handle = ThemeManager::MetricHandle();
 		Read();
 	}
 
 	void ChangeGroup( const RString &sGroup )
 	{
 		m_sGroup = sGroup;
+		m_Handle = ThemeManager::MetricHandle();
 		Read();
 	}
 	/**
@@ -98,9 +103,16 @@ public:
 	{
 		if( m_sName != ""  &&  THEME  &&   THEME->IsThemeLoaded() )
 		{
+			if( !THEME->IsMetricHandleValid(m_Handle) )
+				m_Handle = THEME->GetMetricHandle( m_sGroup, m_sName );
+
 			Lua *L = LUA->Get();
-			THEME->GetMetric( m_sGroup, m_sName, m_Value );
-			m_Value.PushSelf(L);
+			if( THEME->IsMetricHandleValid(m_Handle) )
+				THEME->PushMetric( L, m_Handle );
+			else
+				THEME->PushMetric( L, m_sGroup, m_sName );	// reports it missing
+			lua_pushvalue( L, -1 );
+			m_Value.SetFromStack( L );
 			LuaHelpers::FromStack(L, m_currentValue, -1);
 			lua_pop( L, 1 );
 			LUA->Release(L);
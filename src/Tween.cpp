@@ -4,6 +4,9 @@
 #include "RageMath.h"
 #include "LuaManager.h"
 #include "EnumHelper.h"
+#include "RageUtil_SlabAllocator.h"
+
+#include <algorithm>
 
 static const char *TweenTypeNames[] = {
 	"Linear",
@@ -76,6 +79,24 @@ float InterpolateBezier2D::Tween( float f ) const
  * used with Bezier to create spline tweens. */
 // InterpolateCompound
 
+static RageSlabAllocator &GetTweenAllocator()
+{
+	static RageSlabAllocator *pAllocator = new RageSlabAllocator( "ITween",
+		std::max({ sizeof(TweenLinear), sizeof(TweenAccelerate), sizeof(TweenDecelerate),
+			sizeof(TweenSpring), sizeof(InterpolateBezier1D), sizeof(InterpolateBezier2D) }) );
+	return *pAllocator;
+}
+
+void *ITween::operator new( std::size_t iSize )
+{
+	return GetTweenAllocator().Allocate( iSize );
+}
+
+void ITween::operator delete( void *p, std::size_t iSize )
+{
+	GetTweenAllocator().Free( p, iSize );
+}
+
 ITween *ITween::CreateFromType( TweenType tt )
 {
 	switch( tt )
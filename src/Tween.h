@@ -3,6 +3,8 @@
 
 #include "EnumHelper.h"
 
+#include <cstddef>
+
 struct lua_State;
 typedef lua_State Lua;
 
@@ -35,6 +37,10 @@ public:
 
 	static ITween *CreateFromType( TweenType iType );
 	static ITween *CreateFromStack( Lua *L, int iStackPos );
+
+	/* Each tween an actor queues makes one, so they share a slab. */
+	static void *operator new( std::size_t iSize );
+	static void operator delete( void *p, std::size_t iSize );
 };
 
 #endif
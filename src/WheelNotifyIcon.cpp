@@ -8,6 +8,7 @@
 #include "ThemeManager.h"
 
 #include <cmath>
+#include <typeinfo>
 
 /* todo: replace this entire thing with a set of AutoActors and a Scroller.
  * In reality, everything except the Beginner/Training icon can be replicated
@@ -70,6 +71,13 @@ void WheelNotifyIcon::SetFlags( Flags flags )
 	/* Make sure the right icon is selected, since we might be drawn before
 	 * we get another update. */
 	Update(0);
+	MarkUpdateDirty();
+}
+
+/* With more than one icon, Update cycles through them. */
+bool WheelNotifyIcon::IsIdle() const
+{
+	return typeid(*this) == typeid(WheelNotifyIcon) && m_vIconsToShow.size() <= 1 && SpriteIsIdle();
 }
 
 bool WheelNotifyIcon::EarlyAbortDraw() const
@@ -27,6 +27,8 @@ public:
 	virtual bool EarlyAbortDraw() const;
 
 protected:
+	virtual bool IsIdle() const;
+
 	/** @brief What types of icons are available for the Song? */
 	enum Icons
 	{
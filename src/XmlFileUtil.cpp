@@ -8,6 +8,7 @@
 #include "arch/Dialog/Dialog.h"
 #include "LuaManager.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <vector>
 
@@ -526,6 +527,419 @@ bool XmlFileUtil::SaveToFile( const XNode *pNode, const RString &sFile, const RS
 	return SaveToFile( pNode, f, sStylesheet, bWriteTabs );
 }
 
+void XmlFileUtil::XmlVisitor::Captured( XNode *pNode )
+{
+	delete pNode;
+}
+
+namespace
+{
+/* LoadInternal works on the whole file in memory, and builds the whole tree.
+ * This reads the file a block at a time, and only keeps the elements that
+ * are still open. */
+class XmlStreamParser
+{
+public:
+	XmlStreamParser( RageFileBasic &f, XmlFileUtil::XmlVisitor &visitor ):
+		m_File(f), m_Visitor(visitor), m_iPos(0), m_bEOF(false) { }
+	~XmlStreamParser();
+
+	bool Parse( RString &sErrorOut );
+
+private:
+	struct Element
+	{
+		RString sName;
+		XmlFileUtil::XmlElementAction action;
+		XNode *pNode;		// if captured, or inside a captured element
+		RString sText;		// the text before the first tag inside it
+		bool bHaveText;
+		bool bEmptyTag;		// <TAG/>
+	};
+
+	bool Fill();
+	bool Ensure( RString::size_type iBytes );
+	bool Find( const char *szDelim, RString::size_type &iOut );
+	bool ReadTag( RString &sTagOut );
+
+	bool StartElement( const RString &sTag );
+	bool EndElement( const RString &sTag );
+	void CloseElement();
+	void SetError( const RString &sError ) { if( m_sError.empty() ) m_sError = sError; }
+
+	RageFileBasic &m_File;
+	XmlFileUtil::XmlVisitor &m_Visitor;
+
+	/* Unparsed data begins at m_iPos; everything before it is discarded on
+	 * the next Fill. */
+	RString m_sBuf;
+	RString::size_type m_iPos;
+	bool m_bEOF;
+
+	RString m_sError;
+	std::vector<Element> m_Stack;
+	XmlFileUtil::XmlAttributes m_Attrs;
+};
+
+static const int STREAM_BLOCK_SIZE = 64*1024;
+
+XmlStreamParser::~XmlStreamParser()
+{
+	/* On error, free a partly built capture.  Only the bottom one is owned. */
+	for( const Element &el : m_Stack )
+	{
+		if( el.pNode != nullptr )
+		{
+			delete el.pNode;
+			break;
+		}
+	}
+}
+
+// Read another block.  Offsets into m_sBuf are invalidated.
+bool XmlStreamParser::Fill()
+{
+	if( m_bEOF )
+		return false;
+
+	m_sBuf.erase( 0, m_iPos );
+	m_iPos = 0;
+
+	const RString::size_type iOldSize = m_sBuf.size();
+	m_sBuf.resize( iOldSize + STREAM_BLOCK_SIZE );
+	const int iGot = m_File.Read( &m_sBuf[iOldSize], STREAM_BLOCK_SIZE );
+	m_sBuf.resize( iOldSize + std::max(iGot, 0) );
+
+	if( iGot == -1 )
+		SetError( m_File.GetError() );
+	if( iGot <= 0 )
+	{
+		m_bEOF = true;
+		return false;
+	}
+	return true;
+}
+
+// Make sure that iBytes are buffered past m_iPos, if the file has them.
+bool XmlStreamParser::Ensure( RString::size_type iBytes )
+{
+	while( m_sBuf.size() - m_iPos < iBytes )
+		if( !Fill() )
+			return false;
+	return true;
+}
+
+bool XmlStreamParser::Find( const char *szDelim, RString::size_type &iOut )
+{
+	const RString::size_type iDelimLen = strlen( szDelim );
+	RString::size_type iFrom = m_iPos;
+	for(;;)
+	{
+		iOut = m_sBuf.find( szDelim, iFrom );
+		if( iOut != RString::npos )
+			return true;
+
+		// The delimiter may straddle the end of the buffer.
+		RString::size_type iSearched = m_sBuf.size() - m_iPos;
+		iSearched -= std::min( iSearched, iDelimLen-1 );
+		if( !Fill() )
+			return false;
+		iFrom = m_iPos + iSearched;
+	}
+}
+
+/* Read the tag starting at m_iPos, from after the < to before the >, and
+ * move past it. */
+bool XmlStreamParser::ReadTag( RString &sTagOut )
+{
+	char quote = 0;
+	RString::size_type i = m_iPos + 1;
+	for(;;)
+	{
+		if( i == m_sBuf.size() )
+		{
+			const RString::size_type iScanned = i - m_iPos;
+			if( !Fill() )
+				return false;
+			i = m_iPos + iScanned;
+			continue;
+		}
+
+		const char c = m_sBuf[i];
+		if( quote != 0 )
+		{
+			if( c == quote )
+				quote = 0;
+		}
+		else if( c == '"' || c == '\'' )
+			quote = c;
+		else if( c == chXMLTagClose )
+			break;
+		++i;
+	}
+
+	sTagOut.assign( m_sBuf, m_iPos+1, i - (m_iPos+1) );
+	m_iPos = i + 1;
+	return true;
+}
+
+bool XmlStreamParser::StartElement( const RString &sTag )
+{
+	RString::size_type iEnd = sTag.find_first_of( " \t\r\n/" );
+	if( iEnd == RString::npos )
+		iEnd = sTag.size();
+
+	Element el;
+	SetString( sTag, 0, iEnd, &el.sName );
+	el.action = XmlFileUtil::XmlDescend;
+	el.pNode = nullptr;
+	el.bHaveText = false;
+	el.bEmptyTag = false;
+
+	RString::size_type iLast = sTag.find_last_not_of( " \t\r\n" );
+	el.bEmptyTag = iLast != RString::npos && sTag[iLast] == chXMLTagPre;
+
+	const Element *pParent = m_Stack.empty()? nullptr: &m_Stack.back();
+	if( pParent != nullptr && pParent->action == XmlFileUtil::XmlSkip )
+	{
+		el.action = XmlFileUtil::XmlSkip;
+		m_Stack.push_back( el );
+		if( el.bEmptyTag )
+			CloseElement();
+		return true;
+	}
+
+	// Attributes, as LoadAttributes reads them.
+	m_Attrs.clear();
+	RString::size_type iOffset = iEnd;
+	while( iOffset < sTag.size() )
+	{
+		tcsskip( sTag, iOffset );
+		if( iOffset >= sTag.size() || sTag[iOffset] == chXMLTagPre || sTag[iOffset] == chXMLQuestion )
+			break;
+
+		iEnd = sTag.find_first_of( " =", iOffset );
+		if( iEnd == RString::npos )
+		{
+			SetError( ssprintf("<%s> attribute has error ", el.sName.c_str()) );
+			return false;
+		}
+
+		m_Attrs.push_back( std::make_pair(RString(), RString()) );
+		RString &sName = m_Attrs.back().first, &sValue = m_Attrs.back().second;
+		SetString( sTag, iOffset, iEnd, &sName );
+		iOffset = iEnd;
+
+		tcsskip( sTag, iOffset );
+		if( iOffset >= sTag.size() || sTag[iOffset] != '=' )
+			continue;
+
+		++iOffset;
+		tcsskip( sTag, iOffset );
+		if( iOffset >= sTag.size() )
+			break;
+
+		const char quote = sTag[iOffset];
+		if( quote == '"' || quote == '\'' )
+		{
+			++iOffset;
+			iEnd = sTag.find( quote, iOffset );
+			if( iEnd == RString::npos )
+			{
+				SetError( ssprintf("<%s> attribute text: couldn't find matching quote", sName.c_str()) );
+				return false;
+			}
+		}
+		else
+		{
+			iEnd = std::min( sTag.find(' ', iOffset), sTag.size() );
+		}
+
+		SetString( sTag, iOffset, iEnd, &sValue, true );
+		ReplaceEntityText( sValue, g_mapEntitiesToChars );
+		iOffset = iEnd;
+		if( quote == '"' || quote == '\'' )
+			++iOffset;
+	}
+
+	if( pParent != nullptr && pParent->pNode != nullptr )
+	{
+		el.action = XmlFileUtil::XmlCapture;
+		el.pNode = pParent->pNode->AppendChild( el.sName );
+	}
+	else
+	{
+		el.action = m_Visitor.StartElement( el.sName, m_Attrs );
+		if( el.action == XmlFileUtil::XmlCapture )
+			el.pNode = new XNode( el.sName );
+	}
+
+	if( el.pNode != nullptr )
+	{
+		for( const std::pair<RString,RString> &attr : m_Attrs )
+			el.pNode->AppendAttr( attr.first, attr.second );
+	}
+
+	m_Stack.push_back( el );
+	if( el.bEmptyTag )
+		CloseElement();
+	return true;
+}
+
+bool XmlStreamParser::EndElement( const RString &sTag )
+{
+	RString sName;
+	RString::size_type iStart = 1;	// skip the /
+	tcsskip( sTag, iStart );
+	if( iStart == RString::npos )
+		iStart = sTag.size();
+	RString::size_type iEnd = std::min( sTag.find(' ', iStart), sTag.size() );
+	SetString( sTag, iStart, iEnd, &sName );
+
+	if( m_Stack.empty() )
+	{
+		SetError( ssprintf("</%s> has no matching open tag", sName.c_str()) );
+		return false;
+	}
+
+	if( sName != m_Stack.back().sName )
+	{
+		SetError( ssprintf("'<%s> ... </%s>' is not well-formed.", m_Stack.back().sName.c_str(), sName.c_str()) );
+		return false;
+	}
+
+	CloseElement();
+	return true;
+}
+
+void XmlStreamParser::CloseElement()
+{
+	Element &el = m_Stack.back();
+	switch( el.action )
+	{
+	case XmlFileUtil::XmlSkip:
+		break;
+	case XmlFileUtil::XmlDescend:
+		m_Visitor.EndElement( el.sName, el.sText );
+		break;
+	case XmlFileUtil::XmlCapture:
+		// Like LoadInternal, <TAG/> has no text attribute at all.
+		if( !el.bEmptyTag )
+			el.pNode->AppendAttr( XNode::TEXT_ATTRIBUTE, el.sText );
+
+		// Only the outermost captured element is handed over; the rest
+		// belong to it.
+		if( m_Stack.size() == 1 || m_Stack[m_Stack.size()-2].pNode == nullptr )
+		{
+			XNode *pNode = el.pNode;
+			m_Stack.pop_back();
+			m_Visitor.Captured( pNode );
+			return;
+		}
+		break;
+	default:
+		FAIL_M( ssprintf("Invalid XmlElementAction: %i", el.action) );
+	}
+	m_Stack.pop_back();
+}
+
+bool XmlStreamParser::Parse( RString &sErrorOut )
+{
+	InitEntities();
+	bool bSeenRoot = false;
+
+	for(;;)
+	{
+		// Text up to the next tag.
+		RString::size_type iTag;
+		const bool bFoundTag = Find( "<", iTag );
+		if( !bFoundTag )
+			iTag = m_sBuf.size();
+
+		if( !m_Stack.empty() && !m_Stack.back().bHaveText )
+		{
+			Element &el = m_Stack.back();
+			el.bHaveText = true;
+			if( el.action != XmlFileUtil::XmlSkip )
+			{
+				SetString( m_sBuf, m_iPos, iTag, &el.sText, true );
+				ReplaceEntityText( el.sText, g_mapEntitiesToChars );
+			}
+		}
+		m_iPos = iTag;
+
+		if( !bFoundTag )
+		{
+			if( !m_Stack.empty() )
+				SetError( ssprintf("%s must be closed with </%s>", m_Stack.back().sName.c_str(), m_Stack.back().sName.c_str()) );
+			else if( !bSeenRoot )
+				SetError( "No root element" );
+			break;
+		}
+
+		Ensure( 4 );
+		if( !m_sBuf.compare(m_iPos+1, 3, "!--") )
+		{
+			RString::size_type iEnd;
+			if( !Find("-->", iEnd) )
+			{
+				SetError( "Unterminated comment" );
+				break;
+			}
+			m_iPos = iEnd + 3;
+			continue;
+		}
+
+		RString sTag;
+		if( !ReadTag(sTag) )
+		{
+			SetError( "Element must be closed." );
+			break;
+		}
+
+		// Meta tags: <?xml ... ?>, <!DOCTYPE ...>
+		if( sTag.empty() || sTag[0] == chXMLQuestion || sTag[0] == chXMLExclamation )
+			continue;
+
+		if( sTag[0] == chXMLTagPre )
+		{
+			if( !EndElement(sTag) )
+				break;
+		}
+		else
+		{
+			bSeenRoot = true;
+			if( !StartElement(sTag) )
+				break;
+		}
+
+		// Anything after the root element is ignored.
+		if( bSeenRoot && m_Stack.empty() )
+			break;
+	}
+
+	sErrorOut = m_sError;
+	return m_sError.empty();
+}
+}
+
+bool XmlFileUtil::LoadStream( RageFileBasic &f, XmlVisitor &visitor, RString &sErrorOut )
+{
+	XmlStreamParser parser( f, visitor );
+	return parser.Parse( sErrorOut );
+}
+
+bool XmlFileUtil::LoadStreamShowErrors( RageFileBasic &f, XmlVisitor &visitor )
+{
+	RString sError;
+	if( LoadStream(f, visitor, sError) )
+		return true;
+
+	RString sWarning = ssprintf( "XML: LoadFromFile failed: %s", sError.c_str() );
+	LuaHelpers::ReportScriptError(sWarning, "XML_PARSE_ERROR");
+	return false;
+}
+
 #include "LuaReference.h"
 class XNodeLuaValue: public XNodeValue
 {
@@ -1,6 +1,9 @@
 #ifndef XML_FILE_UTIL_H
 #define XML_FILE_UTIL_H
 
+#include <utility>
+#include <vector>
+
 class RageFileBasic;
 class XNode;
 struct lua_State;
@@ -26,6 +29,40 @@ namespace XmlFileUtil
 	XNode *XNodeFromTable( lua_State *L );
 
 	void MergeIniUnder( XNode *pFrom, XNode *pTo );
+
+	/* Attributes of an element, in the order they appear. */
+	typedef std::vector<std::pair<RString,RString> > XmlAttributes;
+
+	/* What LoadStream does with the contents of an element. */
+	enum XmlElementAction
+	{
+		XmlDescend,	// pass its children to the visitor, too
+		XmlSkip,	// ignore it
+		XmlCapture	// build it into an XNode tree, and pass that to Captured
+	};
+
+	class XmlVisitor
+	{
+	public:
+		virtual ~XmlVisitor() { }
+
+		/* Called at the start of each element that isn't inside a skipped
+		 * or captured one. */
+		virtual XmlElementAction StartElement( const RString &sName, const XmlAttributes &attrs ) = 0;
+
+		/* Called at the end of each element that was descended into, with
+		 * its text, as an XNode would have it. */
+		virtual void EndElement( const RString &sName, const RString &sText ) { }
+
+		/* Called with each captured element, which the visitor then owns. */
+		virtual void Captured( XNode *pNode );
+	};
+
+	/* Parse XML from f a block at a time, without building a tree of the
+	 * whole file, so that huge files like Stats.xml can be loaded with
+	 * little memory.  Accepts the same XML as Load. */
+	bool LoadStream( RageFileBasic &f, XmlVisitor &visitor, RString &sErrorOut );
+	bool LoadStreamShowErrors( RageFileBasic &f, XmlVisitor &visitor );
 }
 
 #endif
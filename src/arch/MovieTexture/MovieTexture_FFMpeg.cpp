@@ -6,10 +6,20 @@
 #include "RageUtil.h"
 #include "RageFile.h"
 #include "RageSurface.h"
+#include "RageUtil_ThreadPool.h"
+#include "Preference.h"
 
 #include <cerrno>
 #include <cstddef>
 #include <cstdint>
+#include <future>
+
+/* Threads used by FFmpeg's frame and slice threading; 0 lets it decide. */
+static Preference<int> g_iMovieDecodeThreads( "MovieDecodeThreads", 0 );
+
+/* Frames with at least this many pixels are color converted on several threads. */
+static const int PARALLEL_CONVERSION_MIN_PIXELS = 1280*720;
+static const int MAX_CONVERSION_BANDS = 4;
 
 static void FixLilEndian()
 {
@@ -44,7 +54,7 @@ static void FixLilEndian()
 	}
 }
 
-static int FindCompatibleAVFormat( bool bHighColor )
+static int FindCompatibleAVFormat( bool bHighColor, int iWidth, int iHeight )
 {
 	for( int i = 0; AVPixelFormats[i].bpp; ++i )
 	{
@@ -54,6 +64,11 @@ static int FindCompatibleAVFormat( bool bHighColor )
 			EffectMode em = MovieTexture_Generic::GetEffectMode( fmt.YUV );
 			if( !DISPLAY->IsEffectModeSupported(em) )
 				continue;
+
+			/* NV12 packs four luma samples to a texel, and the chroma plane
+			 * has to line up with it. */
+			if( fmt.YUV == PixelFormatYCbCr_NV12 && (iWidth % 8 != 0 || iHeight % 2 != 0) )
+				continue;
 		}
 		else if( fmt.bHighColor != bHighColor )
 		{
@@ -81,16 +96,17 @@ RageSurface *RageMovieTextureDriver_FFMpeg::AVCodecCreateCompatibleSurface( int
 {
 	FixLilEndian();
 
-	int iAVTexfmtIndex = FindCompatibleAVFormat( bPreferHighColor );
+	int iAVTexfmtIndex = FindCompatibleAVFormat( bPreferHighColor, iTextureWidth, iTextureHeight );
 	if( iAVTexfmtIndex == -1 )
-		iAVTexfmtIndex = FindCompatibleAVFormat( !bPreferHighColor );
+		iAVTexfmtIndex = FindCompatibleAVFormat( !bPreferHighColor, iTextureWidth, iTextureHeight );
 
 	if( iAVTexfmtIndex == -1 )
 	{
 		/* No dice.  Use the first avcodec format of the preferred bit depth,
 		 * and let the display system convert. */
 		for( iAVTexfmtIndex = 0; AVPixelFormats[iAVTexfmtIndex].bpp; ++iAVTexfmtIndex )
-			if( AVPixelFormats[iAVTexfmtIndex].bHighColor == bPreferHighColor )
+			if( AVPixelFormats[iAVTexfmtIndex].YUV == PixelFormatYCbCr_Invalid &&
+			    AVPixelFormats[iAVTexfmtIndex].bHighColor == bPreferHighColor )
 				break;
 		ASSERT( AVPixelFormats[iAVTexfmtIndex].bpp != 0 );
 	}
@@ -104,6 +120,11 @@ RageSurface *RageMovieTextureDriver_FFMpeg::AVCodecCreateCompatibleSurface( int
 
 	if( pfd->YUV == PixelFormatYCbCr_YUYV422 )
 		iTextureWidth /= 2;
+	if( pfd->YUV == PixelFormatYCbCr_NV12 )
+	{
+		iTextureWidth /= 4;
+		iTextureHeight += iTextureHeight / 2;
+	}
 
 	return CreateSurface( iTextureWidth, iTextureHeight, pfd->bpp,
 		pfd->masks[0], pfd->masks[1], pfd->masks[2], pfd->masks[3] );
@@ -117,6 +138,7 @@ MovieDecoder_FFMpeg::MovieDecoder_FFMpeg()
 	m_pStream = nullptr;
 	m_iCurrentPacketOffset = -1;
 	m_Frame = avcodec::av_frame_alloc();
+	m_pConvertPool = nullptr;
 
 	Init();
 }
@@ -128,11 +150,9 @@ MovieDecoder_FFMpeg::~MovieDecoder_FFMpeg()
 		avcodec::av_packet_unref( &m_Packet );
 		m_iCurrentPacketOffset = -1;
 	}
-	if (m_swsctx)
-	{
-		avcodec::sws_freeContext(m_swsctx);
-		m_swsctx = nullptr;
-	}
+	FreeConversion();
+	delete m_pConvertPool;
+	m_pConvertPool = nullptr;
 	if (m_avioContext != nullptr )
 	{
 		RageFile *file = (RageFile *)m_avioContext->opaque;
@@ -339,32 +359,152 @@ int MovieDecoder_FFMpeg::DecodePacket( float fTargetTime )
 	return 0; /* packet done */
 }
 
+void MovieDecoder_FFMpeg::FreeConversion()
+{
+	if (m_swsctx)
+	{
+		avcodec::sws_freeContext(m_swsctx);
+		m_swsctx = nullptr;
+	}
+	for( ConversionBand &band : m_ConversionBands )
+		avcodec::sws_freeContext( band.pContext );
+	m_ConversionBands.clear();
+}
+
+/* Find where each plane of a frame of iHeight rows goes in pSurface.  Everything
+ * but NV12 is a single packed plane. */
+static void GetOutputPlanes( RageSurface *pSurface, int iHeight, avcodec::AVPixelFormat fmt,
+	std::uint8_t *pData[4], int iLinesize[4] )
+{
+	for( int i = 0; i < 4; ++i )
+	{
+		pData[i] = nullptr;
+		iLinesize[i] = 0;
+	}
+
+	pData[0] = (std::uint8_t *) pSurface->pixels;
+	iLinesize[0] = pSurface->pitch;
+	if( fmt == avcodec::AV_PIX_FMT_NV12 )
+	{
+		pData[1] = pData[0] + iHeight * pSurface->pitch;
+		iLinesize[1] = pSurface->pitch;
+	}
+}
+
+void MovieDecoder_FFMpeg::InitConversion()
+{
+	const avcodec::AVPixFmtDescriptor *pDesc = avcodec::av_pix_fmt_desc_get( m_pStreamCodec->pix_fmt );
+	const avcodec::AVPixFmtDescriptor *pOutDesc = avcodec::av_pix_fmt_desc_get( m_AVTexfmt );
+
+	/* Bands have to start on a chroma row.  Paletted and bitstream formats
+	 * can't be split by offsetting plane pointers. */
+	int iBands = 1;
+	if( pDesc != nullptr &&
+	    !(pDesc->flags & (AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BITSTREAM)) &&
+	    GetWidth() * GetHeight() >= PARALLEL_CONVERSION_MIN_PIXELS )
+	{
+		iBands = std::min( RageThreadPool::GetDefaultThreadCount(), MAX_CONVERSION_BANDS );
+	}
+
+	if( iBands > 1 )
+	{
+		const int iRowAlign = 1 << std::max( pDesc->log2_chroma_h, pOutDesc->log2_chroma_h );
+		const int iRowsPerBand = (GetHeight() / iBands) / iRowAlign * iRowAlign;
+		for( int i = 0; i < iBands; ++i )
+		{
+			ConversionBand band;
+			band.iStartRow = i * iRowsPerBand;
+			band.iRows = (i == iBands-1)? GetHeight() - band.iStartRow: iRowsPerBand;
+			band.pContext = avcodec::sws_getContext(
+				GetWidth(), band.iRows, m_pStreamCodec->pix_fmt,
+				GetWidth(), band.iRows, m_AVTexfmt,
+				sws_flags, nullptr, nullptr, nullptr );
+			if( band.pContext == nullptr )
+			{
+				FreeConversion();
+				iBands = 1;
+				break;
+			}
+			m_ConversionBands.push_back( band );
+		}
+	}
+
+	if( iBands > 1 )
+	{
+		if( m_pConvertPool == nullptr )
+			m_pConvertPool = new RageThreadPool( "Movie conversion", iBands - 1 );
+		LOG->Trace( "Converting %ix%i frames in %i bands", GetWidth(), GetHeight(), iBands );
+		return;
+	}
+
+	m_swsctx = avcodec::sws_getCachedContext( m_swsctx,
+			GetWidth(), GetHeight(), m_pStreamCodec->pix_fmt,
+			GetWidth(), GetHeight(), m_AVTexfmt,
+			sws_flags, nullptr, nullptr, nullptr );
+	if( m_swsctx == nullptr )
+		LOG->Warn("Cannot initialize sws conversion context for (%d,%d) %d->%d", GetWidth(), GetHeight(), m_pStreamCodec->pix_fmt, m_AVTexfmt);
+}
+
+void MovieDecoder_FFMpeg::ConvertBand( int iBand, RageSurface *pOut )
+{
+	const ConversionBand &band = m_ConversionBands[iBand];
+	const avcodec::AVPixFmtDescriptor *pDesc = avcodec::av_pix_fmt_desc_get( m_pStreamCodec->pix_fmt );
+	const avcodec::AVPixFmtDescriptor *pOutDesc = avcodec::av_pix_fmt_desc_get( m_AVTexfmt );
+
+	/* Point each plane at the band's first row.  Only the chroma planes are
+	 * subsampled vertically. */
+	const std::uint8_t *pSrc[AV_NUM_DATA_POINTERS] = { nullptr };
+	for( int i = 0; i < AV_NUM_DATA_POINTERS && m_Frame->data[i] != nullptr; ++i )
+	{
+		const int iRow = (i == 1 || i == 2)? band.iStartRow >> pDesc->log2_chroma_h: band.iStartRow;
+		pSrc[i] = m_Frame->data[i] + iRow * m_Frame->linesize[i];
+	}
+
+	std::uint8_t *pDst[4];
+	int iDstStride[4];
+	GetOutputPlanes( pOut, GetHeight(), m_AVTexfmt, pDst, iDstStride );
+	for( int i = 0; i < 4 && pDst[i] != nullptr; ++i )
+	{
+		const int iRow = (i == 1 || i == 2)? band.iStartRow >> pOutDesc->log2_chroma_h: band.iStartRow;
+		pDst[i] += iRow * iDstStride[i];
+	}
+
+	avcodec::sws_scale( band.pContext,
+			pSrc, m_Frame->linesize, 0, band.iRows,
+			pDst, iDstStride );
+}
+
 void MovieDecoder_FFMpeg::GetFrame( RageSurface *pSurface )
 {
-	avcodec::AVFrame pict;
-	pict.data[0] = (unsigned char *) pSurface->pixels;
-	pict.linesize[0] = pSurface->pitch;
+	std::uint8_t *pDst[4];
+	int iDstStride[4];
+	GetOutputPlanes( pSurface, GetHeight(), m_AVTexfmt, pDst, iDstStride );
 
 	/* XXX 1: Do this in one of the Open() methods instead?
 	 * XXX 2: The problem of doing this in Open() is that m_AVTexfmt is not
 	 * already initialized with its correct value.
 	 */
-	if( m_swsctx == nullptr )
+	if( m_swsctx == nullptr && m_ConversionBands.empty() )
 	{
-		m_swsctx = avcodec::sws_getCachedContext( m_swsctx,
-				GetWidth(), GetHeight(), m_pStreamCodec->pix_fmt,
-				GetWidth(), GetHeight(), m_AVTexfmt,
-				sws_flags, nullptr, nullptr, nullptr );
-		if( m_swsctx == nullptr )
-		{
-			LOG->Warn("Cannot initialize sws conversion context for (%d,%d) %d->%d", GetWidth(), GetHeight(), m_pStreamCodec->pix_fmt, m_AVTexfmt);
+		InitConversion();
+		if( m_swsctx == nullptr && m_ConversionBands.empty() )
 			return;
-		}
+	}
+
+	if( !m_ConversionBands.empty() )
+	{
+		std::vector<std::future<void>> vJobs;
+		for( int i = 1; i < (int) m_ConversionBands.size(); ++i )
+			vJobs.push_back( m_pConvertPool->Submit( [this, i, pSurface]() { ConvertBand( i, pSurface ); } ) );
+		ConvertBand( 0, pSurface );
+		for( std::future<void> &job : vJobs )
+			job.get();
+		return;
 	}
 
 	avcodec::sws_scale( m_swsctx,
 			m_Frame->data, m_Frame->linesize, 0, GetHeight(),
-			pict.data, pict.linesize );
+			pDst, iDstStride );
 }
 
 static RString averr_ssprintf( int err, const char *fmt, ... )
@@ -475,6 +615,11 @@ RString MovieDecoder_FFMpeg::OpenCodec()
 	m_pStreamCodec->idct_algo         = FF_IDCT_AUTO;
 	m_pStreamCodec->error_concealment = 3;
 
+	/* Frame threading adds a few frames of latency, which the decode queue
+	 * in MovieTexture_Generic absorbs. */
+	m_pStreamCodec->thread_count      = std::max( g_iMovieDecodeThreads.Get(), 0 );
+	m_pStreamCodec->thread_type       = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
 	LOG->Trace("Opening codec %s", pCodec->name );
 
 	int ret = avcodec::avcodec_open2( m_pStreamCodec, pCodec, nullptr );
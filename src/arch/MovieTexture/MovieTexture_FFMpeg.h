@@ -6,8 +6,10 @@
 #include "MovieTexture_Generic.h"
 
 #include <cstdint>
+#include <vector>
 
 struct RageSurface;
+class RageThreadPool;
 
 namespace avcodec
 {
@@ -64,6 +66,9 @@ private:
 	RString OpenCodec();
 	int ReadPacket();
 	int DecodePacket( float fTargetTime );
+	void InitConversion();
+	void FreeConversion();
+	void ConvertBand( int iBand, RageSurface *pOut );
 
 	avcodec::AVStream *m_pStream;
 	avcodec::AVFrame *m_Frame;
@@ -71,6 +76,17 @@ private:
 	avcodec::SwsContext *m_swsctx;
 	avcodec::AVCodecContext *m_pStreamCodec;
 
+	/* Large frames are converted in horizontal bands, each with its own
+	 * context, in parallel on m_pConvertPool.  m_swsctx is used when there's
+	 * only one band. */
+	struct ConversionBand
+	{
+		avcodec::SwsContext *pContext;
+		int iStartRow, iRows;
+	};
+	std::vector<ConversionBand> m_ConversionBands;
+	RageThreadPool *m_pConvertPool;
+
 	avcodec::AVFormatContext *m_fctx;
 	float m_fTimestamp;
 	float m_fTimestampOffset;
@@ -99,6 +115,17 @@ static struct AVPixelFormat_t
 	bool bByteSwapOnLittleEndian;
 	MovieDecoderPixelFormatYCbCr YUV;
 } AVPixelFormats[] = {
+	{
+		32,
+		{ 0xFF000000,
+		  0x00FF0000,
+		  0x0000FF00,
+		  0x000000FF },
+		avcodec::AV_PIX_FMT_NV12,
+		false, /* N/A */
+		true,
+		PixelFormatYCbCr_NV12,
+	},
 	{
 		32,
 		{ 0xFF000000,
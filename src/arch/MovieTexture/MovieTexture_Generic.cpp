@@ -1,5 +1,6 @@
 #include "global.h"
 #include "MovieTexture_Generic.h"
+#include "ActorMultiTexture.h"
 #include "PrefsManager.h"
 #include "RageDisplay.h"
 #include "RageLog.h"
@@ -20,8 +21,13 @@
 
 static Preference<bool> g_bMovieTextureDirectUpdates( "MovieTextureDirectUpdates", true );
 
+/* The number of frames to decode ahead on a separate thread.  0 decodes
+ * synchronously in DecodeSeconds. */
+static Preference<int> g_iMovieDecodeQueueDepth( "MovieDecodeQueueDepth", 4 );
+
 MovieTexture_Generic::MovieTexture_Generic( RageTextureID ID, MovieDecoder *pDecoder ):
-	RageMovieTexture( ID )
+	RageMovieTexture( ID ),
+	m_FrameQueueEvent( "MovieTexture frame queue" )
 {
 	LOG->Trace( "MovieTexture_Generic::MovieTexture_Generic(%s)", ID.filename.c_str() );
 
@@ -39,6 +45,12 @@ MovieTexture_Generic::MovieTexture_Generic( RageTextureID ID, MovieDecoder *pDec
 	m_fClock = 0;
 	m_bFrameSkipMode = false;
 	m_pSprite = new Sprite;
+	m_pChromaTexture = nullptr;
+	m_pPlanes = new ActorMultiTexture;
+	m_State = DECODER_QUIT;
+	m_iRewindGeneration = 0;
+	m_bDecoderFinished = false;
+	m_iDroppedFrames = 0;
 }
 
 RString MovieTexture_Generic::Init()
@@ -68,6 +80,9 @@ RString MovieTexture_Generic::Init()
 
 	UpdateFrame();
 
+	if( g_iMovieDecodeQueueDepth > 0 )
+		StartDecodingThread( g_iMovieDecodeQueueDepth );
+
 	CHECKPOINT_M("Generic initialization completed. No errors found.");
 
 	return RString();
@@ -75,11 +90,18 @@ RString MovieTexture_Generic::Init()
 
 MovieTexture_Generic::~MovieTexture_Generic()
 {
+	StopDecodingThread();
+
+	if( m_iDroppedFrames > 0 )
+		LOG->Trace( "%s: dropped %i decoded frames", GetID().filename.c_str(), m_iDroppedFrames );
+
 	if( m_pDecoder )
 		m_pDecoder->Close();
 
-	/* m_pSprite may reference the texture; delete it before DestroyTexture. */
+	/* m_pSprite and m_pPlanes may reference the textures; delete them before
+	 * DestroyTexture. */
 	delete m_pSprite;
+	delete m_pPlanes;
 
 	DestroyTexture();
 
@@ -106,6 +128,8 @@ void MovieTexture_Generic::DestroyTexture()
 	m_pRenderTarget = nullptr;
 	delete m_pTextureIntermediate;
 	m_pTextureIntermediate = nullptr;
+	delete m_pChromaTexture;
+	m_pChromaTexture = nullptr;
 }
 
 class RageMovieTexture_Generic_Intermediate : public RageTexture
@@ -181,6 +205,8 @@ void MovieTexture_Generic::Invalidate()
 	m_uTexHandle = 0;
 	if( m_pTextureIntermediate != nullptr )
 		m_pTextureIntermediate->Invalidate();
+	if( m_pChromaTexture != nullptr )
+		m_pChromaTexture->Invalidate();
 }
 
 void MovieTexture_Generic::CreateTexture()
@@ -213,11 +239,14 @@ void MovieTexture_Generic::CreateTexture()
 	if( m_pSurface == nullptr )
 	{
 		ASSERT( m_pTextureLock == nullptr );
-		if( g_bMovieTextureDirectUpdates )
-			m_pTextureLock = DISPLAY->CreateTextureLock();
-
 		m_pSurface = m_pDecoder->CreateCompatibleSurface( m_iImageWidth, m_iImageHeight,
 			TEXTUREMAN->GetPrefs().m_iMovieColorDepth == 32, fmt );
+
+		/* A lock maps a single texture, and NV12 frames go to two.  They're
+		 * uploaded straight from m_pSurface instead. */
+		if( g_bMovieTextureDirectUpdates && fmt != PixelFormatYCbCr_NV12 )
+			m_pTextureLock = DISPLAY->CreateTextureLock();
+
 		if( m_pTextureLock != nullptr )
 		{
 			delete [] m_pSurface->pixels;
@@ -262,6 +291,56 @@ void MovieTexture_Generic::CreateTexture()
 		}
 	}
 
+	if( fmt == PixelFormatYCbCr_NV12 )
+	{
+		m_pPlanes->ClearTextures();
+		SAFE_DELETE( m_pTextureIntermediate );
+		SAFE_DELETE( m_pChromaTexture );
+
+		RenderTargetParam param;
+		param.iWidth = m_iImageWidth;
+		param.iHeight = m_iImageHeight;
+
+		RageTextureID TargetID( GetID() );
+		TargetID.filename += " target";
+		m_pRenderTarget = new RageTextureRenderTarget( TargetID, param );
+
+		/* The surface is the luma plane with the chroma plane below it, half
+		 * as tall.  Both planes are the same number of texels wide. */
+		const int iLumaHeight = m_pSurface->h * 2 / 3;
+		const int iChromaHeight = iLumaHeight / 2;
+
+		RageTextureID LumaID( GetID() );
+		LumaID.filename += " luma";
+		m_pTextureIntermediate = new RageMovieTexture_Generic_Intermediate( LumaID,
+			m_pDecoder->GetWidth(), m_pDecoder->GetHeight(),
+			m_pSurface->w, iLumaHeight,
+			power_of_two(m_pSurface->w), power_of_two(iLumaHeight),
+			*m_pSurface->format, pixfmt );
+
+		RageTextureID ChromaID( GetID() );
+		ChromaID.filename += " chroma";
+		m_pChromaTexture = new RageMovieTexture_Generic_Intermediate( ChromaID,
+			m_pDecoder->GetWidth(), m_pDecoder->GetHeight() / 2,
+			m_pSurface->w, iChromaHeight,
+			power_of_two(m_pSurface->w), power_of_two(iChromaHeight),
+			*m_pSurface->format, pixfmt );
+
+		/* The chroma texture is exactly half as tall as the luma texture, so
+		 * the same texture coordinates address both. */
+		m_pPlanes->AddTexture( m_pTextureIntermediate );
+		m_pPlanes->AddTexture( m_pChromaTexture );
+		m_pPlanes->SetTextureCoords( RectF(0, 0,
+			m_pTextureIntermediate->GetImageWidth() / (float) m_pTextureIntermediate->GetTextureWidth(),
+			m_pTextureIntermediate->GetImageHeight() / (float) m_pTextureIntermediate->GetTextureHeight()) );
+		m_pPlanes->SetWidth( (float) m_pDecoder->GetWidth() );
+		m_pPlanes->SetHeight( (float) m_pDecoder->GetHeight() );
+		m_pPlanes->SetXY( m_pDecoder->GetWidth() / 2.0f, m_pDecoder->GetHeight() / 2.0f );
+		m_pPlanes->SetEffectMode( GetEffectMode(fmt) );
+
+		return;
+	}
+
 	if( fmt != PixelFormatYCbCr_Invalid )
 	{
 		SAFE_DELETE( m_pTextureIntermediate );
@@ -415,6 +494,37 @@ float MovieTexture_Generic::CheckFrameTime()
 /* Decode data. */
 void MovieTexture_Generic::DecodeSeconds( float fSeconds )
 {
+	if( m_DecodingThread.IsCreated() )
+	{
+		/* Take the newest frame that's due.  Anything older than it was
+		 * decoded too late to be seen; drop it. */
+		RageSurface *pFrame = nullptr;
+		m_FrameQueueEvent.Lock();
+		m_fClock += fSeconds * m_fRate;
+		while( !m_FrameQueue.empty() && m_FrameQueue.front().fTimestamp <= m_fClock )
+		{
+			if( pFrame != nullptr )
+			{
+				m_vpFreeSurfaces.push_back( pFrame );
+				++m_iDroppedFrames;
+			}
+			pFrame = m_FrameQueue.front().pSurface;
+			m_FrameQueue.pop_front();
+		}
+		m_FrameQueueEvent.Unlock();
+
+		if( pFrame == nullptr )
+			return;
+
+		UpdateFrameFromSurface( pFrame );
+
+		m_FrameQueueEvent.Lock();
+		m_vpFreeSurfaces.push_back( pFrame );
+		m_FrameQueueEvent.Signal();
+		m_FrameQueueEvent.Unlock();
+		return;
+	}
+
 	m_fClock += fSeconds * m_fRate;
 
 	/* We might need to decode more than one frame per update.  However, there
@@ -460,18 +570,68 @@ void MovieTexture_Generic::UpdateFrame()
 	if( m_pTextureLock != nullptr )
 		m_pTextureLock->Unlock( m_pSurface, true );
 
-	if( m_pRenderTarget != nullptr )
+	FinishFrameUpdate( m_pSurface, m_pTextureLock != nullptr );
+}
+
+/* Like UpdateFrame, but with a frame that the decoding thread already converted.
+ * Copying it into m_pTextureLock would only add a pass over the frame, so it's
+ * always uploaded from where it is. */
+void MovieTexture_Generic::UpdateFrameFromSurface( RageSurface *pFrame )
+{
+	/* Just in case we were invalidated: */
+	CreateTexture();
+
+	FinishFrameUpdate( pFrame, false );
+}
+
+/* Upload both planes of an NV12 frame. */
+void MovieTexture_Generic::UploadPlanes( RageSurface *pFrame )
+{
+	const int iLumaHeight = m_pTextureIntermediate->GetImageHeight();
+	const int iChromaHeight = m_pChromaTexture->GetImageHeight();
+
+	DISPLAY->UpdateTexture(
+		m_pTextureIntermediate->GetTexHandle(),
+		pFrame,
+		0, 0,
+		pFrame->w, iLumaHeight );
+
+	/* Point the surface at the chroma plane, rather than copying it out. */
+	std::uint8_t *pPixels = pFrame->pixels;
+	pFrame->pixels = pPixels + iLumaHeight * pFrame->pitch;
+	DISPLAY->UpdateTexture(
+		m_pChromaTexture->GetTexHandle(),
+		pFrame,
+		0, 0,
+		pFrame->w, iChromaHeight );
+	pFrame->pixels = pPixels;
+}
+
+/* Upload pFrame, unless it was already written through m_pTextureLock, and
+ * run the render target pass for YUV formats. */
+void MovieTexture_Generic::FinishFrameUpdate( RageSurface *pFrame, bool bUploaded )
+{
+	if( m_pChromaTexture != nullptr )
+	{
+		CHECKPOINT_M( "About to upload the planes.");
+
+		UploadPlanes( pFrame );
+		m_pRenderTarget->BeginRenderingTo( false );
+		m_pPlanes->Draw();
+		m_pRenderTarget->FinishRenderingTo();
+	}
+	else if( m_pRenderTarget != nullptr )
 	{
 		CHECKPOINT_M( "About to upload the texture.");
 
 		/* If we have no m_pTextureLock, we still have to upload the texture. */
-		if( m_pTextureLock == nullptr )
+		if( !bUploaded )
 		{
 			DISPLAY->UpdateTexture(
 				m_pTextureIntermediate->GetTexHandle(),
-				m_pSurface,
+				pFrame,
 				0, 0,
-				m_pSurface->w, m_pSurface->h );
+				pFrame->w, pFrame->h );
 		}
 		m_pRenderTarget->BeginRenderingTo( false );
 		m_pSprite->Draw();
@@ -479,20 +639,137 @@ void MovieTexture_Generic::UpdateFrame()
 	}
 	else
 	{
-		if( m_pTextureLock == nullptr )
+		if( !bUploaded )
 		{
 			DISPLAY->UpdateTexture(
 				m_uTexHandle,
-				m_pSurface,
+				pFrame,
 				0, 0,
 				m_iImageWidth, m_iImageHeight );
 		}
 	}
 }
 
+void MovieTexture_Generic::StartDecodingThread( int iQueueDepth )
+{
+	ASSERT( !m_DecodingThread.IsCreated() );
+
+	/* Queue surfaces have the same format as m_pSurface, which may not own
+	 * any pixels of its own if we're using m_pTextureLock. */
+	const RageSurfaceFormat &fmt = m_pSurface->fmt;
+	for( int i = 0; i < iQueueDepth; ++i )
+	{
+		m_vpFreeSurfaces.push_back( CreateSurface( m_pSurface->w, m_pSurface->h, fmt.BitsPerPixel,
+			fmt.Mask[0], fmt.Mask[1], fmt.Mask[2], fmt.Mask[3] ) );
+	}
+
+	m_State = DECODER_RUNNING;
+	m_bDecoderFinished = false;
+	m_DecodingThread.SetName( "MovieTexture decoder (" + GetID().filename + ")" );
+	m_DecodingThread.Create( DecodingThread_Start, this );
+}
+
+void MovieTexture_Generic::StopDecodingThread()
+{
+	if( !m_DecodingThread.IsCreated() )
+		return;
+
+	m_FrameQueueEvent.Lock();
+	m_State = DECODER_QUIT;
+	m_FrameQueueEvent.Broadcast();
+	m_FrameQueueEvent.Unlock();
+
+	m_DecodingThread.Wait();
+
+	for( DecodedFrame &frame : m_FrameQueue )
+		delete frame.pSurface;
+	m_FrameQueue.clear();
+	for( RageSurface *pSurface : m_vpFreeSurfaces )
+		delete pSurface;
+	m_vpFreeSurfaces.clear();
+}
+
+void MovieTexture_Generic::DecodingThread()
+{
+	/* Added to decoder timestamps, so they keep increasing when we loop. */
+	float fTimeOffset = 0;
+	bool bGotFrameSinceRewind = true;
+
+	m_FrameQueueEvent.Lock();
+	while( m_State != DECODER_QUIT )
+	{
+		if( m_bWantRewind )
+		{
+			m_bWantRewind = false;
+			m_bDecoderFinished = false;
+			fTimeOffset = 0;
+			bGotFrameSinceRewind = false;
+
+			m_FrameQueueEvent.Unlock();
+			m_pDecoder->Rewind();
+			m_FrameQueueEvent.Lock();
+			continue;
+		}
+
+		if( m_bDecoderFinished || m_vpFreeSurfaces.empty() )
+		{
+			m_FrameQueueEvent.Wait();
+			continue;
+		}
+
+		RageSurface *pSurface = m_vpFreeSurfaces.back();
+		m_vpFreeSurfaces.pop_back();
+		const int iGeneration = m_iRewindGeneration;
+
+		/* If the clock has run far past what we've decoded, we're short on
+		 * CPU; let the decoder skip frames to catch up. */
+		const float FrameSkipThreshold = 0.5f;
+		float fTargetTime = -1;
+		const float fDecodedUpTo = fTimeOffset + m_pDecoder->GetTimestamp();
+		if( m_fClock - fDecodedUpTo >= FrameSkipThreshold )
+			fTargetTime = m_fClock - fTimeOffset;
+		m_FrameQueueEvent.Unlock();
+
+		int ret = m_pDecoder->DecodeFrame( fTargetTime );
+		if( ret == 1 )
+			m_pDecoder->GetFrame( pSurface );
+		const float fTimestamp = fTimeOffset + m_pDecoder->GetTimestamp();
+
+		/* Loop, unless the file had nothing in it since the last rewind. */
+		bool bLooped = false;
+		if( ret == 0 && m_bLoop && bGotFrameSinceRewind )
+		{
+			/* Continue where the last frame left off. */
+			LOG->Trace( "File \"%s\" looping", GetID().filename.c_str() );
+			fTimeOffset += m_pDecoder->GetTimestamp() + m_pDecoder->GetFrameDuration();
+			bGotFrameSinceRewind = false;
+			bLooped = true;
+			m_pDecoder->Rewind();
+		}
+
+		m_FrameQueueEvent.Lock();
+		if( ret != 1 || iGeneration != m_iRewindGeneration )
+		{
+			/* Error, EOF, or SetPosition was called while we were decoding. */
+			m_vpFreeSurfaces.push_back( pSurface );
+			if( ret == -1 || (ret == 0 && !bLooped) )
+				m_bDecoderFinished = true;
+			continue;
+		}
+
+		bGotFrameSinceRewind = true;
+		DecodedFrame frame;
+		frame.pSurface = pSurface;
+		frame.fTimestamp = fTimestamp;
+		m_FrameQueue.push_back( frame );
+	}
+	m_FrameQueueEvent.Unlock();
+}
+
 static EffectMode EffectModes[] =
 {
 	EffectMode_YUYV422,
+	EffectMode_NV12,
 };
 static_assert( ARRAYLEN(EffectModes) == NUM_PixelFormatYCbCr );
 
@@ -518,6 +795,21 @@ void MovieTexture_Generic::SetPosition( float fSeconds )
 	}
 
 	LOG->Trace( "Seek to %f", fSeconds );
+	if( m_DecodingThread.IsCreated() )
+	{
+		/* Throw away everything decoded from the old position. */
+		m_FrameQueueEvent.Lock();
+		for( DecodedFrame &frame : m_FrameQueue )
+			m_vpFreeSurfaces.push_back( frame.pSurface );
+		m_FrameQueue.clear();
+		m_fClock = 0;
+		m_bWantRewind = true;
+		++m_iRewindGeneration;
+		m_FrameQueueEvent.Signal();
+		m_FrameQueueEvent.Unlock();
+		return;
+	}
+
 	m_bWantRewind = true;
 }
 
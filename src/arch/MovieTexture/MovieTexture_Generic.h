@@ -2,9 +2,13 @@
 #define RAGE_MOVIE_TEXTURE_GENERIC_H
 
 #include "MovieTexture.h"
+#include "RageThreads.h"
 
 #include <cstdint>
+#include <deque>
+#include <vector>
 
+class ActorMultiTexture;
 class FFMpeg_Helper;
 struct RageSurface;
 struct RageTextureLock;
@@ -14,6 +18,10 @@ class Sprite;
 enum MovieDecoderPixelFormatYCbCr
 {
 	PixelFormatYCbCr_YUYV422,
+	/* The luma plane, packed four samples to a texel, followed by the chroma
+	 * plane at half height with U and V interleaved.  The surface is a quarter
+	 * of the frame width, and half again as tall. */
+	PixelFormatYCbCr_NV12,
 	NUM_PixelFormatYCbCr,
 	PixelFormatYCbCr_Invalid
 };
@@ -62,7 +70,8 @@ public:
 	 *
 	 * If DISPLAY supports the EffectMode_YUYV422 blend mode, this may be
 	 * a packed-pixel YUV surface.  UYVY maps to RGBA, respectively.  If
-	 * used, set fmtout.
+	 * EffectMode_NV12 is supported, it may be a PixelFormatYCbCr_NV12 surface,
+	 * which avoids color conversion entirely.  If used, set fmtout.
 	 */
 	virtual RageSurface *CreateCompatibleSurface( int iTextureWidth, int iTextureHeight, bool bPreferHighColor, MovieDecoderPixelFormatYCbCr &fmtout ) = 0;
 
@@ -112,11 +121,34 @@ private:
 
 	enum State { DECODER_QUIT, DECODER_RUNNING } m_State;
 
+	/* When decoding ahead, a thread fills m_FrameQueue with converted frames,
+	 * up to the configured depth, and the main thread only uploads the newest
+	 * frame that's due, dropping any older ones.  Timestamps in the queue
+	 * keep increasing across loops.  m_FrameQueueEvent protects m_State,
+	 * m_bWantRewind, m_fClock and everything below while the thread runs. */
+	struct DecodedFrame
+	{
+		RageSurface *pSurface;
+		float fTimestamp;
+	};
+	RageThread m_DecodingThread;
+	RageEvent m_FrameQueueEvent;
+	std::deque<DecodedFrame> m_FrameQueue;
+	std::vector<RageSurface *> m_vpFreeSurfaces;
+	int m_iRewindGeneration;
+	bool m_bDecoderFinished;
+	int m_iDroppedFrames;
+
 	std::uintptr_t m_uTexHandle;
 	RageTextureRenderTarget *m_pRenderTarget;
 	RageTexture *m_pTextureIntermediate;
 	Sprite *m_pSprite;
 
+	/* NV12 frames are uploaded as two planes, m_pTextureIntermediate holding
+	 * luma and m_pChromaTexture chroma, and drawn together by m_pPlanes. */
+	RageTexture *m_pChromaTexture;
+	ActorMultiTexture *m_pPlanes;
+
 	RageSurface *m_pSurface;
 
 	RageTextureLock *m_pTextureLock;
@@ -126,12 +158,20 @@ private:
 	bool m_bFrameSkipMode;
 
 	void UpdateFrame();
+	void UpdateFrameFromSurface( RageSurface *pFrame );
+	void FinishFrameUpdate( RageSurface *pFrame, bool bUploaded );
+	void UploadPlanes( RageSurface *pFrame );
 
 	void CreateTexture();
 	void DestroyTexture();
 
 	bool DecodeFrame();
 	float CheckFrameTime();
+
+	void StartDecodingThread( int iQueueDepth );
+	void StopDecodingThread();
+	static int DecodingThread_Start( void *pThis ) { ((MovieTexture_Generic *) pThis)->DecodingThread(); return 0; }
+	void DecodingThread();
 };
 
 #endif
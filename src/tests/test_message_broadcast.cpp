@@ -0,0 +1,140 @@
+#include "global.h"
+#include "test_misc.h"
+
+#include "Actor.h"
+#include "ActorFrame.h"
+#include "LuaManager.h"
+#include "MessageManager.h"
+#include "RageLog.h"
+#include "RageTimer.h"
+#include "RageUtil.h"
+
+#include <vector>
+
+/*
+ * Time what each judged note costs in messages, in an actor tree about the
+ * size of Simply Love's gameplay screen: a couple thousand actors, each with a
+ * few ordinary commands, and a few dozen of them listening for the messages a
+ * note sends.  Every handler is an empty Lua function, so what's measured is
+ * the message plumbing and the call into Lua, not theme code.
+ */
+
+static const int FRAMES = 40;			// top-level ActorFrames
+static const int ACTORS_PER_FRAME = 50;
+static const int NOTES = 20000;
+
+struct Listener
+{
+	const char *szMessage;
+	int iSubscribers;
+};
+
+/* Roughly what Simply Love has listening while both players are playing. */
+static const Listener g_Listeners[] =
+{
+	{ "Judgment",		64 },
+	{ "ComboChanged",	24 },
+	{ "LifeChanged",	16 },
+	{ "ScoreChanged",	12 },
+};
+
+static apActorCommands MakeEmptyCommand()
+{
+	Lua *L = LUA->Get();
+	luaL_loadstring( L, "return function(self, params) end" );
+	lua_call( L, 0, 1 );
+	LuaReference *pRef = new LuaReference;
+	pRef->SetFromStack( L );
+	LUA->Release( L );
+	return apActorCommands( pRef );
+}
+
+static ActorFrame *BuildTree()
+{
+	apActorCommands cmd = MakeEmptyCommand();
+	static const char *szCommands[] = { "InitCommand", "OnCommand", "OffCommand", "CurrentSongChangedMessageCommand" };
+
+	ActorFrame *pRoot = new ActorFrameAutoDeleteChildren;
+	std::vector<Actor *> vpAll;
+	for( int i = 0; i < FRAMES; ++i )
+	{
+		ActorFrame *pFrame = new ActorFrameAutoDeleteChildren;
+		pFrame->SetName( ssprintf("Frame%i", i) );
+		pRoot->AddChild( pFrame );
+		vpAll.push_back( pFrame );
+		for( int j = 0; j < ACTORS_PER_FRAME; ++j )
+		{
+			Actor *pActor = new Actor;
+			pActor->SetName( ssprintf("Actor%i", j) );
+			pFrame->AddChild( pActor );
+			vpAll.push_back( pActor );
+		}
+	}
+
+	for( Actor *pActor : vpAll )
+		for( const char *szCommand : szCommands )
+			pActor->AddCommand( szCommand, cmd );
+
+	/* Spread the listeners through the tree, as a theme would. */
+	int iNext = 0;
+	for( const Listener &l : g_Listeners )
+	{
+		for( int i = 0; i < l.iSubscribers; ++i )
+		{
+			iNext = (iNext + 97) % vpAll.size();
+			if( !vpAll[iNext]->HasCommand(l.szMessage) )
+				vpAll[iNext]->AddCommand( RString(l.szMessage) + "MessageCommand", cmd );
+		}
+	}
+
+	printf( "%i actors\n", (int) vpAll.size() + 1 );
+	return pRoot;
+}
+
+static void BroadcastNote( int iNote )
+{
+	for( const Listener &l : g_Listeners )
+	{
+		Message msg( l.szMessage );
+		msg.SetParam( "Player", PLAYER_1 );
+		msg.SetParam( "Note", iNote );
+		MESSAGEMAN->Broadcast( msg );
+	}
+}
+
+/* The same messages with no parameters, to separate the cost of delivery
+ * from the cost of building the parameter table. */
+static void BroadcastNoteNoParams()
+{
+	for( const Listener &l : g_Listeners )
+		MESSAGEMAN->Broadcast( l.szMessage );
+}
+
+int main( int argc, char *argv[] )
+{
+	test_handle_args( argc, argv );
+	test_init();
+
+	LUA = new LuaManager;
+	MESSAGEMAN = new MessageManager;
+
+	ActorFrame *pRoot = BuildTree();
+
+	RageTimer timer;
+	for( int i = 0; i < NOTES; ++i )
+		BroadcastNote( i );
+	float fSeconds = timer.GetDeltaTime();
+	printf( "with params:    %.2f us/note\n", fSeconds * 1000000 / NOTES );
+
+	for( int i = 0; i < NOTES; ++i )
+		BroadcastNoteNoParams();
+	fSeconds = timer.GetDeltaTime();
+	printf( "without params: %.2f us/note\n", fSeconds * 1000000 / NOTES );
+
+	delete pRoot;
+	delete MESSAGEMAN;
+	delete LUA;
+	test_deinit();
+
+	exit(0);
+}
@@ -0,0 +1,123 @@
+#include "global.h"
+#include "RageTimer.h"
+#include "RageUtil.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+/*
+ * Time converting a decoded movie frame into each texture layout that
+ * MovieTexture_FFMpeg can ask for, and report how many bytes each one hands
+ * to the display per frame.  This needs no display or input files; the
+ * frames are synthetic yuv420p, which is what nearly all movies decode to.
+ *
+ * g++ -O2 -I.. -I../archutils/Unix test_movie_conversion.cpp ... -lswscale -lavutil
+ */
+namespace avcodec
+{
+	extern "C"
+	{
+		#include <libavutil/pixdesc.h>
+		#include <libswscale/swscale.h>
+	}
+}
+
+static const int FRAMES = 300;
+
+struct TextureLayout
+{
+	const char *szName;
+	avcodec::AVPixelFormat fmt;
+};
+
+static const TextureLayout g_Layouts[] =
+{
+	{ "BGRA (RGB texture)",		avcodec::AV_PIX_FMT_BGRA },
+	{ "YUYV422 (shader)",		avcodec::AV_PIX_FMT_YUYV422 },
+	{ "NV12 (planes + shader)",	avcodec::AV_PIX_FMT_NV12 },
+};
+
+static void FillSourceFrame( std::vector<std::uint8_t> &buf, std::uint8_t *pData[4], int iLinesize[4], int iWidth, int iHeight, int iFrame )
+{
+	const int iChromaWidth = iWidth / 2, iChromaHeight = iHeight / 2;
+	buf.resize( iWidth*iHeight + 2*iChromaWidth*iChromaHeight );
+
+	pData[0] = &buf[0];
+	pData[1] = pData[0] + iWidth*iHeight;
+	pData[2] = pData[1] + iChromaWidth*iChromaHeight;
+	pData[3] = nullptr;
+	iLinesize[0] = iWidth;
+	iLinesize[1] = iLinesize[2] = iChromaWidth;
+	iLinesize[3] = 0;
+
+	/* A moving gradient, so nothing is trivially constant. */
+	for( int y = 0; y < iHeight; ++y )
+		for( int x = 0; x < iWidth; ++x )
+			pData[0][y*iLinesize[0] + x] = std::uint8_t( 16 + (x + y + iFrame) % 220 );
+	for( int y = 0; y < iChromaHeight; ++y )
+	{
+		for( int x = 0; x < iChromaWidth; ++x )
+		{
+			pData[1][y*iLinesize[1] + x] = std::uint8_t( 128 + (x - iFrame) % 64 );
+			pData[2][y*iLinesize[2] + x] = std::uint8_t( 128 + (y + iFrame) % 64 );
+		}
+	}
+}
+
+static void BenchmarkLayout( const TextureLayout &layout, int iWidth, int iHeight )
+{
+	avcodec::SwsContext *pContext = avcodec::sws_getContext(
+		iWidth, iHeight, avcodec::AV_PIX_FMT_YUV420P,
+		iWidth, iHeight, layout.fmt,
+		SWS_BICUBIC, nullptr, nullptr, nullptr );
+	ASSERT( pContext != nullptr );
+
+	/* Lay the output out the same way MovieDecoder_FFMpeg does: one surface,
+	 * with NV12's chroma plane directly below its luma plane. */
+	const avcodec::AVPixFmtDescriptor *pDesc = avcodec::av_pix_fmt_desc_get( layout.fmt );
+	const int iBytesPerPixel = avcodec::av_get_bits_per_pixel( pDesc ) / 8;
+	int iPitch = iWidth * std::max( iBytesPerPixel, 1 );
+	int iRows = iHeight;
+	if( layout.fmt == avcodec::AV_PIX_FMT_NV12 )
+	{
+		iPitch = iWidth;
+		iRows = iHeight + iHeight/2;
+	}
+	std::vector<std::uint8_t> out( iPitch * iRows );
+
+	std::uint8_t *pDst[4] = { &out[0], nullptr, nullptr, nullptr };
+	int iDstStride[4] = { iPitch, 0, 0, 0 };
+	if( layout.fmt == avcodec::AV_PIX_FMT_NV12 )
+	{
+		pDst[1] = &out[0] + iHeight*iPitch;
+		iDstStride[1] = iPitch;
+	}
+
+	std::vector<std::uint8_t> src;
+	std::uint8_t *pSrc[4];
+	int iSrcStride[4];
+	FillSourceFrame( src, pSrc, iSrcStride, iWidth, iHeight, 0 );
+
+	RageTimer timer;
+	for( int i = 0; i < FRAMES; ++i )
+		avcodec::sws_scale( pContext, pSrc, iSrcStride, 0, iHeight, pDst, iDstStride );
+	const float fSeconds = timer.GetDeltaTime();
+
+	printf( "%ix%i %-24s %6.3f ms/frame, %8i bytes uploaded/frame (%.2f per pixel)\n",
+		iWidth, iHeight, layout.szName, fSeconds * 1000 / FRAMES,
+		(int) out.size(), float(out.size()) / (iWidth*iHeight) );
+
+	avcodec::sws_freeContext( pContext );
+}
+
+int main( int argc, char *argv[] )
+{
+	static const int iSizes[][2] = { { 640, 480 }, { 1280, 720 }, { 1920, 1080 } };
+	for( const int *size : iSizes )
+		for( const TextureLayout &layout : g_Layouts )
+			BenchmarkLayout( layout, size[0], size[1] );
+
+	exit(0);
+}
+
@@ -0,0 +1,87 @@
+#include "global.h"
+#include "test_misc.h"
+
+#include "NoteData.h"
+#include "NoteDataUtil.h"
+#include "RageLog.h"
+#include "RageTimer.h"
+#include "RageUtil.h"
+
+/*
+ * Time decompressing a 20,000 row chart with
+ * NoteDataUtil::LoadFromSMNoteDataString, which happens whenever a chart is
+ * played, edited or has its radar values calculated.  The chart is synthetic
+ * but shaped like a real one: 16th and 24th measures, jumps, mines, holds
+ * and rolls in the last column, keysounds, CRLF line endings and comments.
+ */
+
+static const int ROWS = 20000;
+static const int TRACKS = 4;
+static const int LOADS = 50;
+
+static RString MakeChart()
+{
+	RString sChart;
+	int iRows = 0;
+	for( int m = 0; iRows < ROWS; ++m )
+	{
+		const int iLines = (m % 3 == 2)? 24:16;
+		for( int l = 0; l < iLines; ++l )
+		{
+			char szRow[TRACKS+1] = "0000";
+			const int k = m*16 + l;
+			if( k % 16 == 0 )
+				szRow[3] = (m % 2)? '4':'2';
+			else if( k % 16 == 6 )
+				szRow[3] = '3';
+			szRow[(k*7) % 3] = (k % 11 == 0)? 'M':'1';
+			if( k % 5 == 0 )
+				szRow[(k*7 + 1) % 3] = '1';
+
+			sChart += szRow;
+			if( k % 13 == 0 )
+				sChart += "[3]";
+			sChart += "\r\n";
+			++iRows;
+		}
+		sChart += ssprintf( ",  // measure %i\n", m+1 );
+	}
+	return sChart;
+}
+
+/* Something that changes if any note loads differently, to compare builds. */
+static unsigned GetChecksum( const NoteData &nd )
+{
+	unsigned iSum = 0;
+	for( int t = 0; t < nd.GetNumTracks(); ++t )
+	{
+		for( NoteData::const_iterator it = nd.begin(t); it != nd.end(t); ++it )
+		{
+			const TapNote &tn = it->second;
+			iSum = iSum*31 + it->first*7 + tn.type*3 + tn.subType + tn.iDuration*5 + tn.iKeysoundIndex*11 + t;
+		}
+	}
+	return iSum;
+}
+
+int main( int argc, char *argv[] )
+{
+	test_handle_args( argc, argv );
+	test_init();
+
+	const RString sChart = MakeChart();
+	NoteData nd;
+	nd.SetNumTracks( TRACKS );
+	NoteDataUtil::LoadFromSMNoteDataString( nd, sChart, false );
+	printf( "%i notes, checksum %08x\n", nd.GetNumTapNotes(), GetChecksum(nd) );
+
+	RageTimer timer;
+	for( int i = 0; i < LOADS; ++i )
+		NoteDataUtil::LoadFromSMNoteDataString( nd, sChart, false );
+	float fSeconds = timer.GetDeltaTime();
+	printf( "%.2f ms/load\n", fSeconds * 1000 / LOADS );
+
+	test_deinit();
+
+	exit(0);
+}